@@ -0,0 +1,99 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_Arena_hh__
+#define avro_Arena_hh__
+
+#include <vector>
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+
+#include "Exception.hh"
+
+/// \file Arena.hh
+///
+
+namespace avro {
+
+/// A bump allocator.  Memory is handed out from large blocks by advancing a
+/// pointer, and is never freed individually: reset() makes all of it
+/// available again at once, keeping the blocks so that an arena reused for
+/// one record or one batch after another stops allocating from the heap.
+///
+/// Objects placed in an arena never have their destructors run, so only
+/// types that do not own resources should be stored in it.
+
+class Arena : private boost::noncopyable
+{
+
+  public:
+
+    enum {
+        ALIGNMENT = 8,
+        DEFAULT_BLOCK_SIZE = 8192
+    };
+
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~Arena();
+
+    void *allocate(size_t size) {
+        size = (size + ALIGNMENT - 1) & ~static_cast<size_t>(ALIGNMENT - 1);
+        if(size > static_cast<size_t>(end_ - cursor_)) {
+            return allocateFromNextBlock(size);
+        }
+        void *ptr = cursor_;
+        cursor_ += size;
+        return ptr;
+    }
+
+    /// Throws if count objects would not fit in memory at all, so that a
+    /// count read from hostile data cannot wrap around to a small size.
+    template<typename T>
+    T *allocate(size_t count) {
+        if(count > (static_cast<size_t>(-1) - ALIGNMENT) / sizeof(T)) {
+            throw Exception(boost::format("Cannot allocate %1% objects of %2% bytes") % count % sizeof(T));
+        }
+        return static_cast<T *>(allocate(count * sizeof(T)));
+    }
+
+    /// Releases everything allocated from the arena.
+    void reset();
+
+    /// The number of bytes of heap memory held by the arena.
+    size_t capacity() const;
+
+  private:
+
+    void *allocateFromNextBlock(size_t size);
+
+    struct Block {
+        uint8_t *data;
+        size_t size;
+    };
+
+    const size_t blockSize_;
+    std::vector<Block> blocks_;
+    size_t current_;
+    uint8_t *cursor_;
+    uint8_t *end_;
+};
+
+} // namespace avro
+
+#endif
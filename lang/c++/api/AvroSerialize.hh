@@ -50,7 +50,7 @@ void serialize(Writer &s, const T& val, const boost::false_type &)
 // @{
 
 template <typename Writer, typename T>
-void serialize(Writer &s, T val, const boost::true_type &) {
+void serialize(Writer &s, const T &val, const boost::true_type &) {
     s.writeValue(val);
 }
 
@@ -0,0 +1,101 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_AvroSize_hh__
+#define avro_AvroSize_hh__
+
+#include <string>
+#include <vector>
+#include <boost/static_assert.hpp>
+
+#include "AvroTraits.hh"
+#include "Zigzag.hh"
+#include "View.hh"
+
+/// \file
+///
+/// Standalone functions giving the exact length of the binary encoding of
+/// Avro types, so that a buffer can be sized before anything is written to
+/// it.  Generated types define their own encodedSize() overloads.
+
+namespace avro {
+
+// @{
+
+/// The implementations for the types that are serializable natively.  They
+/// come first, since no argument dependent lookup finds them later.
+
+inline size_t encodedSize(const Null &, const boost::true_type &) {
+    return 0;
+}
+
+inline size_t encodedSize(const bool &, const boost::true_type &) {
+    return 1;
+}
+
+inline size_t encodedSize(const int32_t &val, const boost::true_type &) {
+    return encodedInt32Size(val);
+}
+
+inline size_t encodedSize(const int64_t &val, const boost::true_type &) {
+    return encodedInt64Size(val);
+}
+
+inline size_t encodedSize(const float &, const boost::true_type &) {
+    return 4;
+}
+
+inline size_t encodedSize(const double &, const boost::true_type &) {
+    return 8;
+}
+
+inline size_t encodedSize(const std::string &val, const boost::true_type &) {
+    return encodedInt64Size(val.size()) + val.size();
+}
+
+inline size_t encodedSize(const std::vector<uint8_t> &val, const boost::true_type &) {
+    return encodedInt64Size(val.size()) + val.size();
+}
+
+inline size_t encodedSize(const View &val, const boost::true_type &) {
+    return encodedInt64Size(val.size) + val.size;
+}
+
+// @}
+
+/// Type trait should be set to is_serializable in otherwise force the compiler to complain.
+
+template <typename T>
+size_t encodedSize(const T &val, const boost::false_type &)
+{
+    BOOST_STATIC_ASSERT(sizeof(T)==0);
+    return 0;
+}
+
+/// The main entry point.  Returns the number of bytes a Writer writes for val.
+
+template <typename T>
+size_t encodedSize(const T &val)
+{
+    return encodedSize(val, is_serializable<T>());
+}
+
+} // namespace avro
+
+#endif
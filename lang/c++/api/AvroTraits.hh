@@ -64,6 +64,40 @@ DEFINE_PRIMITIVE(Null, AVRO_NULL)
 DEFINE_PRIMITIVE(std::string, AVRO_STRING)
 DEFINE_PRIMITIVE(std::vector<uint8_t>, AVRO_BYTES)
 
+/// What is known at compile time about the binary encoding of a type.
+/// fieldCount is the number of fields of a record.  isBounded says that no
+/// value encodes to more than maxEncodedSize bytes, and isFixedSize that
+/// every value encodes to exactly that many.  Types generated by
+/// generateCppCode() specialize it; everything else is unbounded.
+
+template <typename T>
+struct schema_traits {
+    enum {
+        fieldCount = 0,
+        isFixedSize = 0,
+        isBounded = 0,
+        maxEncodedSize = 0
+    };
+};
+
+#define DEFINE_SCHEMA_TRAITS(CTYPE, FIXED, MAXSIZE) \
+template <> \
+struct schema_traits<CTYPE> { \
+    enum { \
+        fieldCount = 0, \
+        isFixedSize = FIXED, \
+        isBounded = 1, \
+        maxEncodedSize = MAXSIZE \
+    }; \
+};
+
+DEFINE_SCHEMA_TRAITS(Null, 1, 0)
+DEFINE_SCHEMA_TRAITS(bool, 1, 1)
+DEFINE_SCHEMA_TRAITS(int32_t, 0, 5)
+DEFINE_SCHEMA_TRAITS(int64_t, 0, 10)
+DEFINE_SCHEMA_TRAITS(float, 1, 4)
+DEFINE_SCHEMA_TRAITS(double, 1, 8)
+
 
 } // namespace avro
 
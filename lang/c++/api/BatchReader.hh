@@ -0,0 +1,102 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_BatchReader_hh__
+#define avro_BatchReader_hh__
+
+#include <vector>
+#include <stdint.h>
+
+#include "InputStreamer.hh"
+#include "ResolvingReader.hh"
+
+/// \file BatchReader.hh
+///
+/// Parsing a block of records, such as a block of a container file, on
+/// several threads at once.  The records must first be indexed, so that the
+/// block can be split where records start.
+
+namespace avro {
+
+class ValidSchema;
+
+/// The index pass: appends the offset of each record, written with the
+/// writer's schema, in the block of memory to offsets.
+void indexRecords(const ValidSchema &writer, const uint8_t *data, size_t size, std::vector<size_t> &offsets);
+
+/// Parses a consecutive range of records of a block, [begin, end) in its
+/// index.  Run by each of the threads of parallelParseBatch().
+class BatchTask 
+{
+  public:
+
+    virtual void run(size_t begin, size_t end) const = 0;
+    virtual ~BatchTask() {}
+};
+
+/// Splits count records into one range for each of the threads, and runs the
+/// task on them; the calling thread parses the last range.  Throws the first
+/// exception thrown by any of the ranges once all have finished.
+void runBatchTask(const BatchTask &task, size_t count, size_t threads);
+
+template<typename T>
+class ParseBatchTask : public BatchTask
+{
+  public:
+
+    ParseBatchTask(const ResolverSchema &schema, const uint8_t *data, size_t size, 
+                   const std::vector<size_t> &offsets, T *objects) :
+        schema_(schema),
+        data_(data),
+        size_(size),
+        offsets_(offsets),
+        objects_(objects)
+    {}
+
+    void run(size_t begin, size_t end) const {
+        size_t first = offsets_[begin];
+        size_t last = (end < offsets_.size()) ? offsets_[end] : size_;
+        MemoryStreamer in(data_ + first, last - first);
+        ResolvingReader reader(schema_, in);
+        reader.parseBatch(objects_ + begin, end - begin);
+    }
+
+  private:
+
+    const ResolverSchema &schema_;
+    const uint8_t *data_;
+    size_t size_;
+    const std::vector<size_t> &offsets_;
+    T *objects_;
+};
+
+/// Parses the records of a block of memory, at the offsets found by
+/// indexRecords(), into objects on the given number of threads.  The
+/// compiled resolver is shared by all of them.
+template<typename T>
+void parallelParseBatch(const ResolverSchema &schema, const uint8_t *data, size_t size,
+                        const std::vector<size_t> &offsets, T *objects, size_t threads)
+{
+    ParseBatchTask<T> task(schema, data, size, offsets, objects);
+    runBatchTask(task, offsets.size(), threads);
+}
+
+} // namespace avro
+
+#endif
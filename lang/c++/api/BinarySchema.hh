@@ -0,0 +1,72 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_BinarySchema_hh__
+#define avro_BinarySchema_hh__
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+
+/// \file BinarySchema.hh
+///
+/// A compact binary form of a compiled schema, for programs that would
+/// otherwise compile the same JSON schemas every time they start.  It holds
+/// the nodes of the schema, as ValidSchema left them, and is loaded without
+/// any JSON parsing.
+///
+/// The format is the four bytes "AVSB", a version byte, the root node, and
+/// the CRC-64-AVRO checksum of everything before it (8 bytes, little
+/// endian).  A node is its type as one byte followed by, depending on the
+/// type:
+///
+///   - record: name, number of fields, and the name and node of each field
+///   - enum: name, number of symbols, and the symbols
+///   - fixed: name and size
+///   - array: the items node
+///   - map: the values node
+///   - union: number of branches, and the branch nodes
+///   - symbolic link: the name of the type it refers to
+///
+/// Counts and sizes are avro longs (zigzag varints) and names are avro
+/// strings (a long length, then the bytes).
+
+namespace avro {
+
+class ValidSchema;
+
+/// The version written by writeBinarySchema, the only one that can be read.
+const uint8_t BINARY_SCHEMA_VERSION = 1;
+
+/// Appends the binary form of the schema to the buffer.
+void writeBinarySchema(const ValidSchema &schema, std::vector<uint8_t> &buffer);
+
+void writeBinarySchema(const ValidSchema &schema, std::ostream &os);
+
+/// Loads a schema written by writeBinarySchema.  Throws if the data is not
+/// a binary schema of this version, fails its checksum, or nests its types
+/// more than 256 levels deep.
+void readBinarySchema(const uint8_t *data, size_t len, ValidSchema &schema);
+
+/// Reads the rest of the stream in one go and loads the schema from it.
+void readBinarySchema(std::istream &is, ValidSchema &schema);
+
+} // namespace avro
+
+#endif
@@ -0,0 +1,46 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_CodeGenerator_hh__
+#define avro_CodeGenerator_hh__
+
+#include <iostream>
+#include <string>
+
+/// \file CodeGenerator.hh
+///
+/// Generates C++ types for a schema from its compiled form, without the
+/// precompile and gen-cppcode.py round trip.  The header it writes has the
+/// structs, serialize(), parse() and encodedSize() functions and Layouts
+/// that gen-cppcode.py writes with its default options, and a
+/// schema_traits specialization (see AvroTraits.hh) for every type, so code
+/// can choose how to handle a type at compile time.  A record whose
+/// encoding always has the same size gets an encodedSize() that returns
+/// the constant.
+
+namespace avro {
+
+class ValidSchema;
+
+/// Writes the header for the types of the schema, in namespace ns.
+void generateCppCode(const ValidSchema &schema, const std::string &ns, std::ostream &os);
+
+} // namespace avro
+
+#endif
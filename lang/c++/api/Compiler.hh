@@ -105,6 +105,21 @@ void compileJsonSchema(std::istream &is, ValidSchema &schema);
 
 bool compileJsonSchema(std::istream &is, ValidSchema &schema, std::string &error);
 
+/// Compiles a JSON schema held in memory to a ValidSchema object.  This does
+/// not use the flex/bison parser: the schema is compiled in one pass by a
+/// recursive descent compiler with no global state, so it is safe to call
+/// from several threads at once.  Throws if the schema cannot be compiled
+/// to a valid schema.
+
+void compileJsonSchema(const char *data, size_t len, ValidSchema &schema);
+
+/// Non-throwing version of the in-memory compileJsonSchema.
+///
+/// \return True if no error, false if error (with the error string set)
+///
+
+bool compileJsonSchema(const char *data, size_t len, ValidSchema &schema, std::string &error);
+
 } // namespace avro
 
 #endif
@@ -0,0 +1,51 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_Fingerprint_hh__
+#define avro_Fingerprint_hh__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <boost/array.hpp>
+
+/// \file Fingerprint.hh
+///
+/// The fingerprint functions the avro specification defines for identifying a
+/// schema by the bytes of its Parsing Canonical Form (see
+/// ValidSchema::toCanonicalJson).  Usually there is no need to call these
+/// directly, since a ValidSchema computes its fingerprints once, when it is
+/// set.
+
+namespace avro {
+
+/// The fingerprint of an empty string, which also defines the polynomial of
+/// the CRC-64-AVRO fingerprint.
+const uint64_t CRC64_AVRO_EMPTY = 0xc15d213aa4d7a795ULL;
+
+/// Returns the 64 bit Rabin fingerprint (CRC-64-AVRO) of the data.
+uint64_t crc64Avro(const void *data, size_t size);
+
+typedef boost::array<uint8_t, 32> Sha256Digest;
+
+/// Returns the SHA-256 digest of the data.
+Sha256Digest sha256(const void *data, size_t size);
+
+} // namespace avro
+
+#endif
@@ -0,0 +1,302 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_GenericValue_hh__
+#define avro_GenericValue_hh__
+
+#include <string>
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+
+#include "Exception.hh"
+#include "Types.hh"
+#include "Node.hh"
+#include "Arena.hh"
+#include "Reader.hh"
+#include "AvroTraits.hh"
+
+/// \file GenericValue.hh
+///
+
+namespace avro {
+
+class ValidSchema;
+class InputStreamer;
+
+/// A value of any avro type, for data whose schema is only known at run time.
+///
+/// GenericValues are decoded by a GenericReader into an Arena: the values,
+/// their strings, bytes and the storage of their records, arrays and maps
+/// all live in the arena and are released together when it is reset.  A
+/// GenericValue refers to the schema node it was decoded with, so the
+/// ValidSchema must outlive it as well.
+///
+/// Accessing a value as a type it does not have throws.
+
+class GenericValue
+{
+
+  public:
+
+    Type type() const {
+        return type_;
+    }
+
+    /// The schema node of this value (never symbolic).
+    const Node &node() const {
+        return *node_;
+    }
+
+    bool boolValue() const {
+        check(AVRO_BOOL);
+        return value_.boolValue;
+    }
+
+    int32_t intValue() const {
+        check(AVRO_INT);
+        return value_.intValue;
+    }
+
+    int64_t longValue() const {
+        check(AVRO_LONG);
+        return value_.longValue;
+    }
+
+    float floatValue() const {
+        check(AVRO_FLOAT);
+        return value_.floatValue;
+    }
+
+    double doubleValue() const {
+        check(AVRO_DOUBLE);
+        return value_.doubleValue;
+    }
+
+    /// The bytes of a string, bytes or fixed value.  Strings are not null
+    /// terminated.
+    const uint8_t *data() const {
+        checkBytes();
+        return value_.bytes.data;
+    }
+
+    size_t size() const;
+
+    std::string stringValue() const {
+        check(AVRO_STRING);
+        return std::string(reinterpret_cast<const char *>(value_.bytes.data), value_.bytes.size);
+    }
+
+    /// The index of the symbol of an enum.
+    size_t symbol() const {
+        check(AVRO_ENUM);
+        return value_.index;
+    }
+
+    const std::string &symbolName() const {
+        return node_->nameAt(symbol());
+    }
+
+    /// The branch chosen by a union, and its value.
+    size_t branch() const {
+        check(AVRO_UNION);
+        return value_.branch.index;
+    }
+
+    const GenericValue &branchValue() const {
+        check(AVRO_UNION);
+        return *value_.branch.value;
+    }
+
+    /// The fields of a record, or the items of an array.
+    const GenericValue &at(size_t index) const;
+
+    /// The field of a record with the given name, throws if there is none.
+    const GenericValue &field(const std::string &name) const;
+
+    /// The entries of a map.
+    const GenericValue &keyAt(size_t index) const;
+    const GenericValue &valueAt(size_t index) const;
+
+  private:
+
+    friend class GenericReader;
+
+    void check(Type type) const {
+        if(type_ != type) {
+            throw Exception(boost::format("Generic value is %1%, not %2%") % type_ % type);
+        }
+    }
+
+    void checkEntry(size_t index) const;
+
+    void checkBytes() const {
+        if(type_ != AVRO_STRING && type_ != AVRO_BYTES && type_ != AVRO_FIXED) {
+            throw Exception(boost::format("Generic value of type %1% has no bytes") % type_);
+        }
+    }
+
+    Type type_;
+    const Node *node_;
+
+    union {
+        bool boolValue;
+        int32_t intValue;
+        int64_t longValue;
+        float floatValue;
+        double doubleValue;
+        size_t index;
+        struct {
+            const uint8_t *data;
+            size_t size;
+        } bytes;
+        struct {
+            size_t index;
+            GenericValue *value;
+        } branch;
+        struct {
+            GenericValue *values;
+            size_t size;
+        } items;
+        struct {
+            GenericValue *keys;
+            GenericValue *values;
+            size_t size;
+        } map;
+    } value_;
+};
+
+/// Decodes data of a schema known only at run time into GenericValues.
+/// 
+/// The reader walks the schema the way a ValidatingReader's validator does,
+/// but as it always knows which type comes next it reads without checking.
+
+class GenericReader : private boost::noncopyable
+{
+
+  public:
+
+    GenericReader(const ValidSchema &schema, InputStreamer &in);
+
+    /// Decodes the next datum, all of its storage is taken from the arena.
+    const GenericValue &read(Arena &arena);
+
+  private:
+
+    void decode(const NodePtr &node, GenericValue &value, Arena &arena);
+    void decodeItems(const NodePtr &node, GenericValue &value, Arena &arena);
+    void decodeMap(const NodePtr &node, GenericValue &value, Arena &arena);
+    void decodeBytes(GenericValue &value, Arena &arena);
+    size_t blockCount(int64_t count, bool itemsTakeBytes);
+
+    const NodePtr root_;
+    InputStreamer &in_;
+    Reader reader_;
+};
+
+template <>
+struct is_serializable<GenericValue> : public boost::true_type{};
+
+/// Writes a GenericValue, through a Writer or a ValidatingWriter.
+
+template <typename Writer>
+void serialize(Writer &s, const GenericValue &val, const boost::true_type &)
+{
+    switch(val.type()) {
+
+      case AVRO_STRING:
+        s.writeValue(View(val.data(), val.size()));
+        break;
+
+      case AVRO_BYTES:
+        s.writeBytes(val.data(), val.size());
+        break;
+
+      case AVRO_INT:
+        s.writeValue(val.intValue());
+        break;
+
+      case AVRO_LONG:
+        s.writeValue(val.longValue());
+        break;
+
+      case AVRO_FLOAT:
+        s.writeValue(val.floatValue());
+        break;
+
+      case AVRO_DOUBLE:
+        s.writeValue(val.doubleValue());
+        break;
+
+      case AVRO_BOOL:
+        s.writeValue(val.boolValue());
+        break;
+
+      case AVRO_NULL:
+        s.writeValue(Null());
+        break;
+
+      case AVRO_RECORD:
+        s.writeRecord();
+        for(size_t i = 0; i < val.size(); ++i) {
+            serialize(s, val.at(i), boost::true_type());
+        }
+        break;
+
+      case AVRO_ENUM:
+        s.writeEnum(val.symbol());
+        break;
+
+      case AVRO_ARRAY:
+        if(val.size()) {
+            s.writeArrayBlock(val.size());
+            for(size_t i = 0; i < val.size(); ++i) {
+                serialize(s, val.at(i), boost::true_type());
+            }
+        }
+        s.writeArrayEnd();
+        break;
+
+      case AVRO_MAP:
+        if(val.size()) {
+            s.writeMapBlock(val.size());
+            for(size_t i = 0; i < val.size(); ++i) {
+                serialize(s, val.keyAt(i), boost::true_type());
+                serialize(s, val.valueAt(i), boost::true_type());
+            }
+        }
+        s.writeMapEnd();
+        break;
+
+      case AVRO_UNION:
+        s.writeUnion(val.branch());
+        serialize(s, val.branchValue(), boost::true_type());
+        break;
+
+      case AVRO_FIXED:
+        s.writeFixed(val.data(), val.size());
+        break;
+
+      default:
+        throw Exception(boost::format("Cannot serialize generic value of type %1%") % val.type());
+    }
+}
+
+} // namespace avro
+
+#endif
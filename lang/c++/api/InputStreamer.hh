@@ -20,8 +20,11 @@
 #define avro_InputStreamer_hh__
 
 #include <iostream>
+#include <string.h>
 #include <stdint.h>
 
+#include "Exception.hh"
+
 namespace avro {
 
 ///
@@ -44,6 +47,27 @@ class InputStreamer {
     virtual size_t readWord(uint32_t &word) = 0;
     virtual size_t readLongWord(uint64_t &word) = 0;
     virtual size_t readBytes(void *bytes, size_t size) = 0;
+
+    /// Reads at least one and at most size bytes, as many as the streamer
+    /// has at hand, and returns how many it read: 0 at the end of the input.
+    /// For readers that buffer their input, such as the JsonReader.
+    virtual size_t readSome(void *bytes, size_t size) {
+        return size ? readByte(*static_cast<uint8_t *>(bytes)) : 0;
+    }
+
+    /// Returns the next size bytes where they already lie in memory, and
+    /// moves past them.  Streamers that do not hold their input contiguously
+    /// return 0 and read nothing.
+    virtual const uint8_t *readInPlace(size_t size) {
+        return 0;
+    }
+
+    /// The number of bytes left to read, for streamers that know it, so
+    /// that lengths and counts read from the data can be checked against
+    /// it.  Others return the largest size_t.
+    virtual size_t remaining() const {
+        return static_cast<size_t>(-1);
+    }
 };
 
 
@@ -84,11 +108,97 @@ class IStreamer : public InputStreamer {
         return is_.gcount();
     }
 
+    // waits for the first byte only, then takes what the stream has buffered
+    size_t readSome(void *bytes, size_t size) {
+        char *chars = reinterpret_cast<char *>(bytes);
+        if(size == 0 || !is_.get(chars[0])) {
+            return 0;
+        }
+        return 1 + is_.readsome(chars + 1, size - 1);
+    }
+
   private:
 
     std::istream &is_;
 };
 
+///
+/// An implementation of InputStreamer that reads from a block of memory, for
+/// example a block of a container file or a buffer that has been mapped.  It
+/// does not copy the memory, which must outlive it.  Reading past the end of
+/// the block throws.
+///
+
+class MemoryStreamer : public InputStreamer {
+
+  public:
+
+    MemoryStreamer(const uint8_t *data, size_t size) :
+        data_(data),
+        next_(data),
+        end_(data + size)
+    {}
+
+    size_t readByte(uint8_t &byte) {
+        check(1);
+        byte = *next_++;
+        return 1;
+    }
+
+    size_t readWord(uint32_t &word) {
+        return readBytes(&word, sizeof(word));
+    }
+
+    size_t readLongWord(uint64_t &word) {
+        return readBytes(&word, sizeof(word));
+    }
+
+    size_t readBytes(void *bytes, size_t size) {
+        check(size);
+        memcpy(bytes, next_, size);
+        next_ += size;
+        return size;
+    }
+
+    size_t readSome(void *bytes, size_t size) {
+        if(size > remaining()) {
+            size = remaining();
+        }
+        memcpy(bytes, next_, size);
+        next_ += size;
+        return size;
+    }
+
+    const uint8_t *readInPlace(size_t size) {
+        check(size);
+        const uint8_t *bytes = next_;
+        next_ += size;
+        return bytes;
+    }
+
+    /// The number of bytes read so far.
+    size_t position() const {
+        return next_ - data_;
+    }
+
+    size_t remaining() const {
+        return end_ - next_;
+    }
+
+  private:
+
+    void check(size_t size) const {
+        if(size > static_cast<size_t>(end_ - next_)) {
+            throw Exception(boost::format("Cannot read %1% bytes, only %2% remain in memory block") 
+                % size % (end_ - next_));
+        }
+    }
+
+    const uint8_t *data_;
+    const uint8_t *next_;
+    const uint8_t *end_;
+};
+
 } // namespace avro
 
 #endif
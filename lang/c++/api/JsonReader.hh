@@ -0,0 +1,154 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_JsonReader_hh__
+#define avro_JsonReader_hh__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/array.hpp>
+
+#include "Boost.hh"
+#include "Types.hh"
+#include "Exception.hh"
+#include "Validator.hh"
+#include "InputStreamer.hh"
+
+namespace avro {
+
+class ValidSchema;
+
+/// Reads data in the avro JSON encoding, as written by the JsonWriter.  It
+/// has the same interface as the ValidatingReader, so that it may be used with
+/// a Parser and with the parse functions of generated code, and like it
+/// checks that what is read is of the type the schema expects next.
+///
+/// The JSON is tokenized from a buffer the reader fills a block at a time
+/// with InputStreamer::readSome(), so it reads ahead of the datum it is
+/// returning: once a streamer is given to a JsonReader, nothing else should
+/// read from it.  The fields of a record must be in the order of the schema.
+/// Arrays and maps are returned as blocks of one item each.
+
+class JsonReader : private boost::noncopyable
+{
+
+  public:
+
+    JsonReader(const ValidSchema &schema, InputStreamer &in);
+
+    void readValue(Null &);
+    void readValue(bool &val);
+    void readValue(int32_t &val);
+    void readValue(int64_t &val);
+    void readValue(float &val);
+    void readValue(double &val);
+    void readValue(std::string &val);
+
+    void readBytes(std::vector<uint8_t> &val);
+
+    void readFixed(uint8_t *val, size_t size);
+
+    template <size_t N>
+    void readFixed(uint8_t (&val)[N]) {
+        readFixed(val, N);
+    }
+
+    template<size_t N>
+    void readFixed(boost::array<uint8_t, N> &val) {
+        readFixed(val.c_array(), N);
+    }
+
+    void readRecord();
+
+    int64_t readArrayBlockSize();
+
+    int64_t readUnion();
+
+    int64_t readEnum();
+
+    int64_t readMapBlockSize();
+
+  private:
+
+    typedef ValidationTable::Entry Entry;
+
+    struct Frame {
+        size_t entry;
+        size_t pos;         ///< fields begun
+        int64_t remaining;  ///< items left in the block, or the union's branch
+        bool key;           ///< a map's key is next
+        bool wrapped;       ///< a union's value is wrapped in an object
+    };
+
+    size_t beginValue(Type type);
+    void endValue();
+    int64_t nextBlock(Type type, char open, char close);
+
+    bool fill() {
+        size_t size = in_.readSome(buffer_.c_array(), buffer_.size());
+        next_ = buffer_.data();
+        end_ = next_ + size;
+        return size != 0;
+    }
+
+    uint8_t get() {
+        if(next_ == end_ && !fill()) {
+            throw Exception("Unexpected end of JSON");
+        }
+        return *next_++;
+    }
+
+    uint8_t peek() {
+        // at the end of the input there is nothing to see
+        if(next_ == end_ && !fill()) {
+            return 0;
+        }
+        return *next_;
+    }
+
+    uint8_t nextToken();
+    uint8_t peekToken();
+    void expect(char c);
+    void expectLiteral(const char *literal);
+
+    void readString(std::string &val);
+    void readByteString(std::vector<uint8_t> &val);
+    int64_t readInteger(int64_t min, int64_t max);
+    double readNumber();
+    uint32_t readHex();
+
+    const boost::shared_ptr<const ValidationTable> table_;
+    std::vector<Frame> stack_;
+
+    InputStreamer &in_;
+    boost::array<uint8_t, 4096> buffer_;
+    const uint8_t *next_;
+    const uint8_t *end_;
+
+    // reused for field names, symbols and byte strings
+    std::string scratch_;
+    std::vector<uint8_t> scratchBytes_;
+};
+
+} // namespace avro
+
+#endif
@@ -0,0 +1,145 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_JsonWriter_hh__
+#define avro_JsonWriter_hh__
+
+#include <vector>
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/array.hpp>
+
+#include "Boost.hh"
+#include "Types.hh"
+#include "Validator.hh"
+#include "View.hh"
+
+namespace avro {
+
+class ValidSchema;
+class OutputStreamer;
+
+/// Writes data in the avro JSON encoding.  It has the same interface as the
+/// ValidatingWriter, so that it may be used with a Serializer and with the
+/// serialize functions of generated code, and like it checks that what is
+/// written follows the schema, which it needs to know the names of record
+/// fields and enum symbols and where records, arrays and maps end.
+///
+/// Records and maps are written as JSON objects and arrays as JSON arrays,
+/// bytes and fixed as strings of the characters U+0000 to U+00FF, enums as
+/// their symbol, and unions either as null or as an object whose only member
+/// is named by the type of the branch.  Floats and doubles that are not
+/// finite are written as the strings "NaN", "Infinity" and "-Infinity".
+///
+/// Output is buffered, and flushed at the end of each datum, each of which is
+/// followed by a newline.
+
+class JsonWriter : private boost::noncopyable
+{
+
+  public:
+
+    JsonWriter(const ValidSchema &schema, OutputStreamer &out);
+    ~JsonWriter();
+
+    void writeValue(const Null &);
+    void writeValue(bool val);
+    void writeValue(int32_t val);
+    void writeValue(int64_t val);
+    void writeValue(float val);
+    void writeValue(double val);
+    void writeValue(const std::string &val);
+    void writeValue(const View &val);
+
+    void writeBytes(const void *val, size_t size);
+
+    void writeFixed(const uint8_t *val, size_t size);
+
+    template <size_t N>
+    void writeFixed(const uint8_t (&val)[N]) {
+        writeFixed(val, N);
+    }
+
+    template <size_t N>
+    void writeFixed(const boost::array<uint8_t, N> &val) {
+        writeFixed(val.data(), N);
+    }
+
+    void writeRecord();
+
+    void writeArrayBlock(int64_t size);
+    void writeArrayEnd();
+
+    void writeMapBlock(int64_t size);
+    void writeMapEnd();
+
+    void writeUnion(int64_t choice);
+
+    void writeEnum(int64_t choice);
+
+    /// Writes out what is buffered of an incomplete datum.
+    void flush();
+
+  private:
+
+    typedef ValidationTable::Entry Entry;
+
+    struct Frame {
+        size_t entry;
+        size_t pos;         ///< fields, items or entries begun
+        int64_t remaining;  ///< items left in the block, or the union's branch
+        bool key;           ///< a map's key is next
+        bool wrapped;       ///< a union's value is wrapped in an object
+    };
+
+    size_t beginValue(Type type);
+    void endValue();
+    void beginBlock(Type type, int64_t size);
+    void endBlocks(Type type, char close);
+
+    void writeLong(int64_t val);
+    void writeDouble(double val, int precision);
+    void writeString(const char *val, size_t size);
+    void writeString(const std::string &val) {
+        writeString(val.c_str(), val.size());
+    }
+    void writeByteString(const uint8_t *val, size_t size);
+    void writeEscaped(uint8_t c);
+
+    void put(char c) {
+        if(used_ == sizeof(buffer_)) {
+            flush();
+        }
+        buffer_[used_++] = c;
+    }
+
+    void put(const char *chars, size_t size);
+
+    const boost::shared_ptr<const ValidationTable> table_;
+    std::vector<Frame> stack_;
+
+    OutputStreamer &out_;
+    char buffer_[4096];
+    size_t used_;
+};
+
+} // namespace avro
+
+#endif
@@ -20,6 +20,8 @@
 #ifndef avro_Layout_hh__
 #define avro_Layout_hh__
 
+#include <string>
+#include <stdint.h>
 #include <boost/noncopyable.hpp>
 #include "Boost.hh"
 
@@ -58,6 +60,38 @@ class PrimitiveLayout : public Layout {
     {}
 };
 
+typedef uint8_t *(*GenericArraySetter)(uint8_t *array);
+typedef uint8_t *(*GenericMapSetter)(uint8_t *map, const std::string &key);
+typedef uint8_t *(*GenericUnionSetter)(uint8_t *u, int64_t choice);
+
+/// Holds the function a resolver calls to make room for a new value in an
+/// array, map or union of a generated type, and to get the value's address.
+/// The generated layout of each such type adds one, pointing to a static
+/// function of the type, so that the objects themselves carry no pointer.
+
+template <typename Setter>
+class SetterLayout : public Layout {
+
+  public:
+
+    explicit SetterLayout(Setter setter) :
+        Layout(),
+        setter_(setter)
+    {}
+
+    Setter setter() const {
+        return setter_;
+    }
+
+  private:
+
+    const Setter setter_;
+};
+
+typedef SetterLayout<GenericArraySetter> ArraySetterLayout;
+typedef SetterLayout<GenericMapSetter>   MapSetterLayout;
+typedef SetterLayout<GenericUnionSetter> UnionSetterLayout;
+
 class CompoundLayout : public Layout {
 
   public:
@@ -74,6 +108,10 @@ class CompoundLayout : public Layout {
         return layouts_.at(idx);
     }
 
+    size_t size() const {
+        return layouts_.size();
+    }
+
   private:
 
     boost::ptr_vector<Layout> layouts_;
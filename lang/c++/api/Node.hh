@@ -65,7 +65,10 @@ class Node : private boost::noncopyable
     }
 
     void lock() {
-        locked_ = true;
+        if(!locked_) {
+            locked_ = true;
+            doLock();
+        }
     }
 
     bool locked() const {
@@ -109,14 +112,22 @@ class Node : private boost::noncopyable
 
     virtual void printJson(std::ostream &os, int depth) const = 0;
 
+    /// Prints the schema in Parsing Canonical Form: only the attributes that
+    /// affect parsing, in the specification's order, without whitespace.
+    virtual void printCanonicalJson(std::ostream &os) const = 0;
+
     virtual void printBasicInfo(std::ostream &os) const = 0;
 
   protected:
 
     friend class ValidSchema;
+    friend class NodeInterner;
 
     virtual void setLeafToSymbolic(int index, const NodePtr &node) = 0;
 
+    /// Replaces a leaf of a locked node with an identical one.
+    virtual void replaceLeaf(int index, const NodePtr &node) = 0;
+
     void checkLock() const {
         if(locked()) {
             throw Exception("Cannot modify locked schema");
@@ -130,6 +141,10 @@ class Node : private boost::noncopyable
     virtual void doAddName(const std::string &name) = 0;
     virtual void doSetFixedSize(int size) = 0;
 
+    /// Called once, when the node is locked, to freeze what can only change
+    /// while the node is built.
+    virtual void doLock() = 0;
+
   private:
 
     const Type type_;
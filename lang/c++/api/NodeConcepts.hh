@@ -21,6 +21,8 @@
 
 #include <vector>
 #include <map>
+#include <string>
+#include <stdint.h>
 #include "Exception.hh"
 
 namespace avro {
@@ -179,14 +181,39 @@ struct NameIndexConcept {
         throw Exception("Name index does not exist");
         return false;
     }
+
+    void freeze() 
+    { }
 };
 
+/// While a node is built its names are kept in a map, which finds
+/// duplicates as they are added.  Once the node is locked the names cannot
+/// change, and freeze() moves them into an open addressing hash table, so
+/// that a lookup hashes the name once and compares it with (usually) one
+/// candidate in contiguous memory.
+
 template<>
 struct NameIndexConcept < MultiAttribute<std::string> > 
 {
     typedef std::map<std::string, size_t> IndexMap;
 
+    NameIndexConcept() :
+        mask_(0)
+    { }
+
     bool lookup(const std::string &name, size_t &index) const {
+        if(!slots_.empty()) {
+            uint32_t h = hash(name);
+            for(size_t i = h & mask_; slots_[i].index; i = (i + 1) & mask_) {
+                const Slot &slot = slots_[i];
+                if(slot.hash == h && names_[slot.index - 1] == name) {
+                    index = slot.index - 1;
+                    return true;
+                }
+            }
+            return false;
+        }
+
         IndexMap::const_iterator iter = map_.find(name); 
         if(iter == map_.end()) {
             return false;
@@ -205,9 +232,57 @@ struct NameIndexConcept < MultiAttribute<std::string> >
         return added;
     }
 
+    void freeze() {
+        if(map_.empty() || !slots_.empty()) {
+            return;
+        }
+
+        // at most half full, so probe sequences stay short
+        size_t capacity = 4;
+        while(capacity < map_.size() * 2) {
+            capacity <<= 1;
+        }
+        slots_.resize(capacity);
+        mask_ = capacity - 1;
+        names_.resize(map_.size());
+
+        for(IndexMap::const_iterator iter = map_.begin(); iter != map_.end(); ++iter) {
+            if(iter->second >= names_.size()) {
+                names_.resize(iter->second + 1);
+            }
+            names_[iter->second] = iter->first;
+
+            Slot slot = { hash(iter->first), static_cast<uint32_t>(iter->second + 1) };
+            size_t i = slot.hash & mask_;
+            while(slots_[i].index) {
+                i = (i + 1) & mask_;
+            }
+            slots_[i] = slot;
+        }
+
+        IndexMap().swap(map_);
+    }
+
   private:
 
+    struct Slot {
+        uint32_t hash;
+        uint32_t index;     ///< the name's index plus one, 0 for an empty slot
+    };
+
+    // 32 bit FNV-1a
+    static uint32_t hash(const std::string &name) {
+        uint32_t h = 2166136261U;
+        for(std::string::const_iterator iter = name.begin(); iter != name.end(); ++iter) {
+            h = (h ^ static_cast<uint8_t>(*iter)) * 16777619U;
+        }
+        return h;
+    }
+
     IndexMap map_;
+    std::vector<std::string> names_;
+    std::vector<Slot> slots_;
+    size_t mask_;
 };
 
 } // namespace concepts
@@ -109,6 +109,10 @@ class NodeImpl : public Node
         sizeAttribute_.add(size);
     }
 
+    void doLock() {
+        nameIndex_.freeze();
+    }
+
     int fixedSize() const {
         return sizeAttribute_.get();
     }
@@ -118,6 +122,7 @@ class NodeImpl : public Node
     void printBasicInfo(std::ostream &os) const;
 
     void setLeafToSymbolic(int index, const NodePtr &node);
+    void replaceLeaf(int index, const NodePtr &node);
    
     SchemaResolution furtherResolution(const Node &node) const;
 
@@ -162,6 +167,7 @@ class NodePrimitive : public NodeImplPrimitive
     SchemaResolution resolve(const Node &reader)  const;
 
     void printJson(std::ostream &os, int depth) const;
+    void printCanonicalJson(std::ostream &os) const;
 
     bool isValid() const {
         return true;
@@ -185,6 +191,7 @@ class NodeSymbolic : public NodeImplSymbolic
     SchemaResolution resolve(const Node &reader)  const;
 
     void printJson(std::ostream &os, int depth) const;
+    void printCanonicalJson(std::ostream &os) const;
 
     bool isValid() const {
         return (nameAttribute_.size() == 1);
@@ -233,6 +240,7 @@ class NodeRecord : public NodeImplRecord
     SchemaResolution resolve(const Node &reader)  const;
 
     void printJson(std::ostream &os, int depth) const;
+    void printCanonicalJson(std::ostream &os) const;
 
     bool isValid() const {
         return (
@@ -264,6 +272,7 @@ class NodeEnum : public NodeImplEnum
     SchemaResolution resolve(const Node &reader)  const;
 
     void printJson(std::ostream &os, int depth) const;
+    void printCanonicalJson(std::ostream &os) const;
 
     bool isValid() const {
         return (
@@ -288,6 +297,7 @@ class NodeArray : public NodeImplArray
     SchemaResolution resolve(const Node &reader)  const;
 
     void printJson(std::ostream &os, int depth) const;
+    void printCanonicalJson(std::ostream &os) const;
 
     bool isValid() const {
         return (leafAttributes_.size() == 1);
@@ -319,6 +329,7 @@ class NodeMap : public NodeImplMap
     SchemaResolution resolve(const Node &reader)  const;
 
     void printJson(std::ostream &os, int depth) const;
+    void printCanonicalJson(std::ostream &os) const;
 
     bool isValid() const {
         return (leafAttributes_.size() == 2);
@@ -340,6 +351,7 @@ class NodeUnion : public NodeImplUnion
     SchemaResolution resolve(const Node &reader)  const;
 
     void printJson(std::ostream &os, int depth) const;
+    void printCanonicalJson(std::ostream &os) const;
 
     bool isValid() const {
         return (leafAttributes_.size() > 1);
@@ -361,6 +373,7 @@ class NodeFixed : public NodeImplFixed
     SchemaResolution resolve(const Node &reader)  const;
 
     void printJson(std::ostream &os, int depth) const;
+    void printCanonicalJson(std::ostream &os) const;
 
     bool isValid() const {
         return (
@@ -391,6 +404,17 @@ NodeImpl<A,B,C,D>::setLeafToSymbolic(int index, const NodePtr &node)
     replaceNode.swap(symbol);
 }
 
+template < class A, class B, class C, class D >
+inline void 
+NodeImpl<A,B,C,D>::replaceLeaf(int index, const NodePtr &node)
+{
+    if(!B::hasAttribute) {
+        throw Exception("Cannot change leaf node for nonexistent leaf");
+    } 
+
+    const_cast<NodePtr &>(leafAttributes_.get(index)) = node;
+}
+
 template < class A, class B, class C, class D >
 inline void 
 NodeImpl<A,B,C,D>::printBasicInfo(std::ostream &os) const
@@ -428,6 +452,12 @@ inline NodePtr resolveSymbol(const NodePtr &node)
     return symNode->getNode();
 }
 
+/// Finds the branch of the reader's union that the (non-union) writer
+/// resolves to: the first exact match, or else the first branch the writer
+/// may be promoted to.  Index is set to the branch chosen.
+
+SchemaResolution checkUnionMatch(const NodePtr &writer, const NodePtr &reader, size_t &index);
+
 } // namespace avro
 
 #endif
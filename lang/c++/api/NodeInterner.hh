@@ -0,0 +1,89 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_NodeInterner_hh__
+#define avro_NodeInterner_hh__
+
+#include <map>
+#include <set>
+#include <string>
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "Node.hh"
+
+/// \file NodeInterner.hh
+///
+
+namespace avro {
+
+/// Shares identical named types between schemas.  Schemas compiled from
+/// the same definitions each get their own tree of nodes, so a record that
+/// many schemas embed, like a common message header, is kept once for each
+/// of them.  Interning a schema replaces each of its records, enums and
+/// fixeds with an identical one that was interned before, if there is one,
+/// so that all the schemas point to the same locked nodes.
+///
+/// Types are identified by the CRC-64-AVRO fingerprint of their Parsing
+/// Canonical Form, and compared in full when fingerprints match.  Only types
+/// whose definition is self-contained are interned: one that refers by name
+/// to a type defined outside it could mean something else in another schema.
+///
+/// The interner holds weak pointers, so it does not keep types alive once no
+/// schema uses them.  Interning is opt-in, see ValidSchema::intern() and the
+/// SchemaRegistry constructor.
+
+class NodeInterner : private boost::noncopyable
+{
+
+  public:
+
+    NodeInterner();
+    ~NodeInterner();
+
+    /// Interns the named types in the tree, which must be locked, and
+    /// returns the root to use in its place (the root itself unless it was
+    /// replaced).  The nodes of the tree are modified, so it must not yet be
+    /// used by other threads.
+    NodePtr intern(const NodePtr &root);
+
+    /// The number of interned types still in use.
+    size_t size() const;
+
+    /// The process-wide interner.
+    static NodeInterner &instance();
+
+  private:
+
+    typedef std::set<std::string> Names;
+    typedef std::map<std::string, NodePtr> Replacements;
+    typedef std::multimap<uint64_t, boost::weak_ptr<Node> > NodeMap;
+
+    NodePtr internNode(const NodePtr &node, Names &defined, Names &referenced, Replacements &replaced);
+    NodePtr find(const NodePtr &node);
+
+    mutable boost::mutex mutex_;
+    NodeMap nodes_;
+};
+
+} // namespace avro
+
+#endif
@@ -118,6 +118,11 @@ class Parser : private boost::noncopyable
         return reader_.readMapBlockSize();
     }
 
+    /// Skips the whole of the next value, only works with ValidatingReader
+    void skip() {
+        reader_.skipValue();
+    }
+
   private:
 
     friend Type nextType(Parser<ValidatingReader> &p);
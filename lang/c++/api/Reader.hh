@@ -26,6 +26,7 @@
 #include "InputStreamer.hh"
 #include "Zigzag.hh"
 #include "Types.hh"
+#include "View.hh"
 
 namespace avro {
 
@@ -90,9 +91,20 @@ class Reader : private boost::noncopyable
         }
     }
 
+    /// Points val at a string or bytes value in the input instead of copying
+    /// it, which needs a streamer that holds its input in memory.
+    void readValue(View &val) {
+        size_t size = static_cast<size_t>(readSize());
+        const uint8_t *bytes = in_.readInPlace(size);
+        if(bytes == 0 && size > 0) {
+            throw Exception("Views can only be read from a streamer that holds its input in memory");
+        }
+        val = View(bytes, size);
+    }
+
     void readBytes(std::vector<uint8_t> &val) {
         int64_t size = readSize();
-        
+        val.clear();
         val.reserve(size);
         uint8_t bval;
         for(size_t bytes = 0; bytes < static_cast<size_t>(size); bytes++) {
@@ -119,6 +131,16 @@ class Reader : private boost::noncopyable
   
     void readRecord() { }
 
+    /// Reads past size bytes without keeping them.
+    void skipBytes(size_t size) {
+        uint8_t buffer[256];
+        while(size > 0) {
+            size_t chunk = size < sizeof(buffer) ? size : sizeof(buffer);
+            in_.readBytes(buffer, chunk);
+            size -= chunk;
+        }
+    }
+
     int64_t readArrayBlockSize() {
         return readSize();
     }
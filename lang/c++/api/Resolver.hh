@@ -31,6 +31,12 @@ namespace avro {
 class Reader;
 class ValidSchema;
 class Layout;
+
+/// A Resolver is the compiled form of the rules for reading data written with
+/// one schema into objects laid out for another.  A Resolver is immutable once
+/// it has been constructed: parse() is const and keeps all of its state in the
+/// Reader and the object being parsed, so a single Resolver may be used by any
+/// number of threads at once, provided each thread has its own Reader.
     
 class Resolver : private boost::noncopyable
 {
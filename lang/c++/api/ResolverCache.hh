@@ -0,0 +1,160 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_ResolverCache_hh__
+#define avro_ResolverCache_hh__
+
+#include <list>
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+/// \file ResolverCache.hh
+///
+
+namespace avro {
+
+class ValidSchema;
+class Layout;
+class Resolver;
+
+/// Compiling a Resolver walks both the writer's and the reader's schemas and
+/// builds a tree of resolving objects, which costs far more than parsing a
+/// single record with it.  The ResolverCache keeps compiled resolvers keyed by
+/// the writer schema's fingerprint, the reader schema's fingerprint and the
+/// contents of the reader's layout (the type and offset of every layout in
+/// the tree, and the function of every setter), so that a resolver is
+/// compiled once per distinct combination no matter how many times it is
+/// requested, and two layouts built by hand from the same classes do not
+/// share a resolver unless they describe the same object.
+///
+/// Describing a layout walks all of it, so callers that look up the same
+/// layout again and again describe it once, as a LayoutKey, and pass that:
+/// a lookup that finds its resolver then neither walks nor allocates.
+///
+/// The cache is bounded: when it holds more than capacity() resolvers, the
+/// least recently used one is dropped (readers still holding it keep it
+/// alive).  All member functions may be called concurrently from any number
+/// of threads.
+
+class ResolverCache : private boost::noncopyable
+{
+
+  public:
+
+    typedef boost::shared_ptr<const Resolver> ResolverPtr;
+
+    enum {
+        DEFAULT_CAPACITY = 64
+    };
+
+    /// The contents of a reader's layout, as the cache keys them.  The
+    /// layout must outlive the key and must not change.
+    class LayoutKey {
+
+      public:
+
+        explicit LayoutKey(const Layout &layout);
+
+        const Layout &layout() const {
+            return layout_;
+        }
+
+      private:
+
+        friend class ResolverCache;
+
+        const Layout &layout_;
+        std::string key_;
+    };
+
+    explicit ResolverCache(size_t capacity = DEFAULT_CAPACITY);
+
+    /// Returns the compiled resolver for this schema pair and layout,
+    /// compiling and caching it first if it is not already present.
+    ResolverPtr resolver(const ValidSchema &writer, const ValidSchema &reader, const LayoutKey &readerLayout);
+
+    /// The same, describing the layout anew on every call.
+    ResolverPtr resolver(const ValidSchema &writer, const ValidSchema &reader, const Layout &readerLayout) {
+        return resolver(writer, reader, LayoutKey(readerLayout));
+    }
+
+    size_t capacity() const;
+    void setCapacity(size_t capacity);
+
+    size_t size() const;
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+    void clear();
+
+    /// The process-wide cache.
+    static ResolverCache &instance();
+
+  private:
+
+    // the layout is the caller's while looking up, and the entry's once
+    // it is stored
+    struct Key {
+        Key(uint64_t w, uint64_t r, const std::string *l) :
+            writer(w), reader(r), layout(l)
+        {}
+
+        bool operator<(const Key &rhs) const;
+
+        uint64_t writer;
+        uint64_t reader;
+        const std::string *layout;
+    };
+
+    struct Entry {
+        Entry(const Key &key, const ResolverPtr &r) :
+            writer(key.writer), reader(key.reader), layout(*key.layout), resolver(r)
+        {}
+
+        Key key() const {
+            return Key(writer, reader, &layout);
+        }
+
+        uint64_t writer;
+        uint64_t reader;
+        std::string layout;
+        ResolverPtr resolver;
+    };
+
+    typedef std::list<Entry> LruList;
+    typedef std::map<Key, LruList::iterator> Index;
+
+    void evict();
+
+    mutable boost::mutex mutex_;
+    size_t capacity_;
+    LruList lru_;
+    Index index_;
+    uint64_t hits_;
+    uint64_t misses_;
+};
+
+} // namespace avro
+
+#endif
@@ -24,6 +24,7 @@
 #include <boost/shared_ptr.hpp>
 #include <stdint.h>
 #include "Boost.hh"
+#include "ResolverCache.hh"
 
 /// \file ResolverSchema.hh
 ///
@@ -41,13 +42,26 @@ class ResolverSchema {
 
     ResolverSchema(const ValidSchema &writer, const ValidSchema &reader, const Layout &readerLayout);
 
+    /// Uses the resolver compiled by the cache (for example
+    /// ResolverCache::instance()) instead of compiling a new one.
+    ResolverSchema(const ValidSchema &writer, const ValidSchema &reader, const Layout &readerLayout, ResolverCache &cache);
+
+    /// The same, with the layout already described for the cache, which
+    /// saves walking it when this is constructed again and again.
+    ResolverSchema(const ValidSchema &writer, const ValidSchema &reader,
+                   const ResolverCache::LayoutKey &readerLayout, ResolverCache &cache);
+
   private:
 
     friend class ResolvingReader;
 
     void parse(Reader &reader, uint8_t *address); 
 
-    boost::shared_ptr<Resolver> resolver_;
+    const Resolver &resolver() const {
+        return *resolver_;
+    }
+
+    boost::shared_ptr<const Resolver> resolver_;
 
 };
 
@@ -20,10 +20,12 @@
 #ifndef avro_ResolvingReader_hh__
 #define avro_ResolvingReader_hh__
 
+#include <vector>
 #include <stdint.h>
 #include <boost/noncopyable.hpp>
 
 #include "ResolverSchema.hh"
+#include "Resolver.hh"
 #include "Reader.hh"
 
 namespace avro {
@@ -45,6 +47,39 @@ class ResolvingReader : private boost::noncopyable
         schema_.parse(reader_, reinterpret_cast<uint8_t *>(&object));
     }
 
+    /// Parses count consecutive records, as found in a block of a container
+    /// file, into the objects.
+    template<typename T>
+    void parseBatch(T *objects, size_t count) {
+        const Resolver &resolver = schema_.resolver();
+        Reader &reader = reader_;
+        for(size_t i = 0; i < count; ++i) {
+#if defined(__GNUC__)
+            if(i + 1 < count) {
+                __builtin_prefetch(objects + i + 1, 1);
+            }
+#endif
+            resolver.parse(reader, reinterpret_cast<uint8_t *>(objects + i));
+        }
+    }
+
+    /// Appends count parsed records to the objects.  If parsing throws,
+    /// the objects are left as they were.
+    template<typename T>
+    void parseBatch(std::vector<T> &objects, size_t count) {
+        if(count) {
+            size_t first = objects.size();
+            objects.resize(first + count);
+            try {
+                parseBatch(&objects[first], count);
+            }
+            catch(...) {
+                objects.resize(first);
+                throw;
+            }
+        }
+    }
+
   private:
 
     Reader reader_;
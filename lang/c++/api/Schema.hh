@@ -55,6 +55,8 @@ class Schema
   protected:
 
     friend void compileJsonSchema(std::istream &is, ValidSchema &schema);
+    friend void compileJsonSchema(const char *data, size_t len, ValidSchema &schema);
+    friend void readBinarySchema(const uint8_t *data, size_t len, ValidSchema &schema);
 
     Schema();
     explicit Schema(const NodePtr &node);
@@ -0,0 +1,144 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_SchemaRegistry_hh__
+#define avro_SchemaRegistry_hh__
+
+#include <string>
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/mutex.hpp>
+
+/// \file SchemaRegistry.hh
+///
+/// The lock free lookup uses the __atomic builtins of GCC 4.7 and later,
+/// which clang provides as well.
+
+#ifndef __ATOMIC_ACQUIRE
+#error "SchemaRegistry needs the __atomic builtins of GCC 4.7 or later"
+#endif
+
+namespace avro {
+
+class ValidSchema;
+class NodeInterner;
+
+/// Maps the 64 bit fingerprints of schemas (see ValidSchema::fingerprint64)
+/// to the schemas themselves, for decoders that find only a fingerprint in
+/// front of each message.
+///
+/// Looking up a schema takes no lock and writes no shared memory, so any
+/// number of threads may call find() while another registers schemas.  The
+/// schemas are kept in an open addressed hash table of pointers: a new
+/// schema is published by storing its pointer into an empty slot, and when
+/// the table fills up it is copied into one twice the size, which is then
+/// published in its place.  Readers may still be probing the old table, so
+/// it is kept, as are the schemas, until the registry is destroyed.  Schemas
+/// cannot be removed.
+
+class SchemaRegistry : private boost::noncopyable
+{
+
+  public:
+
+    typedef boost::shared_ptr<const ValidSchema> SchemaPtr;
+
+    /// If an interner is given, the schemas the registry compiles share
+    /// their named types through it.
+    explicit SchemaRegistry(NodeInterner *interner = 0);
+    ~SchemaRegistry();
+
+    /// Registers the schema under its fingerprint.  Returns the registered
+    /// schema, which is the one already there if another schema with the
+    /// same fingerprint was added before.
+    const ValidSchema &add(const SchemaPtr &schema);
+
+    /// Compiles the JSON schema, interns it if the registry has an
+    /// interner, and registers it.
+    const ValidSchema &add(const char *json, size_t len);
+
+    /// Compiles and registers every file ending in .avsc in the directory,
+    /// and returns how many there were.  Throws if one cannot be read or
+    /// compiled.
+    size_t addDirectory(const std::string &path);
+
+    /// Returns the schema with this fingerprint, or 0 if there is none.  The
+    /// schema lives as long as the registry.
+    const ValidSchema *find(uint64_t fingerprint) const {
+        const Table *table = __atomic_load_n(&table_, __ATOMIC_ACQUIRE);
+        for(size_t i = slot(fingerprint, *table); ; i = (i + 1) & table->mask) {
+            const Entry *entry = __atomic_load_n(&table->slots[i], __ATOMIC_ACQUIRE);
+            if(!entry) {
+                return 0;
+            }
+            if(entry->fingerprint == fingerprint) {
+                return entry->schema.get();
+            }
+        }
+    }
+
+    size_t size() const;
+
+    /// The process-wide registry.
+    static SchemaRegistry &instance();
+
+  private:
+
+    struct Entry {
+        Entry(uint64_t f, const SchemaPtr &s) :
+            fingerprint(f), schema(s)
+        {}
+
+        const uint64_t fingerprint;
+        const SchemaPtr schema;
+    };
+
+    struct Table {
+        explicit Table(size_t capacity) :
+            mask(capacity - 1),
+            slots(new const Entry *[capacity]())
+        {}
+
+        const size_t mask;
+        boost::scoped_array<const Entry *> slots;
+    };
+
+    static size_t slot(uint64_t fingerprint, const Table &table) {
+        return static_cast<size_t>(fingerprint ^ (fingerprint >> 32)) & table.mask;
+    }
+
+    void insert(Table &table, const Entry *entry);
+
+    // written only under the mutex, and always published with a release
+    // store so that readers see a fully built table or entry
+    Table *table_;
+
+    NodeInterner *interner_;
+
+    mutable boost::mutex mutex_;
+    boost::ptr_vector<Table> tables_;
+    boost::ptr_vector<Entry> entries_;
+};
+
+} // namespace avro
+
+#endif
@@ -70,7 +70,11 @@ class Serializer : private boost::noncopyable
     }
 
     void writeBytes(const void *val, size_t size) {
-        writer_.writeBytes(val);
+        writer_.writeBytes(val, size);
+    }
+
+    void writeFixed(const uint8_t *val, size_t size) {
+        writer_.writeFixed(val, size);
     }
 
     template <size_t N>
@@ -0,0 +1,147 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_SingleObject_hh__
+#define avro_SingleObject_hh__
+
+#include <map>
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Writer.hh"
+#include "Reader.hh"
+#include "InputStreamer.hh"
+#include "OutputStreamer.hh"
+#include "AvroSerialize.hh"
+#include "Resolver.hh"
+#include "ResolverCache.hh"
+
+/// \file SingleObject.hh
+///
+/// The avro single object encoding frames each datum on its own: a two byte
+/// marker (0xC3 0x01), the CRC-64-AVRO fingerprint of the writer's schema in
+/// little endian order, then the datum in the binary encoding.
+
+namespace avro {
+
+class ValidSchema;
+class Layout;
+class SchemaRegistry;
+
+enum {
+    SINGLE_OBJECT_HEADER_SIZE = 10
+};
+
+/// Writes single object encoded datums.  The header depends only on the
+/// schema, so it is built once, when the writer is constructed.
+
+class SingleObjectWriter : private boost::noncopyable
+{
+
+  public:
+
+    SingleObjectWriter(const ValidSchema &schema, OutputStreamer &out);
+
+    /// Writes the header and the object, which may be anything there is an
+    /// avro::serialize function for.
+    template<typename T>
+    void write(const T &object) {
+        writeHeader();
+        serialize(writer_, object);
+    }
+
+    /// Writes only the header, for datums that are written piece by piece
+    /// with writer().
+    void writeHeader() {
+        out_.writeBytes(header_, sizeof(header_));
+    }
+
+    Writer &writer() {
+        return writer_;
+    }
+
+  private:
+
+    uint8_t header_[SINGLE_OBJECT_HEADER_SIZE];
+    OutputStreamer &out_;
+    Writer writer_;
+};
+
+/// Reads single object encoded datums into objects with the layout of the
+/// reader's schema.  The writer's schema is looked up by its fingerprint in
+/// a SchemaRegistry, and resolved to the reader's schema with a resolver
+/// compiled by a ResolverCache.  Each reader remembers the resolvers it has
+/// used by fingerprint, so once every writer schema has been seen, reading
+/// a datum takes no locks and allocates no memory (other than what the
+/// object itself allocates for its strings, arrays and maps).
+///
+/// The schema, layout, registry and cache must outlive the reader.  A
+/// reader is not thread safe, use one per thread.
+
+class SingleObjectReader : private boost::noncopyable
+{
+
+  public:
+
+    SingleObjectReader(const ValidSchema &readerSchema, const Layout &readerLayout);
+
+    SingleObjectReader(const ValidSchema &readerSchema, const Layout &readerLayout,
+                       SchemaRegistry &registry, ResolverCache &cache);
+
+    /// Reads the datum in the message into the object.
+    template<typename T>
+    void read(const uint8_t *data, size_t size, T &object) {
+        const Resolver &resolver = resolverFor(fingerprint(data, size));
+        MemoryStreamer in(data + SINGLE_OBJECT_HEADER_SIZE, size - SINGLE_OBJECT_HEADER_SIZE);
+        Reader reader(in);
+        resolver.parse(reader, reinterpret_cast<uint8_t *>(&object));
+    }
+
+    /// Returns the fingerprint of the writer's schema in the message's
+    /// header.  Throws if the message does not start with a header.
+    static uint64_t fingerprint(const uint8_t *data, size_t size);
+
+  private:
+
+    typedef boost::shared_ptr<const Resolver> ResolverPtr;
+    typedef std::map<uint64_t, ResolverPtr> Resolvers;
+
+    const Resolver &resolverFor(uint64_t fingerprint) {
+        if(last_ && fingerprint == lastFingerprint_) {
+            return *last_;
+        }
+        return findResolver(fingerprint);
+    }
+
+    const Resolver &findResolver(uint64_t fingerprint);
+
+    const ValidSchema &readerSchema_;
+    const ResolverCache::LayoutKey readerLayout_;
+    SchemaRegistry &registry_;
+    ResolverCache &cache_;
+
+    uint64_t lastFingerprint_;
+    const Resolver *last_;
+    Resolvers resolvers_;
+};
+
+} // namespace avro
+
+#endif
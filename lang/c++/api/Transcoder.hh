@@ -0,0 +1,85 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_Transcoder_hh__
+#define avro_Transcoder_hh__
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/tss.hpp>
+#include "Boost.hh"
+
+/// \file Transcoder.hh
+///
+
+namespace avro {
+
+class ValidSchema;
+class InputStreamer;
+class OutputStreamer;
+class TranscodeStep;
+class TranscodeScratch;
+
+/// Converts avro binary data written with one schema directly into avro binary
+/// data for another schema, without parsing it into C++ objects.  The schemas
+/// are resolved with the same rules as the ResolvingReader: fields the reader
+/// does not have are skipped, fields are reordered, ints, longs and floats are
+/// promoted, and enum symbols and union branches are remapped.  Strings,
+/// bytes and fixed are copied as raw spans of bytes.
+///
+/// The reader may not contain fields the writer is missing unless they can be
+/// given a default: since schema defaults are not yet supported, they are
+/// written as the value a default-constructed object would have (zero, false,
+/// empty, the first enum symbol or union branch), just as a ResolvingReader
+/// leaves them untouched in the object it parses.
+///
+/// A Transcoder is immutable once constructed and may be used by many threads
+/// at once.  Each thread keeps its own buffers for the fields that arrive
+/// before the reader wants them, and reuses them from record to record.
+
+class Transcoder : private boost::noncopyable
+{
+
+  public:
+
+    Transcoder(const ValidSchema &writer, const ValidSchema &reader);
+    ~Transcoder();
+
+    /// Reads one datum of the writer's schema from in and writes it to out
+    /// in the reader's schema.
+    void transcode(InputStreamer &in, OutputStreamer &out) const;
+
+    /// Reads one datum of the writer's schema from in and discards it.
+    /// Only the writer's schema is followed, so a datum the reader could
+    /// not resolve, such as one holding an enum symbol the reader lacks,
+    /// is skipped all the same.
+    void skip(InputStreamer &in) const;
+
+  private:
+
+    TranscodeScratch &scratch() const;
+
+    boost::ptr_vector<TranscodeStep> steps_;
+    const TranscodeStep *root_;
+    const TranscodeStep *skipper_;
+    mutable boost::thread_specific_ptr<TranscodeScratch> scratch_;
+};
+
+} // namespace avro
+
+#endif
@@ -20,6 +20,7 @@
 #define avro_Types_hh__
 
 #include <iostream>
+#include <string>
 
 namespace avro {
 
@@ -68,6 +69,9 @@ inline bool isAvroTypeOrPseudoType(Type t) {
 
 std::ostream &operator<< (std::ostream &os, avro::Type type);
 
+/// The name of the type as it is written in a schema.
+const std::string &toString(Type type);
+
 /// define a type to identify Null in template functions
 struct Null { };
 
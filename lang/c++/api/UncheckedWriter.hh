@@ -0,0 +1,145 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_UncheckedWriter_hh__
+#define avro_UncheckedWriter_hh__
+
+#include <string.h>
+#include <boost/noncopyable.hpp>
+
+#include "Zigzag.hh"
+#include "Types.hh"
+#include "View.hh"
+
+namespace avro {
+
+///
+/// Writes avro data straight into a block of memory, with the same interface
+/// as Writer but no OutputStreamer behind it.  Nothing is checked: the block
+/// must have room for everything written, for example because it was sized
+/// with encodedSize(), or the writer runs past its end.
+///
+
+class UncheckedWriter : private boost::noncopyable
+{
+
+  public:
+
+    explicit UncheckedWriter(uint8_t *data) :
+        data_(data),
+        next_(data)
+    {}
+
+    void writeValue(const Null &) {}
+
+    void writeValue(bool val) {
+        *next_++ = (val != 0);
+    }
+
+    void writeValue(int32_t val) {
+        next_ += encodeInt32(val, next_);
+    }
+
+    void writeValue(int64_t val) {
+        next_ += encodeInt64(val, next_);
+    }
+
+    void writeValue(float val) {
+        memcpy(next_, &val, sizeof(val));
+        next_ += sizeof(val);
+    }
+
+    void writeValue(double val) {
+        memcpy(next_, &val, sizeof(val));
+        next_ += sizeof(val);
+    }
+
+    void writeValue(const std::string &val) {
+        writeBytes(val.data(), val.size());
+    }
+
+    void writeValue(const View &val) {
+        writeBytes(val.data, val.size);
+    }
+
+    void writeBytes(const void *val, size_t size) {
+        writeValue(static_cast<int64_t>(size));
+        writeFixed(static_cast<const uint8_t *>(val), size);
+    }
+
+    void writeFixed(const uint8_t *val, size_t size) {
+        memcpy(next_, val, size);
+        next_ += size;
+    }
+
+    template <size_t N>
+    void writeFixed(const uint8_t (&val)[N]) {
+        writeFixed(val, N);
+    }
+
+    template <size_t N>
+    void writeFixed(const boost::array<uint8_t, N> &val) {
+        writeFixed(val.data(), val.size());
+    }
+
+    void writeRecord() {}
+
+    void writeArrayBlock(int64_t size) {
+        writeValue(size);
+    }
+
+    void writeArrayEnd() {
+        *next_++ = 0;
+    }
+
+    void writeMapBlock(int64_t size) {
+        writeValue(size);
+    }
+
+    void writeMapEnd() {
+        *next_++ = 0;
+    }
+
+    void writeUnion(int64_t choice) {
+        writeValue(choice);
+    }
+
+    void writeEnum(int64_t choice) {
+        writeValue(choice);
+    }
+
+    /// The number of bytes written so far.
+    size_t size() const {
+        return next_ - data_;
+    }
+
+    /// Where the next byte goes.
+    uint8_t *position() const {
+        return next_;
+    }
+
+  private:
+
+    uint8_t *data_;
+    uint8_t *next_;
+};
+
+} // namespace avro
+
+#endif
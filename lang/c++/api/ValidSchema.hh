@@ -20,13 +20,17 @@
 #define avro_ValidSchema_hh__ 
 
 #include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "Node.hh"
+#include "Fingerprint.hh"
 
 namespace avro {
 
 class Schema;
 class SymbolMap;
+class NodeInterner;
+class ValidationTable;
 
 /// A ValidSchema is basically a non-mutable Schema that has passed some
 /// minumum of sanity checks.  Once valididated, any Schema that is part of
@@ -56,11 +60,48 @@ class ValidSchema : private boost::noncopyable
 
     void toFlatList(std::ostream &os) const;
 
+    /// Writes the schema in Parsing Canonical Form, which is the same for
+    /// any two schemas that parse data the same way.
+    void toCanonicalJson(std::ostream &os) const;
+
+    const std::string &canonicalForm() const {
+        return canonicalForm_;
+    }
+
+    /// The CRC-64-AVRO fingerprint of the Parsing Canonical Form.  Like the
+    /// canonical form and the SHA-256 fingerprint, it is computed once when
+    /// the schema is set.
+    uint64_t fingerprint64() const {
+        return fingerprint64_;
+    }
+
+    const Sha256Digest &fingerprintSha256() const {
+        return fingerprintSha256_;
+    }
+
+    /// Shares the schema's named types with identical ones in other schemas
+    /// interned before (see NodeInterner), by default in the process-wide
+    /// interner.  Call it before the schema is used by other threads.
+    void intern();
+    void intern(NodeInterner &interner);
+
+    /// The schema compiled for Validators, shared by all of them.
+    const boost::shared_ptr<const ValidationTable> &validationTable() const {
+        return validationTable_;
+    }
+
   protected:
 
     bool validate(const NodePtr &node, SymbolMap &symbolMap);
 
+    void compile();
+
     NodePtr root_;
+    boost::shared_ptr<const ValidationTable> validationTable_;
+
+    std::string canonicalForm_;
+    uint64_t fingerprint64_;
+    Sha256Digest fingerprintSha256_;
 };
 
 } // namespace avro
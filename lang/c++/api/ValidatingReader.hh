@@ -89,6 +89,11 @@ class ValidatingReader : private boost::noncopyable
 
     int64_t readMapBlockSize();
 
+    /// Reads past the whole of the next value, whatever its type, including
+    /// the values nested in it.  Blocks of arrays and maps that were written
+    /// with their size in bytes are skipped without reading their items.
+    void skipValue();
+
     Type nextType() const{
         return validator_.nextTypeExpected();
     }
@@ -105,6 +110,9 @@ class ValidatingReader : private boost::noncopyable
 
     int64_t readCount();
 
+    void skipBytes();
+    void skipBlocks(Type type, int64_t valuesPerItem);
+
     void checkSafeToGet(Type type) const {
         if(validator_.nextTypeExpected() != type) {
             throw Exception("Type does not match");
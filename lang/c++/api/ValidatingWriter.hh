@@ -42,7 +42,7 @@ class ValidatingWriter : private boost::noncopyable
     ValidatingWriter(const ValidSchema &schema, OutputStreamer &out);
 
     template<typename T>
-    void writeValue(T val) {
+    void writeValue(const T &val) {
         checkSafeToPut(type_to_avro<T>::type);
         writer_.writeValue(val);
         validator_.advance();
@@ -54,8 +54,21 @@ class ValidatingWriter : private boost::noncopyable
         validator_.advance();
     }
 
+    void writeValue(const View &val) {
+        checkSafeToPut(AVRO_STRING);
+        writer_.writeValue(val);
+        validator_.advance();
+    }
+
     void writeBytes(const void *val, size_t size);
 
+    void writeFixed(const uint8_t *val, size_t size) {
+        checkSafeToPut(AVRO_FIXED);
+        checkSizeExpected(size);
+        writer_.writeFixed(val, size);
+        validator_.advance();
+    }
+
     template <size_t N>
     void writeFixed(const uint8_t (&val)[N]) {
         checkSafeToPut(AVRO_FIXED);
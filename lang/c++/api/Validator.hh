@@ -20,7 +20,9 @@
 #define avro_Validating_hh__
 
 #include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
 #include <vector>
+#include <map>
 #include <stdint.h>
 
 #include "Types.hh"
@@ -31,15 +33,69 @@ namespace avro {
 class ValidSchema;
 class OutputStreamer;
 
+/// The schema compiled for validation: a flat table with an entry for each
+/// distinct node of the schema, in which the leaves of compound nodes are
+/// indices of other entries and symbolic references are already resolved.
+/// A ValidationTable is immutable, and is compiled only once for each
+/// ValidSchema, which shares it with all the Validators it is used by.
+
+class ValidationTable : private boost::noncopyable
+{
+
+  public:
+
+    typedef uint32_t flag_t;
+
+    struct Entry {
+        Type type;
+        flag_t flags;           ///< the types that may be read or written
+        size_t firstLeaf;       ///< position of the leaves in leaves()
+        size_t leaves;
+        int fixedSize;
+        const Node *node;       ///< for the names of records and fields
+    };
+
+    explicit ValidationTable(const NodePtr &root);
+
+    const Entry &entry(size_t index) const {
+        return entries_[index];
+    }
+
+    /// The index of the entry of the index'th leaf of an entry.
+    size_t leafAt(const Entry &entry, size_t index) const {
+        return leaves_[entry.firstLeaf + index];
+    }
+
+    /// The entry of the root of the schema is always the first.
+    static const size_t ROOT = 0;
+
+    static flag_t typeToFlag(Type type) {
+        return static_cast<flag_t>(1) << type;
+    }
+
+  private:
+
+    size_t compile(const NodePtr &node, std::map<const Node *, size_t> &compiled);
+
+    // keeps the nodes the entries point to alive
+    const NodePtr root_;
+
+    std::vector<Entry> entries_;
+    std::vector<size_t> leaves_;
+};
+
 /// This class is used by both the ValidatingSerializer and ValidationParser
 /// objects.  It advances the parse tree (containing logic how to advance
 /// through the various compound types, for example a record must advance
 /// through all leaf nodes but a union only skips to one), and reports which
 /// type is next.
+///
+/// The parse tree is walked in the schema's ValidationTable, keeping only the
+/// indices of its entries on the stack.
 
 class Validator : private boost::noncopyable
 {
-    typedef uint32_t flag_t;
+    typedef ValidationTable::flag_t flag_t;
 
   public:
 
@@ -58,17 +114,19 @@ class Validator : private boost::noncopyable
 
     int nextSizeExpected() const;
 
+    /// The number of fields of the record that is expected next.
+    size_t nextFieldCount() const;
+
     bool getCurrentRecordName(std::string &name) const;
     bool getNextFieldName(std::string &name) const;
 
   private:
 
     flag_t typeToFlag(Type type) const {
-        flag_t flag = (1L << type);
-        return flag;
+        return ValidationTable::typeToFlag(type);
     }
 
-    void setupOperation(const NodePtr &node);
+    void setupOperation(size_t entry);
 
     void setWaitingForCount();
 
@@ -78,15 +136,12 @@ class Validator : private boost::noncopyable
     void unionAdvance();
     void fixedAdvance();
 
-    void setupFlag(Type type);
-
-    const ValidSchema &schema_;
-
-    // since this only keeps a reference to the schema, to ensure its parse
-    // tree is not deleted, keep a copy of a shared pointer to the root of the
-    // tree
+    const ValidationTable::Entry &top() const {
+        return table_->entry(compoundStack_.back().entry);
+    }
 
-    const NodePtr parseTree_;
+    // shared with the schema, and with the other validators of the schema
+    const boost::shared_ptr<const ValidationTable> table_;
 
     Type nextType_; 
     flag_t expectedTypesFlag_;
@@ -95,10 +150,10 @@ class Validator : private boost::noncopyable
     int64_t count_;
 
     struct CompoundType {
-        explicit CompoundType(const NodePtr &n) :
-            node(n), pos(0)
+        explicit CompoundType(size_t e) :
+            entry(e), pos(0)
         {}
-        NodePtr node;  ///< save the node
+        size_t  entry; ///< the entry of the node in the table
         size_t  pos; ///< track the leaf position to visit
     };
 
@@ -0,0 +1,74 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_View_hh__
+#define avro_View_hh__
+
+#include <string>
+#include <string.h>
+#include <stdint.h>
+
+#include "AvroTraits.hh"
+
+namespace avro {
+
+///
+/// A string or bytes value that points into the buffer it was parsed from
+/// instead of holding a copy.  It is only valid while that buffer is, so it
+/// suits code that is done with a record before the buffer goes away.
+///
+/// A Reader fills a View only when its InputStreamer holds the encoded data
+/// contiguously in memory, as MemoryStreamer does.
+///
+
+struct View {
+
+    View() :
+        data(0),
+        size(0)
+    {}
+
+    View(const uint8_t *d, size_t s) :
+        data(d),
+        size(s)
+    {}
+
+    /// Copies the bytes out, for a value that has to outlive the buffer.
+    std::string str() const {
+        return std::string(reinterpret_cast<const char *>(data), size);
+    }
+
+    bool operator==(const std::string &val) const {
+        return size == val.size() && (size == 0 || memcmp(data, val.data(), size) == 0);
+    }
+
+    bool operator!=(const std::string &val) const {
+        return !(*this == val);
+    }
+
+    const uint8_t *data;
+    size_t size;
+};
+
+template <>
+struct is_serializable<View> : public boost::true_type{};
+
+} // namespace avro
+
+#endif
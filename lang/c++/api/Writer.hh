@@ -24,6 +24,7 @@
 #include "OutputStreamer.hh"
 #include "Zigzag.hh"
 #include "Types.hh"
+#include "View.hh"
 
 namespace avro {
 
@@ -81,11 +82,19 @@ class Writer : private boost::noncopyable
         writeBytes(val.c_str(), val.size());
     }
 
+    void writeValue(const View &val) {
+        writeBytes(val.data, val.size);
+    }
+
     void writeBytes(const void *val, size_t size) {
         this->writeValue(static_cast<int64_t>(size));
         out_.writeBytes(val, size);
     }
 
+    void writeFixed(const uint8_t *val, size_t size) {
+        out_.writeBytes(val, size);
+    }
+
     template <size_t N>
     void writeFixed(const uint8_t (&val)[N]) {
         out_.writeBytes(val, N);
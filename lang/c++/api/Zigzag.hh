@@ -36,6 +36,56 @@ int32_t decodeZigzag32(uint32_t input);
 size_t encodeInt32(int32_t input, boost::array<uint8_t, 5> &output);
 size_t encodeInt64(int64_t input, boost::array<uint8_t, 10> &output);
 
+/// Encode straight into memory, which must have room for the 5 or 10 bytes
+/// the largest values take.  They return the number of bytes written.
+
+inline size_t encodeInt64(int64_t input, uint8_t *output)
+{
+    uint64_t val = (static_cast<uint64_t>(input) << 1) ^ static_cast<uint64_t>(input >> 63);
+    size_t bytesOut = 0;
+    while(val >= 0x80) {
+        output[bytesOut++] = static_cast<uint8_t>(val | 0x80);
+        val >>= 7;
+    }
+    output[bytesOut++] = static_cast<uint8_t>(val);
+    return bytesOut;
+}
+
+inline size_t encodeInt32(int32_t input, uint8_t *output)
+{
+    uint32_t val = (static_cast<uint32_t>(input) << 1) ^ static_cast<uint32_t>(input >> 31);
+    size_t bytesOut = 0;
+    while(val >= 0x80) {
+        output[bytesOut++] = static_cast<uint8_t>(val | 0x80);
+        val >>= 7;
+    }
+    output[bytesOut++] = static_cast<uint8_t>(val);
+    return bytesOut;
+}
+
+/// The number of bytes encodeInt64() writes for input, worked out from the
+/// position of the highest bit set in its zigzag encoding.
+inline size_t encodedInt64Size(int64_t input)
+{
+    uint64_t val = (static_cast<uint64_t>(input) << 1) ^ static_cast<uint64_t>(input >> 63);
+#if defined(__GNUC__)
+    return (70 - __builtin_clzll(val | 1)) / 7;
+#else
+    size_t bytes = 1;
+    while(val >>= 7) {
+        ++bytes;
+    }
+    return bytes;
+#endif
+}
+
+/// The number of bytes encodeInt32() writes for input, which zigzag
+/// encoding makes the same as for the 64 bit value.
+inline size_t encodedInt32Size(int32_t input)
+{
+    return encodedInt64Size(input);
+}
+
 } // namespace avro
 
 #endif
@@ -0,0 +1,83 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Arena.hh"
+
+namespace avro {
+
+Arena::Arena(size_t blockSize) :
+    blockSize_(blockSize),
+    current_(0),
+    cursor_(0),
+    end_(0)
+{ }
+
+Arena::~Arena()
+{
+    for(size_t i = 0; i < blocks_.size(); ++i) {
+        delete [] blocks_[i].data;
+    }
+}
+
+void *
+Arena::allocateFromNextBlock(size_t size)
+{
+    // after a reset, the blocks already held are used again in order
+    size_t next = blocks_.empty() ? 0 : current_ + 1;
+    while(next < blocks_.size() && blocks_[next].size < size) {
+        ++next;
+    }
+
+    if(next == blocks_.size()) {
+        Block block;
+        block.size = (size > blockSize_) ? size : blockSize_;
+        block.data = new uint8_t[block.size];
+        blocks_.push_back(block);
+    }
+
+    current_ = next;
+    cursor_ = blocks_[next].data + size;
+    end_ = blocks_[next].data + blocks_[next].size;
+    return blocks_[next].data;
+}
+
+void
+Arena::reset()
+{
+    current_ = 0;
+    if(blocks_.empty()) {
+        cursor_ = end_ = 0;
+    }
+    else {
+        cursor_ = blocks_[0].data;
+        end_ = blocks_[0].data + blocks_[0].size;
+    }
+}
+
+size_t
+Arena::capacity() const
+{
+    size_t total = 0;
+    for(size_t i = 0; i < blocks_.size(); ++i) {
+        total += blocks_[i].size;
+    }
+    return total;
+}
+
+} // namespace avro
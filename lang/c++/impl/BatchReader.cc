@@ -0,0 +1,123 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <boost/thread/thread.hpp>
+
+#include "BatchReader.hh"
+#include "Transcoder.hh"
+#include "ValidSchema.hh"
+
+namespace avro {
+
+void 
+indexRecords(const ValidSchema &writer, const uint8_t *data, size_t size, std::vector<size_t> &offsets)
+{
+    Transcoder skipper(writer, writer);
+    MemoryStreamer in(data, size);
+    while(in.remaining()) {
+        offsets.push_back(in.position());
+        skipper.skip(in);
+    }
+}
+
+namespace {
+
+// Runs one range of a batch, keeping what it throws for the caller since a
+// thread may not let an exception escape.
+class BatchWorker 
+{
+  public:
+
+    BatchWorker(const BatchTask &task, size_t begin, size_t end, std::string &error) :
+        task_(task),
+        begin_(begin),
+        end_(end),
+        error_(error)
+    {}
+
+    void operator()() const {
+        try {
+            task_.run(begin_, end_);
+        }
+        catch(const std::exception &e) {
+            error_ = e.what();
+            if(error_.empty()) {
+                error_ = "Unknown error parsing batch";
+            }
+        }
+        catch(...) {
+            error_ = "Unknown error parsing batch";
+        }
+    }
+
+  private:
+
+    const BatchTask &task_;
+    size_t begin_;
+    size_t end_;
+    std::string &error_;
+};
+
+} // namespace
+
+void 
+runBatchTask(const BatchTask &task, size_t count, size_t threads)
+{
+    if(threads > count) {
+        threads = count;
+    }
+    if(threads <= 1) {
+        if(count) {
+            task.run(0, count);
+        }
+        return;
+    }
+
+    std::vector<std::string> errors(threads);
+    boost::thread_group group;
+    try {
+        size_t begin = 0;
+        for(size_t i = 0; i < threads; ++i) {
+            size_t end = (count * (i + 1)) / threads;
+            BatchWorker worker(task, begin, end, errors[i]);
+            if(i + 1 < threads) {
+                group.create_thread(worker);
+            }
+            else {
+                worker();
+            }
+            begin = end;
+        }
+    }
+    catch(...) {
+        // the threads started refer to errors, they must finish first
+        group.join_all();
+        throw;
+    }
+    group.join_all();
+
+    for(size_t i = 0; i < threads; ++i) {
+        if(!errors[i].empty()) {
+            throw Exception(errors[i]);
+        }
+    }
+}
+
+} // namespace avro
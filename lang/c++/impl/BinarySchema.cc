@@ -0,0 +1,331 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <limits.h>
+#include <iterator>
+#include <boost/noncopyable.hpp>
+
+#include "BinarySchema.hh"
+#include "Fingerprint.hh"
+#include "NodeImpl.hh"
+#include "Schema.hh"
+#include "ValidSchema.hh"
+#include "Zigzag.hh"
+
+namespace avro {
+
+namespace {
+
+const uint8_t MAGIC[4] = { 'A', 'V', 'S', 'B' };
+const size_t HEADER_SIZE = sizeof(MAGIC) + 1;
+const size_t CHECKSUM_SIZE = 8;
+
+// deeper schemas are refused rather than risk overflowing the stack, since
+// the reader recurses once per level
+const size_t MAX_DEPTH = 256;
+
+void
+writeLong(int64_t value, std::vector<uint8_t> &buffer)
+{
+    boost::array<uint8_t, 10> bytes;
+    size_t size = encodeInt64(value, bytes);
+    buffer.insert(buffer.end(), bytes.begin(), bytes.begin() + size);
+}
+
+void
+writeName(const std::string &name, std::vector<uint8_t> &buffer)
+{
+    writeLong(name.size(), buffer);
+    buffer.insert(buffer.end(), name.begin(), name.end());
+}
+
+void
+writeNode(const Node &node, std::vector<uint8_t> &buffer)
+{
+    buffer.push_back(static_cast<uint8_t>(node.type()));
+
+    switch(node.type()) {
+      case AVRO_RECORD:
+        writeName(node.name(), buffer);
+        writeLong(node.leaves(), buffer);
+        for(size_t i = 0; i < node.leaves(); ++i) {
+            writeName(node.nameAt(i), buffer);
+            writeNode(*node.leafAt(i), buffer);
+        }
+        break;
+
+      case AVRO_ENUM:
+        writeName(node.name(), buffer);
+        writeLong(node.names(), buffer);
+        for(size_t i = 0; i < node.names(); ++i) {
+            writeName(node.nameAt(i), buffer);
+        }
+        break;
+
+      case AVRO_FIXED:
+        writeName(node.name(), buffer);
+        writeLong(node.fixedSize(), buffer);
+        break;
+
+      case AVRO_ARRAY:
+        writeNode(*node.leafAt(0), buffer);
+        break;
+
+      case AVRO_MAP:
+        writeNode(*node.leafAt(1), buffer);
+        break;
+
+      case AVRO_UNION:
+        writeLong(node.leaves(), buffer);
+        for(size_t i = 0; i < node.leaves(); ++i) {
+            writeNode(*node.leafAt(i), buffer);
+        }
+        break;
+
+      case AVRO_SYMBOLIC:
+        writeName(node.name(), buffer);
+        break;
+
+      default:
+        break;
+    }
+}
+
+/// Rebuilds the nodes from the body of a binary schema, checking every
+/// read against the end of the data.  Symbolic links are left unresolved;
+/// ValidSchema resolves them by name as it validates the tree.
+
+class BinarySchemaReader : private boost::noncopyable
+{
+
+  public:
+
+    BinarySchemaReader(const uint8_t *data, size_t len) :
+        pos_(data),
+        end_(data + len)
+    { }
+
+    NodePtr readSchema() {
+        NodePtr root = readNode(0);
+        if(pos_ != end_) {
+            throw Exception("Unexpected data after the binary schema");
+        }
+        return root;
+    }
+
+  private:
+
+    NodePtr readNode(size_t depth);
+
+    int64_t readLong() {
+        uint64_t encoded = 0;
+        for(int shift = 0; ; shift += 7) {
+            if(shift > 63) {
+                throw Exception("Bad long in binary schema");
+            }
+            uint8_t byte = readByte();
+            encoded |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if(!(byte & 0x80)) {
+                break;
+            }
+        }
+        return decodeZigzag64(encoded);
+    }
+
+    // every counted item takes at least a byte, so no count can be larger
+    // than what is left of the data
+    size_t readCount() {
+        int64_t count = readLong();
+        if(count < 0 || count > end_ - pos_) {
+            throw Exception(boost::format("Bad count %1% in binary schema") % count);
+        }
+        return static_cast<size_t>(count);
+    }
+
+    void readName(HasName &name) {
+        std::string str;
+        readName(str);
+        name.add(str);
+    }
+
+    void readName(std::string &name) {
+        size_t size = readCount();
+        if(size > static_cast<size_t>(end_ - pos_)) {
+            throw Exception("Truncated binary schema");
+        }
+        name.assign(reinterpret_cast<const char *>(pos_), size);
+        pos_ += size;
+    }
+
+    uint8_t readByte() {
+        if(pos_ == end_) {
+            throw Exception("Truncated binary schema");
+        }
+        return *pos_++;
+    }
+
+    const uint8_t *pos_;
+    const uint8_t *end_;
+};
+
+NodePtr
+BinarySchemaReader::readNode(size_t depth)
+{
+    if(depth == MAX_DEPTH) {
+        throw Exception(boost::format("Binary schema is nested deeper than %1% levels") % MAX_DEPTH);
+    }
+
+    uint8_t type = readByte();
+    if(!isAvroTypeOrPseudoType(static_cast<Type>(type))) {
+        throw Exception(boost::format("Bad type %1% in binary schema") % static_cast<int>(type));
+    }
+
+    std::string name;
+    switch(static_cast<Type>(type)) {
+      case AVRO_RECORD: {
+        HasName recordName;
+        readName(recordName);
+        MultiLeaves fields;
+        LeafNames names;
+        size_t count = readCount();
+        for(size_t i = 0; i < count; ++i) {
+            readName(name);
+            names.add(name);
+            fields.add(readNode(depth + 1));
+        }
+        return NodePtr(new NodeRecord(recordName, fields, names));
+      }
+
+      case AVRO_ENUM: {
+        HasName enumName;
+        readName(enumName);
+        LeafNames symbols;
+        size_t count = readCount();
+        for(size_t i = 0; i < count; ++i) {
+            readName(name);
+            symbols.add(name);
+        }
+        return NodePtr(new NodeEnum(enumName, symbols));
+      }
+
+      case AVRO_FIXED: {
+        HasName fixedName;
+        readName(fixedName);
+        int64_t fixedSize = readLong();
+        if(fixedSize < 0 || fixedSize > INT_MAX) {
+            throw Exception(boost::format("Bad fixed size %1% in binary schema") % fixedSize);
+        }
+        HasSize size;
+        size.add(static_cast<int>(fixedSize));
+        return NodePtr(new NodeFixed(fixedName, size));
+      }
+
+      case AVRO_ARRAY: {
+        SingleLeaf items;
+        items.add(readNode(depth + 1));
+        return NodePtr(new NodeArray(items));
+      }
+
+      case AVRO_MAP: {
+        SingleLeaf values;
+        values.add(readNode(depth + 1));
+        return NodePtr(new NodeMap(values));
+      }
+
+      case AVRO_UNION: {
+        MultiLeaves branches;
+        size_t count = readCount();
+        for(size_t i = 0; i < count; ++i) {
+            branches.add(readNode(depth + 1));
+        }
+        return NodePtr(new NodeUnion(branches));
+      }
+
+      case AVRO_SYMBOLIC: {
+        HasName symbol;
+        readName(symbol);
+        return NodePtr(new NodeSymbolic(symbol));
+      }
+
+      default:
+        return NodePtr(new NodePrimitive(static_cast<Type>(type)));
+    }
+}
+
+} // anonymous namespace
+
+void
+writeBinarySchema(const ValidSchema &schema, std::vector<uint8_t> &buffer)
+{
+    size_t start = buffer.size();
+    buffer.insert(buffer.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    buffer.push_back(BINARY_SCHEMA_VERSION);
+    writeNode(*schema.root(), buffer);
+
+    uint64_t checksum = crc64Avro(&buffer[start], buffer.size() - start);
+    for(size_t i = 0; i < CHECKSUM_SIZE; ++i) {
+        buffer.push_back(static_cast<uint8_t>(checksum >> (8 * i)));
+    }
+}
+
+void
+writeBinarySchema(const ValidSchema &schema, std::ostream &os)
+{
+    std::vector<uint8_t> buffer;
+    writeBinarySchema(schema, buffer);
+    os.write(reinterpret_cast<const char *>(&buffer[0]), buffer.size());
+}
+
+void
+readBinarySchema(const uint8_t *data, size_t len, ValidSchema &schema)
+{
+    if(len < HEADER_SIZE + CHECKSUM_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        throw Exception("Not a binary schema");
+    }
+    if(data[sizeof(MAGIC)] != BINARY_SCHEMA_VERSION) {
+        throw Exception(boost::format("Binary schema version %1% is not supported") % 
+            static_cast<int>(data[sizeof(MAGIC)]));
+    }
+
+    size_t checked = len - CHECKSUM_SIZE;
+    uint64_t checksum = 0;
+    for(size_t i = 0; i < CHECKSUM_SIZE; ++i) {
+        checksum |= static_cast<uint64_t>(data[checked + i]) << (8 * i);
+    }
+    if(crc64Avro(data, checked) != checksum) {
+        throw Exception("Binary schema checksum does not match");
+    }
+
+    BinarySchemaReader reader(data + HEADER_SIZE, checked - HEADER_SIZE);
+    Schema s(reader.readSchema());
+    schema.setSchema(s);
+}
+
+void
+readBinarySchema(std::istream &is, ValidSchema &schema)
+{
+    std::vector<char> data((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    if(data.empty()) {
+        throw Exception("Not a binary schema");
+    }
+    readBinarySchema(reinterpret_cast<const uint8_t *>(&data[0]), data.size(), schema);
+}
+
+} // namespace avro
@@ -0,0 +1,804 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#include "CodeGenerator.hh"
+#include "Exception.hh"
+#include "Node.hh"
+#include "ValidSchema.hh"
+#include "Zigzag.hh"
+
+namespace avro {
+
+namespace {
+
+// The code below follows the templates of gen-cppcode.py, with $key$
+// standing for the parts that depend on the type.
+
+const char recordTemplate[] =
+"struct $name$ {\n"
+"\n"
+"    $name$ ()$initializers$\n"
+"    { }\n"
+"\n"
+"$recordfields$};\n"
+"\n"
+"template <typename Serializer>\n"
+"inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &) {\n"
+"    s.writeRecord();\n"
+"$serializefields$\n"
+"}\n"
+"\n"
+"$encodedsize$"
+"\n"
+"template <typename Parser>\n"
+"inline void parse(Parser &p, $name$ &val, const boost::true_type &) {\n"
+"    p.readRecord();\n"
+"$parsefields$\n"
+"}\n"
+"\n"
+"class $name$_Layout : public avro::CompoundLayout {\n"
+"  public:\n"
+"    $name$_Layout(size_t offset = 0) :\n"
+"        CompoundLayout(offset)\n"
+"    {\n"
+"$offsetlist$    }\n"
+"}; \n";
+
+const char recordSizeTemplate[] =
+"inline size_t encodedSize(const $name$ &val, const boost::true_type &) {\n"
+"    size_t size = 0;\n"
+"$sizefields$    return size;\n"
+"}\n";
+
+const char fixedRecordSizeTemplate[] =
+"inline size_t encodedSize(const $name$ &, const boost::true_type &) {\n"
+"    return $size$;\n"
+"}\n";
+
+const char unionTemplate[] =
+"struct $name$ {\n"
+"\n"
+"$typedeflist$"
+"\n"
+"    $name$() : \n"
+"        choice(0), \n"
+"        value(T0())\n"
+"    { }\n"
+"\n"
+"$setfuncs$"
+"\n"
+"#ifdef AVRO_BOOST_NO_ANYREF\n"
+"    template<typename T>\n"
+"    const T &getValue() const {\n"
+"        const T *ptr = boost::any_cast<T>(&value);\n"
+"        return *ptr;\n"
+"    }\n"
+"#else\n"
+"    template<typename T>\n"
+"    const T &getValue() const {\n"
+"        return boost::any_cast<const T&>(value);\n"
+"    }\n"
+"#endif\n"
+"\n"
+"    static void *genericSet($name$ *u, int64_t choice) {\n"
+"        boost::any *val = &(u->value);\n"
+"        void *data;\n"
+"        switch (choice) {$switch$\n"
+"        }\n"
+"        return data;\n"
+"    }\n"
+"\n"
+"    int64_t choice; \n"
+"    boost::any value;\n"
+"};\n"
+"\n"
+"template <typename Serializer>\n"
+"inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &) {\n"
+"    s.writeUnion(val.choice);\n"
+"    switch(val.choice) {\n"
+"$switchserialize$\n"
+"    default :\n"
+"        throw avro::Exception(\"Unrecognized union choice\");\n"
+"    }\n"
+"}\n"
+"\n"
+"inline size_t encodedSize(const $name$ &val, const boost::true_type &) {\n"
+"    size_t size = avro::encodedInt64Size(val.choice);\n"
+"    switch(val.choice) {\n"
+"$switchsize$\n"
+"    default :\n"
+"        throw avro::Exception(\"Unrecognized union choice\");\n"
+"    }\n"
+"    return size;\n"
+"}\n"
+"\n"
+"template <typename Parser>\n"
+"inline void parse(Parser &p, $name$ &val, const boost::true_type &) {\n"
+"    val.choice = p.readUnion();\n"
+"    switch(val.choice) {\n"
+"$switchparse$\n"
+"    default :\n"
+"        throw avro::Exception(\"Unrecognized union choice\");\n"
+"    }\n"
+"}\n"
+"\n"
+"class $name$_Layout : public avro::CompoundLayout {\n"
+"  public:\n"
+"    static uint8_t *setter(uint8_t *u, int64_t choice) {\n"
+"        return static_cast<uint8_t *>($name$::genericSet(reinterpret_cast<$name$ *>(u), choice));\n"
+"    }\n"
+"\n"
+"    $name$_Layout(size_t offset = 0) :\n"
+"        CompoundLayout(offset)\n"
+"    {\n"
+"        add(new avro::PrimitiveLayout(offset + offsetof($name$, choice)));\n"
+"        add(new avro::UnionSetterLayout(&$name$_Layout::setter));\n"
+"$offsetlist$    }\n"
+"}; \n";
+
+const char unionBranchTemplate[] =
+"      case $N$:\n"
+"        $action$\n"
+"        break;\n";
+
+const char unionSetTemplate[] =
+"    void set_$branch$(const $type$ &val) {\n"
+"        choice = $N$;\n"
+"        value =  val;\n"
+"    };\n";
+
+const char unionSwitchTemplate[] =
+"\n"
+"          case $N$:\n"
+"            *val = T$N$();\n"
+"            data = boost::any_cast<T$N$>(val);\n"
+"            break;";
+
+const char enumTemplate[] =
+"struct $name$ {\n"
+"\n"
+"    enum EnumSymbols {\n"
+"        $enumsymbols$\n"
+"    };\n"
+"\n"
+"    $name$() : \n"
+"        value($firstsymbol$) \n"
+"    { }\n"
+"\n"
+"    EnumSymbols value;\n"
+"};\n"
+"\n"
+"template <typename Serializer>\n"
+"inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &) {\n"
+"    s.writeEnum(val.value);\n"
+"}\n"
+"\n"
+"inline size_t encodedSize(const $name$ &val, const boost::true_type &) {\n"
+"    return avro::encodedInt64Size(val.value);\n"
+"}\n"
+"\n"
+"template <typename Parser>\n"
+"inline void parse(Parser &p, $name$ &val, const boost::true_type &) {\n"
+"    val.value = static_cast<$name$::EnumSymbols>(p.readEnum());\n"
+"}\n"
+"\n"
+"class $name$_Layout : public avro::CompoundLayout {\n"
+"  public:\n"
+"    $name$_Layout(size_t offset = 0) :\n"
+"        CompoundLayout(offset)\n"
+"    {\n"
+"        add(new avro::PrimitiveLayout(offset + offsetof($name$, value)));\n"
+"    }\n"
+"}; \n";
+
+const char arrayTemplate[] =
+"struct $name$ {\n"
+"    typedef $valuetype$ ValueType;\n"
+"    typedef std::vector<ValueType> ArrayType;\n"
+"    \n"
+"    $name$() :\n"
+"        value()\n"
+"    { }\n"
+"\n"
+"    static ValueType *genericSet($name$ *array) {\n"
+"        array->value.push_back(ValueType());\n"
+"        return &array->value.back();\n"
+"    }\n"
+"\n"
+"    void addValue(const ValueType &val) {\n"
+"        value.push_back(val);\n"
+"    }\n"
+"\n"
+"    ArrayType value;\n"
+"};\n"
+"\n"
+"template <typename Serializer>\n"
+"inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &) {\n"
+"    const size_t size = val.value.size();\n"
+"    if(size) {\n"
+"        s.writeArrayBlock(size);\n"
+"        for(size_t i = 0; i < size; ++i) {\n"
+"            serialize(s, val.value[i]);\n"
+"        }\n"
+"    }\n"
+"    s.writeArrayEnd();\n"
+"}\n"
+"\n"
+"inline size_t encodedSize(const $name$ &val, const boost::true_type &) {\n"
+"    const size_t count = val.value.size();\n"
+"    size_t size = 1;\n"
+"    if(count) {\n"
+"        size += avro::encodedInt64Size(count);\n"
+"        for(size_t i = 0; i < count; ++i) {\n"
+"            size += $itemsize$;\n"
+"        }\n"
+"    }\n"
+"    return size;\n"
+"}\n"
+"\n"
+"template <typename Parser>\n"
+"inline void parse(Parser &p, $name$ &val, const boost::true_type &) {\n"
+"    val.value.clear();\n"
+"    while(1) {\n"
+"        int size = p.readArrayBlockSize();\n"
+"        if(size > 0) {\n"
+"            val.value.reserve(val.value.size() + size);\n"
+"            while (size-- > 0) { \n"
+"                val.value.push_back($name$::ValueType());\n"
+"                parse(p, val.value.back());\n"
+"            }\n"
+"        }\n"
+"        else {\n"
+"            break;\n"
+"        }\n"
+"    } \n"
+"}\n"
+"\n"
+"class $name$_Layout : public avro::CompoundLayout {\n"
+"  public:\n"
+"    static uint8_t *setter(uint8_t *array) {\n"
+"        return reinterpret_cast<uint8_t *>($name$::genericSet(reinterpret_cast<$name$ *>(array)));\n"
+"    }\n"
+"\n"
+"    $name$_Layout(size_t offset = 0) :\n"
+"        CompoundLayout(offset)\n"
+"    {\n"
+"        add(new avro::ArraySetterLayout(&$name$_Layout::setter));\n"
+"$offsetlist$    }\n"
+"}; \n";
+
+const char mapTemplate[] =
+"struct $name$ {\n"
+"    typedef $valuetype$ ValueType;\n"
+"    typedef std::map<std::string, ValueType> MapType;\n"
+"    \n"
+"    $name$() :\n"
+"        value()\n"
+"    { }\n"
+"\n"
+"    void addValue(const std::string &key, const ValueType &val) {\n"
+"        value.insert(MapType::value_type(key, val));\n"
+"    }\n"
+"\n"
+"    static ValueType *genericSet($name$ *map, const std::string &key) { \n"
+"        ValueType &val = map->value[key];\n"
+"        val = ValueType();\n"
+"        return &val;\n"
+"    }\n"
+"\n"
+"    MapType value;\n"
+"};\n"
+"\n"
+"template <typename Serializer>\n"
+"inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &) {\n"
+"    if(val.value.size()) {\n"
+"        s.writeMapBlock(val.value.size());\n"
+"        $name$::MapType::const_iterator iter = val.value.begin();\n"
+"        $name$::MapType::const_iterator end  = val.value.end();\n"
+"        while(iter!=end) {\n"
+"            serialize(s, iter->first);\n"
+"            serialize(s, iter->second);\n"
+"            ++iter;\n"
+"        }\n"
+"    }\n"
+"    s.writeMapEnd();\n"
+"}\n"
+"\n"
+"inline size_t encodedSize(const $name$ &val, const boost::true_type &) {\n"
+"    size_t size = 1;\n"
+"    if(val.value.size()) {\n"
+"        size += avro::encodedInt64Size(val.value.size());\n"
+"        $name$::MapType::const_iterator iter = val.value.begin();\n"
+"        $name$::MapType::const_iterator end  = val.value.end();\n"
+"        while(iter!=end) {\n"
+"            size += avro::encodedSize(iter->first);\n"
+"            size += $itemsize$;\n"
+"            ++iter;\n"
+"        }\n"
+"    }\n"
+"    return size;\n"
+"}\n"
+"\n"
+"template <typename Parser>\n"
+"inline void parse(Parser &p, $name$ &val, const boost::true_type &) {\n"
+"    val.value.clear();\n"
+"    std::string key;\n"
+"    while(1) {\n"
+"        int size = p.readMapBlockSize();\n"
+"        if(size > 0) {\n"
+"            while (size-- > 0) { \n"
+"                parse(p, key);\n"
+"                parse(p, val.value[key]);\n"
+"            }\n"
+"        }\n"
+"        else {\n"
+"            break;\n"
+"        }\n"
+"    } \n"
+"}\n"
+"\n"
+"class $name$_Layout : public avro::CompoundLayout {\n"
+"  public:\n"
+"    static uint8_t *setter(uint8_t *map, const std::string &key) {\n"
+"        return reinterpret_cast<uint8_t *>($name$::genericSet(reinterpret_cast<$name$ *>(map), key));\n"
+"    }\n"
+"\n"
+"    $name$_Layout(size_t offset = 0) :\n"
+"        CompoundLayout(offset)\n"
+"    {\n"
+"        add(new avro::MapSetterLayout(&$name$_Layout::setter));\n"
+"$offsetlist$    }\n"
+"}; \n";
+
+const char fixedTemplate[] =
+"struct $name$ {\n"
+"    enum {\n"
+"        fixedSize = $N$\n"
+"    };\n"
+"\n"
+"    $name$() {\n"
+"        memset(value, 0, sizeof(value));\n"
+"    }\n"
+"    \n"
+"    uint8_t value[fixedSize];\n"
+"};\n"
+"\n"
+"template <typename Serializer>\n"
+"inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &) {\n"
+"    s.writeFixed(val.value);\n"
+"}\n"
+"\n"
+"inline size_t encodedSize(const $name$ &, const boost::true_type &) {\n"
+"    return $name$::fixedSize;\n"
+"}\n"
+"\n"
+"template <typename Parser>\n"
+"inline void parse(Parser &p, $name$ &val, const boost::true_type &) {\n"
+"    p.readFixed(val.value);\n"
+"}\n"
+"\n"
+"class $name$_Layout : public avro::CompoundLayout {\n"
+"  public:\n"
+"    $name$_Layout(size_t offset = 0) :\n"
+"        CompoundLayout(offset)\n"
+"    {\n"
+"        add(new avro::PrimitiveLayout(offset + offsetof($name$, value)));\n"
+"    }\n"
+"}; \n";
+
+const char primitiveTemplate[] =
+"struct $name$ {\n"
+"    $type$ value;\n"
+"};\n"
+"\n"
+"template <typename Serializer>\n"
+"inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &) {\n"
+"    s.writeValue(val.value);\n"
+"}\n"
+"\n"
+"inline size_t encodedSize(const $name$ &val, const boost::true_type &) {\n"
+"    return avro::encodedSize(val.value);\n"
+"}\n"
+"\n"
+"template <typename Parser>\n"
+"inline void parse(Parser &p, $name$ &val, const boost::true_type &) {\n"
+"    p.readValue(val.value);\n"
+"}\n"
+"\n"
+"class $name$_Layout : public avro::CompoundLayout {\n"
+"  public:\n"
+"    $name$_Layout(size_t offset = 0) :\n"
+"        CompoundLayout(offset)\n"
+"    {\n"
+"        add(new avro::PrimitiveLayout(offset + offsetof($name$, value)));\n"
+"    }\n"
+"}; \n";
+
+const char traitsTemplate[] =
+"template <> struct schema_traits<$ns$::$name$> {\n"
+"    enum {\n"
+"        fieldCount = $fieldcount$,\n"
+"        isFixedSize = $fixed$,\n"
+"        isBounded = $bounded$,\n"
+"        maxEncodedSize = $maxsize$\n"
+"    };\n"
+"};\n";
+
+const char headers[] =
+"#include <stdint.h>\n"
+"#include <string>\n"
+"#include <vector>\n"
+"#include <map>\n"
+"#include \"Boost.hh\"\n"
+"#include \"Exception.hh\"\n"
+"#include \"AvroSerialize.hh\"\n"
+"#include \"AvroParse.hh\"\n"
+"#include \"AvroSize.hh\"\n"
+"#include \"Layout.hh\"\n";
+
+// Replaces every $key$ in text.
+std::string
+subst(const std::string &text, const std::string &key, const std::string &value)
+{
+    const std::string marker = '$' + key + '$';
+    std::string result;
+    size_t start = 0;
+    size_t found;
+    while((found = text.find(marker, start)) != std::string::npos) {
+        result.append(text, start, found - start);
+        result.append(value);
+        start = found + marker.size();
+    }
+    result.append(text, start, std::string::npos);
+    return result;
+}
+
+std::string
+toString(size_t value)
+{
+    std::ostringstream os;
+    os << value;
+    return os.str();
+}
+
+// A type as the generated code refers to it, with what is known about its
+// encoding.
+struct TypeInfo {
+
+    TypeInfo() :
+        primitive(false),
+        fixedSize(false),
+        bounded(false),
+        maxSize(0)
+    {}
+
+    std::string cppType;
+    std::string name;
+    bool primitive;
+    bool fixedSize;
+    bool bounded;
+    size_t maxSize;
+};
+
+class Generator : private boost::noncopyable
+{
+  public:
+
+    explicit Generator(const std::string &ns) :
+        ns_(ns)
+    {}
+
+    void generate(const NodePtr &root, std::ostream &os) {
+        if(isPrimitive(root->type())) {
+            TypeInfo info = process(root);
+            std::string name = info.name;
+            name[0] = toupper(name[0]);
+            std::string code = subst(primitiveTemplate, "name", name);
+            addStruct(name, subst(code, "type", info.cppType), info, 0);
+        }
+        else {
+            process(root);
+        }
+        write(os);
+    }
+
+  private:
+
+    TypeInfo process(const NodePtr &node) {
+        switch(node->type()) {
+          case AVRO_RECORD:
+            return doRecord(node);
+          case AVRO_ENUM:
+            return doEnum(node);
+          case AVRO_ARRAY:
+            return doArray(node);
+          case AVRO_MAP:
+            return doMap(node);
+          case AVRO_UNION:
+            return doUnion(node);
+          case AVRO_FIXED:
+            return doFixed(node);
+          case AVRO_SYMBOLIC:
+            return doSymbolic(node);
+          default:
+            return doPrimitive(node->type());
+        }
+    }
+
+    TypeInfo doPrimitive(Type type) {
+        static const char *cppTypes[] = {
+            "std::string", "std::vector<uint8_t>", "int32_t", "int64_t", 
+            "float", "double", "bool", "avro::Null" 
+        };
+        static const size_t sizes[] = { 0, 0, 5, 10, 4, 8, 1, 0 };
+
+        TypeInfo info;
+        info.cppType = cppTypes[type];
+        info.name = avro::toString(type);
+        info.primitive = true;
+        info.bounded = (type != AVRO_STRING && type != AVRO_BYTES);
+        info.fixedSize = info.bounded && type != AVRO_INT && type != AVRO_LONG;
+        info.maxSize = sizes[type];
+        return info;
+    }
+
+    TypeInfo named(const std::string &name) {
+        TypeInfo info;
+        info.cppType = name;
+        info.name = name;
+        return info;
+    }
+
+    // A reference to a type defined elsewhere in the schema.  If it is still
+    // being generated the schema is recursive, and it has no bound.
+    TypeInfo doSymbolic(const NodePtr &node) {
+        std::map<std::string, TypeInfo>::const_iterator done = types_.find(node->name());
+        if(done != types_.end()) {
+            return done->second;
+        }
+        std::string declaration = "struct " + node->name() + ";";
+        if(forwardDeclared_.insert(node->name()).second) {
+            forwardDeclarations_.push_back(declaration);
+        }
+        return named(node->name());
+    }
+
+    TypeInfo doRecord(const NodePtr &node) {
+        TypeInfo info = named(node->name());
+        info.fixedSize = true;
+        info.bounded = true;
+
+        std::string initializers, fields, serializeFields, sizeFields, parseFields, offsets;
+        for(size_t i = 0; i < node->leaves(); ++i) {
+            const std::string &field = node->nameAt(i);
+            TypeInfo type = process(node->leafAt(i));
+            initializers += (i ? ",\n        " : " :\n        ") + field + "()";
+            fields += "    " + type.cppType + " " + field + ";\n";
+            serializeFields += "    serialize(s, val." + field + ");\n";
+            sizeFields += "    size += " + sizeOf(type, "val." + field) + ";\n";
+            parseFields += "    parse(p, val." + field + ");\n";
+            offsets += "        add(new " + layout(type) + "(offset + offsetof(" + info.name + ", " + field + ")));\n";
+            info.fixedSize = info.fixedSize && type.fixedSize;
+            info.bounded = info.bounded && type.bounded;
+            info.maxSize = sum(info.maxSize, type.maxSize);
+        }
+        info.bounded = info.bounded && info.maxSize <= INT_MAX;
+        info.fixedSize = info.fixedSize && info.bounded;
+
+        std::string size;
+        if(info.fixedSize) {
+            size = subst(fixedRecordSizeTemplate, "size", toString(info.maxSize));
+        }
+        else {
+            size = subst(recordSizeTemplate, "sizefields", sizeFields);
+        }
+        std::string code = subst(recordTemplate, "encodedsize", size);
+        code = subst(code, "initializers", initializers);
+        code = subst(code, "recordfields", fields);
+        code = subst(code, "serializefields", serializeFields);
+        code = subst(code, "parsefields", parseFields);
+        code = subst(code, "offsetlist", offsets);
+        code = subst(code, "name", info.name);
+        addStruct(info.name, code, info, node->leaves());
+        return info;
+    }
+
+    TypeInfo doEnum(const NodePtr &node) {
+        TypeInfo info = named(node->name());
+        std::string symbols;
+        for(size_t i = 0; i < node->names(); ++i) {
+            symbols += (i ? ", " : "") + node->nameAt(i);
+        }
+        info.bounded = true;
+        info.maxSize = encodedInt64Size(node->names() ? node->names() - 1 : 0);
+        info.fixedSize = (info.maxSize == 1);
+
+        std::string code = subst(enumTemplate, "enumsymbols", symbols);
+        code = subst(code, "firstsymbol", node->names() ? node->nameAt(0) : "");
+        code = subst(code, "name", info.name);
+        addStruct(info.name, code, info, 0);
+        return info;
+    }
+
+    TypeInfo doFixed(const NodePtr &node) {
+        TypeInfo info = named(node->name());
+        info.fixedSize = true;
+        info.bounded = true;
+        info.maxSize = node->fixedSize();
+
+        std::string code = subst(fixedTemplate, "N", toString(info.maxSize));
+        addStruct(info.name, subst(code, "name", info.name), info, 0);
+        return info;
+    }
+
+    TypeInfo doArray(const NodePtr &node) {
+        TypeInfo items = process(node->leafAt(0));
+        TypeInfo info = named("Array_of_" + items.name);
+
+        std::string code = subst(arrayTemplate, "itemsize", sizeOf(items, "val.value[i]"));
+        code = subst(code, "valuetype", items.cppType);
+        code = subst(code, "offsetlist", "        add(new " + layout(items) + ");\n");
+        addStruct(info.name, subst(code, "name", info.name), info, 0);
+        return info;
+    }
+
+    TypeInfo doMap(const NodePtr &node) {
+        TypeInfo values = process(node->leafAt(1));
+        TypeInfo info = named("Map_of_" + values.name);
+
+        std::string code = subst(mapTemplate, "itemsize", sizeOf(values, "iter->second"));
+        code = subst(code, "valuetype", values.cppType);
+        code = subst(code, "offsetlist", "        add(new " + layout(values) + ");\n");
+        addStruct(info.name, subst(code, "name", info.name), info, 0);
+        return info;
+    }
+
+    TypeInfo doUnion(const NodePtr &node) {
+        std::string name = "Union_of";
+        std::string typedefs, setters, switches, serializeCases, sizeCases, parseCases, offsets;
+        bool fixedSize = true;
+        bool bounded = true;
+        size_t minBranch = 0;
+        size_t maxBranch = 0;
+        for(size_t i = 0; i < node->leaves(); ++i) {
+            TypeInfo branch = process(node->leafAt(i));
+            const std::string n = toString(i);
+            name += "_" + branch.name;
+            typedefs += "    typedef " + branch.cppType + " T" + n + ";\n";
+            std::string value = "val.getValue< " + branch.cppType + " >()";
+            std::string cases = subst(unionBranchTemplate, "N", n);
+            serializeCases += subst(cases, "action", "serialize(s, " + value + ");");
+            sizeCases += subst(cases, "action", "size += " + sizeOf(branch, value) + ";");
+            parseCases += subst(cases, "action", 
+                "{ " + branch.cppType + " chosenVal; parse(p, chosenVal); val.value = chosenVal; }");
+            std::string setter = subst(unionSetTemplate, "branch", branch.name);
+            setters += subst(subst(setter, "type", branch.cppType), "N", n);
+            switches += subst(unionSwitchTemplate, "N", n);
+            offsets += "        add(new " + layout(branch) + ");\n";
+
+            fixedSize = fixedSize && branch.fixedSize;
+            bounded = bounded && branch.bounded;
+            minBranch = (i == 0 || branch.maxSize < minBranch) ? branch.maxSize : minBranch;
+            maxBranch = std::max(maxBranch, branch.maxSize);
+        }
+        TypeInfo info = named(name);
+        size_t choiceSize = encodedInt64Size(node->leaves() ? node->leaves() - 1 : 0);
+        info.maxSize = sum(choiceSize, maxBranch);
+        info.bounded = bounded && info.maxSize <= INT_MAX;
+        info.fixedSize = fixedSize && info.bounded && choiceSize == 1 && minBranch == maxBranch;
+
+        std::string code = subst(unionTemplate, "typedeflist", typedefs);
+        code = subst(code, "setfuncs", setters);
+        code = subst(code, "switch", switches);
+        code = subst(code, "switchserialize", serializeCases);
+        code = subst(code, "switchsize", sizeCases);
+        code = subst(code, "switchparse", parseCases);
+        code = subst(code, "offsetlist", offsets);
+        addStruct(info.name, subst(code, "name", info.name), info, 0);
+        return info;
+    }
+
+    // Bounded sizes that would not fit the traits' enum are unbounded.
+    static size_t sum(size_t a, size_t b) {
+        return (a > INT_MAX || b > INT_MAX) ? static_cast<size_t>(INT_MAX) + 1 : a + b;
+    }
+
+    // The generated encodedSize() functions call each other directly, since
+    // the is_serializable traits that avro::encodedSize() dispatches on are
+    // declared at the end of the header.
+    static std::string sizeOf(const TypeInfo &type, const std::string &value) {
+        if(type.primitive) {
+            return "avro::encodedSize(" + value + ")";
+        }
+        return "encodedSize(" + value + ", boost::true_type())";
+    }
+
+    static std::string layout(const TypeInfo &type) {
+        return type.primitive ? "avro::PrimitiveLayout" : type.name + "_Layout";
+    }
+
+    void addStruct(const std::string &name, const std::string &code, 
+                   const TypeInfo &info, size_t fieldCount) {
+        if(types_.insert(std::make_pair(name, info)).second) {
+            structs_.push_back(code);
+            std::string traits = subst(traitsTemplate, "name", name);
+            traits = subst(traits, "fieldcount", toString(fieldCount));
+            traits = subst(traits, "fixed", info.fixedSize ? "1" : "0");
+            traits = subst(traits, "bounded", info.bounded ? "1" : "0");
+            traits = subst(traits, "maxsize", toString(info.bounded ? info.maxSize : 0));
+            traits_.push_back(traits);
+            names_.push_back(name);
+        }
+    }
+
+    void write(std::ostream &os) const {
+        os << "#ifndef " << ns_ << "_AvroGenerated_hh__\n";
+        os << "#define " << ns_ << "_AvroGenerated_hh__\n\n";
+        os << headers << '\n';
+        os << "namespace " << ns_ << " {\n\n";
+        for(size_t i = 0; i < forwardDeclarations_.size(); ++i) {
+            os << forwardDeclarations_[i] << "\n\n";
+        }
+        for(size_t i = 0; i < structs_.size(); ++i) {
+            os << "/*----------------------------------------------------------------------------------*/\n\n";
+            os << structs_[i] << "\n\n";
+        }
+        os << "\n} // namespace " << ns_ << "\n\n";
+
+        os << "namespace avro {\n\n";
+        for(size_t i = 0; i < names_.size(); ++i) {
+            os << "template <> struct is_serializable<" << ns_ << "::" << names_[i] 
+               << "> : public boost::true_type{};\n";
+        }
+        os << '\n';
+        for(size_t i = 0; i < traits_.size(); ++i) {
+            os << subst(traits_[i], "ns", ns_) << '\n';
+        }
+        os << "} // namespace avro\n\n";
+        os << "#endif // " << ns_ << "_AvroGenerated_hh__\n";
+    }
+
+    const std::string ns_;
+    std::map<std::string, TypeInfo> types_;
+    std::vector<std::string> names_;
+    std::vector<std::string> structs_;
+    std::vector<std::string> traits_;
+    std::set<std::string> forwardDeclared_;
+    std::vector<std::string> forwardDeclarations_;
+};
+
+} // namespace
+
+void
+generateCppCode(const ValidSchema &schema, const std::string &ns, std::ostream &os)
+{
+    Generator generator(ns);
+    generator.generate(schema.root(), os);
+}
+
+} // namespace avro
@@ -0,0 +1,346 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <limits>
+
+#include "GenericValue.hh"
+#include "ValidSchema.hh"
+#include "NodeImpl.hh"
+
+namespace avro {
+
+size_t 
+GenericValue::size() const
+{
+    switch(type_) {
+      case AVRO_STRING:
+      case AVRO_BYTES:
+      case AVRO_FIXED:
+        return value_.bytes.size;
+      case AVRO_RECORD:
+      case AVRO_ARRAY:
+        return value_.items.size;
+      case AVRO_MAP:
+        return value_.map.size;
+      default:
+        throw Exception(boost::format("Generic value of type %1% has no size") % type_);
+    }
+}
+
+const GenericValue &
+GenericValue::at(size_t index) const
+{
+    if(type_ != AVRO_RECORD && type_ != AVRO_ARRAY) {
+        throw Exception(boost::format("Generic value of type %1% has no items") % type_);
+    }
+    if(index >= value_.items.size) {
+        throw Exception(boost::format("Index %1% out of range for %2% of size %3%") 
+            % index % type_ % value_.items.size);
+    }
+    return value_.items.values[index];
+}
+
+const GenericValue &
+GenericValue::field(const std::string &name) const
+{
+    check(AVRO_RECORD);
+    size_t index = 0;
+    if(!node_->nameIndex(name, index)) {
+        throw Exception(boost::format("Record %1% has no field %2%") % node_->name() % name);
+    }
+    return value_.items.values[index];
+}
+
+void
+GenericValue::checkEntry(size_t index) const
+{
+    check(AVRO_MAP);
+    if(index >= value_.map.size) {
+        throw Exception(boost::format("Index %1% out of range for %2% of size %3%") 
+            % index % type_ % value_.map.size);
+    }
+}
+
+const GenericValue &
+GenericValue::keyAt(size_t index) const
+{
+    checkEntry(index);
+    return value_.map.keys[index];
+}
+
+const GenericValue &
+GenericValue::valueAt(size_t index) const
+{
+    checkEntry(index);
+    return value_.map.values[index];
+}
+
+namespace {
+
+// Moves the items decoded so far into storage twice as large, the old
+// storage stays in the arena until it is reset.
+GenericValue *
+grow(Arena &arena, GenericValue *values, size_t size, size_t &capacity) 
+{
+    capacity = capacity ? capacity * 2 : 8;
+    GenericValue *grown = arena.allocate<GenericValue>(capacity);
+    if(size) {
+        memcpy(grown, values, size * sizeof(GenericValue));
+    }
+    return grown;
+}
+
+// Whether every value of the type takes at least a byte to encode, so that
+// a count of them cannot be larger than the input left.  A named type
+// referred to again is taken to be a record that does.
+bool
+takesBytes(const NodePtr &node)
+{
+    switch(node->type()) {
+
+      case AVRO_NULL:
+        return false;
+
+      case AVRO_FIXED:
+        return node->fixedSize() > 0;
+
+      case AVRO_RECORD:
+        for(size_t i = 0; i < node->leaves(); ++i) {
+            if(takesBytes(node->leafAt(i))) {
+                return true;
+            }
+        }
+        return false;
+
+      default:
+        return true;
+    }
+}
+
+} // namespace
+
+GenericReader::GenericReader(const ValidSchema &schema, InputStreamer &in) :
+    root_(schema.root()),
+    in_(in),
+    reader_(in)
+{ }
+
+const GenericValue &
+GenericReader::read(Arena &arena)
+{
+    GenericValue *value = arena.allocate<GenericValue>(1);
+    decode(root_, *value, arena);
+    return *value;
+}
+
+void
+GenericReader::decode(const NodePtr &node, GenericValue &value, Arena &arena)
+{
+    if(node->type() == AVRO_SYMBOLIC) {
+        decode(resolveSymbol(node), value, arena);
+        return;
+    }
+
+    value.type_ = node->type();
+    value.node_ = node.get();
+
+    switch(node->type()) {
+
+      case AVRO_STRING:
+      case AVRO_BYTES:
+        decodeBytes(value, arena);
+        break;
+
+      case AVRO_INT:
+        reader_.readValue(value.value_.intValue);
+        break;
+
+      case AVRO_LONG:
+        reader_.readValue(value.value_.longValue);
+        break;
+
+      case AVRO_FLOAT:
+        reader_.readValue(value.value_.floatValue);
+        break;
+
+      case AVRO_DOUBLE:
+        reader_.readValue(value.value_.doubleValue);
+        break;
+
+      case AVRO_BOOL:
+        reader_.readValue(value.value_.boolValue);
+        break;
+
+      case AVRO_NULL:
+        break;
+
+      case AVRO_RECORD:
+      {
+        size_t fields = node->leaves();
+        GenericValue *values = arena.allocate<GenericValue>(fields);
+        for(size_t i = 0; i < fields; ++i) {
+            decode(node->leafAt(i), values[i], arena);
+        }
+        value.value_.items.values = values;
+        value.value_.items.size = fields;
+        break;
+      }
+
+      case AVRO_ENUM:
+      {
+        int64_t index = reader_.readEnum();
+        if(index < 0 || static_cast<size_t>(index) >= node->names()) {
+            throw Exception(boost::format("Enum %1% has no symbol %2%") % node->name() % index);
+        }
+        value.value_.index = static_cast<size_t>(index);
+        break;
+      }
+
+      case AVRO_ARRAY:
+        decodeItems(node, value, arena);
+        break;
+
+      case AVRO_MAP:
+        decodeMap(node, value, arena);
+        break;
+
+      case AVRO_UNION:
+      {
+        int64_t index = reader_.readUnion();
+        if(index < 0 || static_cast<size_t>(index) >= node->leaves()) {
+            throw Exception(boost::format("Union has no branch %1%") % index);
+        }
+        value.value_.branch.index = static_cast<size_t>(index);
+        value.value_.branch.value = arena.allocate<GenericValue>(1);
+        decode(node->leafAt(index), *value.value_.branch.value, arena);
+        break;
+      }
+
+      case AVRO_FIXED:
+      {
+        size_t size = node->fixedSize();
+        uint8_t *data = arena.allocate<uint8_t>(size);
+        reader_.readFixed(data, size);
+        value.value_.bytes.data = data;
+        value.value_.bytes.size = size;
+        break;
+      }
+
+      default:
+        throw Exception(boost::format("Cannot decode generic value of type %1%") % node->type());
+    }
+}
+
+void
+GenericReader::decodeBytes(GenericValue &value, Arena &arena)
+{
+    int64_t size = 0;
+    reader_.readValue(size);
+    if(size < 0) {
+        throw Exception(boost::format("Negative length %1% for %2%") % size % value.type_);
+    }
+    if(static_cast<uint64_t>(size) > in_.remaining()) {
+        throw Exception(boost::format("Length %1% for %2% is longer than the %3% bytes left") 
+            % size % value.type_ % in_.remaining());
+    }
+    uint8_t *data = arena.allocate<uint8_t>(size);
+    reader_.readFixed(data, size);
+    value.value_.bytes.data = data;
+    value.value_.bytes.size = size;
+}
+
+// Returns the number of items in a block.  The storage for them grows as
+// they are decoded, not from the count, so a count the data cannot hold
+// fails on the data before it takes much memory.
+size_t
+GenericReader::blockCount(int64_t count, bool itemsTakeBytes)
+{
+    if(count < 0) {
+        if(count == std::numeric_limits<int64_t>::min()) {
+            throw Exception(boost::format("Bad block count %1%") % count);
+        }
+        // a negative count is followed by the size of the block in bytes
+        count = -count;
+        int64_t bytes = 0;
+        reader_.readValue(bytes);
+    }
+    if(itemsTakeBytes && static_cast<uint64_t>(count) > in_.remaining()) {
+        throw Exception(boost::format("Block of %1% items is longer than the %2% bytes left") 
+            % count % in_.remaining());
+    }
+    return static_cast<size_t>(count);
+}
+
+void
+GenericReader::decodeItems(const NodePtr &node, GenericValue &value, Arena &arena)
+{
+    const NodePtr &items = node->leafAt(0);
+    GenericValue *values = 0;
+    size_t size = 0;
+    size_t capacity = 0;
+
+    const bool itemsTakeBytes = takesBytes(items);
+    int64_t block = 0;
+    while((block = reader_.readArrayBlockSize()) != 0) {
+        size_t count = blockCount(block, itemsTakeBytes);
+        for(size_t i = 0; i < count; ++i) {
+            if(size == capacity) {
+                values = grow(arena, values, size, capacity);
+            }
+            decode(items, values[size++], arena);
+        }
+    }
+
+    value.value_.items.values = values;
+    value.value_.items.size = size;
+}
+
+void
+GenericReader::decodeMap(const NodePtr &node, GenericValue &value, Arena &arena)
+{
+    const NodePtr &keys = node->leafAt(0);
+    const NodePtr &values = node->leafAt(1);
+    GenericValue *keyValues = 0;
+    GenericValue *valueValues = 0;
+    size_t size = 0;
+    size_t keyCapacity = 0;
+    size_t valueCapacity = 0;
+
+    int64_t block = 0;
+    while((block = reader_.readMapBlockSize()) != 0) {
+        // every entry has at least the length of its key
+        size_t count = blockCount(block, true);
+        for(size_t i = 0; i < count; ++i) {
+            if(size == keyCapacity) {
+                keyValues = grow(arena, keyValues, size, keyCapacity);
+                valueValues = grow(arena, valueValues, size, valueCapacity);
+            }
+            decode(keys, keyValues[size], arena);
+            decode(values, valueValues[size], arena);
+            ++size;
+        }
+    }
+
+    value.value_.map.keys = keyValues;
+    value.value_.map.values = valueValues;
+    value.value_.map.size = size;
+}
+
+} // namespace avro
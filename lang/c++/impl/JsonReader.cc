@@ -0,0 +1,603 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits>
+
+#include "JsonReader.hh"
+#include "ValidSchema.hh"
+
+namespace avro {
+
+namespace {
+
+inline bool isSpace(uint8_t c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isDigit(uint8_t c)
+{
+    return c >= '0' && c <= '9';
+}
+
+void appendUtf8(std::string &val, uint32_t cp)
+{
+    if(cp < 0x80) {
+        val.push_back(static_cast<char>(cp));
+    }
+    else if(cp < 0x800) {
+        val.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+        val.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+    else if(cp < 0x10000) {
+        val.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+        val.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+        val.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+    else {
+        val.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+        val.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+        val.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+        val.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+}
+
+} // namespace
+
+JsonReader::JsonReader(const ValidSchema &schema, InputStreamer &in) :
+    table_(schema.validationTable()),
+    in_(in),
+    next_(buffer_.data()),
+    end_(buffer_.data())
+{ }
+
+uint8_t
+JsonReader::nextToken()
+{
+    uint8_t c = get();
+    while(isSpace(c)) {
+        c = get();
+    }
+    return c;
+}
+
+uint8_t
+JsonReader::peekToken()
+{
+    uint8_t c = peek();
+    while(isSpace(c)) {
+        ++next_;
+        c = peek();
+    }
+    return c;
+}
+
+void
+JsonReader::expect(char c)
+{
+    uint8_t found = nextToken();
+    if(found != static_cast<uint8_t>(c)) {
+        throw Exception(boost::format("Expected '%1%' in JSON, found '%2%'") % c % found);
+    }
+}
+
+void
+JsonReader::expectLiteral(const char *literal)
+{
+    expect(*literal);
+    while(*++literal) {
+        if(get() != static_cast<uint8_t>(*literal)) {
+            throw Exception(boost::format("Malformed JSON literal, expected %1%") % literal);
+        }
+    }
+}
+
+uint32_t
+JsonReader::readHex()
+{
+    uint32_t cp = 0;
+    for(int i = 0; i < 4; ++i) {
+        uint8_t c = get();
+        cp <<= 4;
+        if(isDigit(c)) {
+            cp |= c - '0';
+        }
+        else if(c >= 'a' && c <= 'f') {
+            cp |= c - 'a' + 10;
+        }
+        else if(c >= 'A' && c <= 'F') {
+            cp |= c - 'A' + 10;
+        }
+        else {
+            throw Exception(boost::format("Bad hex digit '%1%' in JSON string") % c);
+        }
+    }
+    return cp;
+}
+
+void
+JsonReader::readString(std::string &val)
+{
+    expect('"');
+    val.clear();
+    while(true) {
+        // the characters that need no decoding are copied a run at a time
+        const uint8_t *run = next_;
+        while(next_ != end_ && *next_ != '"' && *next_ != '\\' && *next_ >= 0x20) {
+            ++next_;
+        }
+        val.append(run, next_);
+
+        uint8_t c = get();
+        if(c == '"') {
+            break;
+        }
+        else if(c == '\\') {
+            c = get();
+            switch(c) {
+              case '"':
+              case '\\':
+              case '/':
+                val.push_back(c);
+                break;
+              case 'b':
+                val.push_back('\b');
+                break;
+              case 'f':
+                val.push_back('\f');
+                break;
+              case 'n':
+                val.push_back('\n');
+                break;
+              case 'r':
+                val.push_back('\r');
+                break;
+              case 't':
+                val.push_back('\t');
+                break;
+              case 'u':
+              {
+                uint32_t cp = readHex();
+                if(cp >= 0xd800 && cp < 0xdc00) {
+                    // a surrogate pair
+                    if(get() != '\\' || get() != 'u') {
+                        throw Exception("Unpaired surrogate in JSON string");
+                    }
+                    uint32_t low = readHex();
+                    if(low < 0xdc00 || low >= 0xe000) {
+                        throw Exception("Unpaired surrogate in JSON string");
+                    }
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                }
+                appendUtf8(val, cp);
+                break;
+              }
+              default:
+                throw Exception(boost::format("Bad escape '\\%1%' in JSON string") % c);
+            }
+        }
+        else if(c < 0x20) {
+            throw Exception("Control character in JSON string");
+        }
+        else {
+            val.push_back(c);
+        }
+    }
+}
+
+void
+JsonReader::readByteString(std::vector<uint8_t> &val)
+{
+    readString(scratch_);
+    val.clear();
+    val.reserve(scratch_.size());
+    for(size_t i = 0; i < scratch_.size(); ++i) {
+        uint8_t c = scratch_[i];
+        if(c < 0x80) {
+            val.push_back(c);
+        }
+        else if((c & 0xe0) == 0xc0 && i + 1 < scratch_.size()) {
+            uint32_t cp = ((c & 0x1f) << 6) | (static_cast<uint8_t>(scratch_[++i]) & 0x3f);
+            if(cp > 0xff) {
+                throw Exception(boost::format("Character U+%04x is not a byte") % cp);
+            }
+            val.push_back(static_cast<uint8_t>(cp));
+        }
+        else {
+            throw Exception("Character in JSON bytes is not a byte");
+        }
+    }
+}
+
+int64_t
+JsonReader::readInteger(int64_t min, int64_t max)
+{
+    uint8_t c = nextToken();
+    bool negative = (c == '-');
+    if(negative) {
+        c = get();
+    }
+    if(!isDigit(c)) {
+        throw Exception(boost::format("Expected a number in JSON, found '%1%'") % c);
+    }
+
+    uint64_t magnitude = c - '0';
+    while(isDigit(peek())) {
+        uint64_t digit = get() - '0';
+        if(magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+            throw Exception("Integer in JSON is too large");
+        }
+        magnitude = magnitude * 10 + digit;
+    }
+
+    uint64_t limit = negative ? static_cast<uint64_t>(-(min + 1)) + 1 : static_cast<uint64_t>(max);
+    if(magnitude > limit) {
+        throw Exception("Integer in JSON is out of range");
+    }
+    return negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+}
+
+double
+JsonReader::readNumber()
+{
+    if(peekToken() == '"') {
+        readString(scratch_);
+        if(scratch_ == "NaN") {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        else if(scratch_ == "Infinity") {
+            return std::numeric_limits<double>::infinity();
+        }
+        else if(scratch_ == "-Infinity") {
+            return -std::numeric_limits<double>::infinity();
+        }
+        throw Exception(boost::format("Expected a number in JSON, found \"%1%\"") % scratch_);
+    }
+
+    char digits[64];
+    size_t size = 0;
+    while(size < sizeof(digits) - 1) {
+        uint8_t c = peek();
+        if(!(isDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')) {
+            break;
+        }
+        digits[size++] = get();
+    }
+    digits[size] = 0;
+
+    char *end = 0;
+    double val = strtod(digits, &end);
+    if(size == 0 || end != digits + size) {
+        throw Exception(boost::format("Malformed number %1% in JSON") % digits);
+    }
+    return val;
+}
+
+size_t
+JsonReader::beginValue(Type type)
+{
+    size_t index = ValidationTable::ROOT;
+
+    if(!stack_.empty()) {
+        Frame &frame = stack_.back();
+        const Entry &parent = table_->entry(frame.entry);
+
+        switch(parent.type) {
+
+          case AVRO_RECORD:
+          {
+            if(frame.pos) {
+                expect(',');
+            }
+            readString(scratch_);
+            const std::string &name = parent.node->nameAt(frame.pos);
+            if(scratch_ != name) {
+                throw Exception(boost::format("Expected field %1% of record %2% in JSON, found %3%") 
+                    % name % parent.node->name() % scratch_);
+            }
+            expect(':');
+            index = table_->leafAt(parent, frame.pos++);
+            break;
+          }
+
+          case AVRO_ARRAY:
+            if(frame.remaining <= 0) {
+                throw Exception("Array block has no more items");
+            }
+            index = table_->leafAt(parent, 0);
+            break;
+
+          case AVRO_MAP:
+            if(frame.key) {
+                if(frame.remaining <= 0) {
+                    throw Exception("Map block has no more entries");
+                }
+                index = table_->leafAt(parent, 0);
+            }
+            else {
+                index = table_->leafAt(parent, 1);
+            }
+            break;
+
+          case AVRO_UNION:
+            if(frame.pos++) {
+                throw Exception("Union already has its value");
+            }
+            index = table_->leafAt(parent, frame.remaining);
+            break;
+
+          default:
+            assert(0);
+        }
+    }
+
+    const Entry &entry = table_->entry(index);
+    if(!(entry.flags & ValidationTable::typeToFlag(type))) {
+        throw Exception(boost::format("Type %1% does not match schema, which expects %2%") % type % entry.type);
+    }
+    return index;
+}
+
+void
+JsonReader::endValue()
+{
+    while(!stack_.empty()) {
+        Frame &frame = stack_.back();
+        const Entry &entry = table_->entry(frame.entry);
+
+        switch(entry.type) {
+
+          case AVRO_RECORD:
+            if(frame.pos < entry.leaves) {
+                return;
+            }
+            expect('}');
+            stack_.pop_back();
+            break;
+
+          case AVRO_ARRAY:
+            --frame.remaining;
+            return;
+
+          case AVRO_MAP:
+            if(frame.key) {
+                expect(':');
+                frame.key = false;
+            }
+            else {
+                frame.key = true;
+                --frame.remaining;
+            }
+            return;
+
+          case AVRO_UNION:
+            if(frame.wrapped) {
+                expect('}');
+            }
+            stack_.pop_back();
+            break;
+
+          default:
+            assert(0);
+        }
+    }
+}
+
+void
+JsonReader::readValue(Null &)
+{
+    beginValue(AVRO_NULL);
+    expectLiteral("null");
+    endValue();
+}
+
+void
+JsonReader::readValue(bool &val)
+{
+    beginValue(AVRO_BOOL);
+    if(peekToken() == 't') {
+        expectLiteral("true");
+        val = true;
+    }
+    else {
+        expectLiteral("false");
+        val = false;
+    }
+    endValue();
+}
+
+void
+JsonReader::readValue(int32_t &val)
+{
+    beginValue(AVRO_INT);
+    val = static_cast<int32_t>(readInteger(std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()));
+    endValue();
+}
+
+void
+JsonReader::readValue(int64_t &val)
+{
+    beginValue(AVRO_LONG);
+    val = readInteger(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max());
+    endValue();
+}
+
+void
+JsonReader::readValue(float &val)
+{
+    beginValue(AVRO_FLOAT);
+    val = static_cast<float>(readNumber());
+    endValue();
+}
+
+void
+JsonReader::readValue(double &val)
+{
+    beginValue(AVRO_DOUBLE);
+    val = readNumber();
+    endValue();
+}
+
+void
+JsonReader::readValue(std::string &val)
+{
+    const Entry &entry = table_->entry(beginValue(AVRO_STRING));
+    if(entry.type == AVRO_BYTES) {
+        readByteString(scratchBytes_);
+        val.assign(scratchBytes_.begin(), scratchBytes_.end());
+    }
+    else {
+        readString(val);
+    }
+    endValue();
+}
+
+void
+JsonReader::readBytes(std::vector<uint8_t> &val)
+{
+    beginValue(AVRO_BYTES);
+    readByteString(val);
+    endValue();
+}
+
+void
+JsonReader::readFixed(uint8_t *val, size_t size)
+{
+    const Entry &entry = table_->entry(beginValue(AVRO_FIXED));
+    if(static_cast<size_t>(entry.fixedSize) != size) {
+        throw Exception("Wrong size of for fixed");
+    }
+    readByteString(scratchBytes_);
+    if(scratchBytes_.size() != size) {
+        throw Exception(boost::format("Fixed of size %1% has %2% bytes in JSON") % size % scratchBytes_.size());
+    }
+    if(size) {
+        memcpy(val, &scratchBytes_[0], size);
+    }
+    endValue();
+}
+
+void
+JsonReader::readRecord()
+{
+    Frame frame = { beginValue(AVRO_RECORD), 0, 0, false, false };
+    expect('{');
+    stack_.push_back(frame);
+    // a record without fields is already complete
+    endValue();
+}
+
+int64_t
+JsonReader::nextBlock(Type type, char open, char close)
+{
+    if(!stack_.empty()) {
+        Frame &top = stack_.back();
+        if(table_->entry(top.entry).type == type && top.remaining == 0 && (type != AVRO_MAP || top.key)) {
+            // the next item of the array or map that is open
+            if(peekToken() == static_cast<uint8_t>(close)) {
+                get();
+                stack_.pop_back();
+                endValue();
+                return 0;
+            }
+            expect(',');
+            top.remaining = 1;
+            return 1;
+        }
+    }
+
+    Frame frame = { beginValue(type), 0, 1, true, false };
+    expect(open);
+    if(peekToken() == static_cast<uint8_t>(close)) {
+        get();
+        endValue();
+        return 0;
+    }
+    stack_.push_back(frame);
+    return 1;
+}
+
+int64_t
+JsonReader::readArrayBlockSize()
+{
+    return nextBlock(AVRO_ARRAY, '[', ']');
+}
+
+int64_t
+JsonReader::readMapBlockSize()
+{
+    return nextBlock(AVRO_MAP, '{', '}');
+}
+
+int64_t
+JsonReader::readUnion()
+{
+    size_t index = beginValue(AVRO_UNION);
+    const Entry &entry = table_->entry(index);
+    Frame frame = { index, 0, -1, false, false };
+
+    if(peekToken() == 'n') {
+        for(size_t i = 0; i < entry.leaves; ++i) {
+            if(table_->entry(table_->leafAt(entry, i)).type == AVRO_NULL) {
+                frame.remaining = i;
+                break;
+            }
+        }
+        if(frame.remaining < 0) {
+            throw Exception("Union has no null branch");
+        }
+    }
+    else {
+        expect('{');
+        readString(scratch_);
+        for(size_t i = 0; i < entry.leaves; ++i) {
+            const Entry &branch = table_->entry(table_->leafAt(entry, i));
+            const std::string &name = branch.node->hasName() ? branch.node->name() : toString(branch.type);
+            if(scratch_ == name) {
+                frame.remaining = i;
+                break;
+            }
+        }
+        if(frame.remaining < 0) {
+            throw Exception(boost::format("Union has no branch %1%") % scratch_);
+        }
+        expect(':');
+        frame.wrapped = true;
+    }
+
+    stack_.push_back(frame);
+    return frame.remaining;
+}
+
+int64_t
+JsonReader::readEnum()
+{
+    const Entry &entry = table_->entry(beginValue(AVRO_ENUM));
+    readString(scratch_);
+    size_t symbol = 0;
+    if(!entry.node->nameIndex(scratch_, symbol)) {
+        throw Exception(boost::format("Enum %1% has no symbol %2%") % entry.node->name() % scratch_);
+    }
+    endValue();
+    return symbol;
+}
+
+} // namespace avro
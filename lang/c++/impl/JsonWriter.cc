@@ -0,0 +1,484 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <limits>
+
+#include "JsonWriter.hh"
+#include "ValidSchema.hh"
+#include "OutputStreamer.hh"
+
+namespace avro {
+
+JsonWriter::JsonWriter(const ValidSchema &schema, OutputStreamer &out) :
+    table_(schema.validationTable()),
+    out_(out),
+    used_(0)
+{ }
+
+JsonWriter::~JsonWriter()
+{
+    flush();
+}
+
+void
+JsonWriter::flush()
+{
+    if(used_) {
+        out_.writeBytes(buffer_, used_);
+        used_ = 0;
+    }
+}
+
+void
+JsonWriter::put(const char *chars, size_t size)
+{
+    if(size > sizeof(buffer_) - used_) {
+        flush();
+        if(size >= sizeof(buffer_)) {
+            out_.writeBytes(chars, size);
+            return;
+        }
+    }
+    memcpy(buffer_ + used_, chars, size);
+    used_ += size;
+}
+
+size_t
+JsonWriter::beginValue(Type type)
+{
+    size_t index = ValidationTable::ROOT;
+
+    if(!stack_.empty()) {
+        Frame &frame = stack_.back();
+        const Entry &parent = table_->entry(frame.entry);
+
+        switch(parent.type) {
+
+          case AVRO_RECORD:
+            put(frame.pos ? ",\"" : "\"", frame.pos ? 2 : 1);
+            put(parent.node->nameAt(frame.pos).c_str(), parent.node->nameAt(frame.pos).size());
+            put("\":", 2);
+            index = table_->leafAt(parent, frame.pos++);
+            break;
+
+          case AVRO_ARRAY:
+            if(frame.remaining <= 0) {
+                throw Exception("Array block has no more items");
+            }
+            if(frame.pos++) {
+                put(',');
+            }
+            index = table_->leafAt(parent, 0);
+            break;
+
+          case AVRO_MAP:
+            if(frame.key) {
+                if(frame.remaining <= 0) {
+                    throw Exception("Map block has no more entries");
+                }
+                if(frame.pos++) {
+                    put(',');
+                }
+                index = table_->leafAt(parent, 0);
+            }
+            else {
+                index = table_->leafAt(parent, 1);
+            }
+            break;
+
+          case AVRO_UNION:
+            if(frame.pos++) {
+                throw Exception("Union already has its value");
+            }
+            index = table_->leafAt(parent, frame.remaining);
+            break;
+
+          default:
+            assert(0);
+        }
+    }
+
+    const Entry &entry = table_->entry(index);
+    if(!(entry.flags & ValidationTable::typeToFlag(type))) {
+        throw Exception(boost::format("Type %1% does not match schema, which expects %2%") % type % entry.type);
+    }
+    return index;
+}
+
+void
+JsonWriter::endValue()
+{
+    while(!stack_.empty()) {
+        Frame &frame = stack_.back();
+        const Entry &entry = table_->entry(frame.entry);
+
+        switch(entry.type) {
+
+          case AVRO_RECORD:
+            if(frame.pos < entry.leaves) {
+                return;
+            }
+            put('}');
+            stack_.pop_back();
+            break;
+
+          case AVRO_ARRAY:
+            --frame.remaining;
+            return;
+
+          case AVRO_MAP:
+            if(frame.key) {
+                put(':');
+                frame.key = false;
+            }
+            else {
+                frame.key = true;
+                --frame.remaining;
+            }
+            return;
+
+          case AVRO_UNION:
+            if(frame.wrapped) {
+                put('}');
+            }
+            stack_.pop_back();
+            break;
+
+          default:
+            assert(0);
+        }
+    }
+
+    // the datum is complete
+    put('\n');
+    flush();
+}
+
+void
+JsonWriter::writeEscaped(uint8_t c)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    switch(c) {
+      case '"':
+        put("\\\"", 2);
+        break;
+      case '\\':
+        put("\\\\", 2);
+        break;
+      case '\n':
+        put("\\n", 2);
+        break;
+      case '\r':
+        put("\\r", 2);
+        break;
+      case '\t':
+        put("\\t", 2);
+        break;
+      case '\b':
+        put("\\b", 2);
+        break;
+      case '\f':
+        put("\\f", 2);
+        break;
+      default:
+        {
+            char escaped[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+            put(escaped, sizeof(escaped));
+        }
+    }
+}
+
+void
+JsonWriter::writeString(const char *val, size_t size)
+{
+    put('"');
+    // copy runs of characters that need no escaping in one go
+    const char *run = val;
+    const char *end = val + size;
+    for(const char *next = val; next != end; ++next) {
+        uint8_t c = static_cast<uint8_t>(*next);
+        if(c < 0x20 || c == '"' || c == '\\') {
+            put(run, next - run);
+            writeEscaped(c);
+            run = next + 1;
+        }
+    }
+    put(run, end - run);
+    put('"');
+}
+
+void
+JsonWriter::writeByteString(const uint8_t *val, size_t size)
+{
+    put('"');
+    for(size_t i = 0; i < size; ++i) {
+        uint8_t c = val[i];
+        if(c >= 0x80) {
+            // the code point U+0080 to U+00FF, in UTF-8
+            put(static_cast<char>(0xc0 | (c >> 6)));
+            put(static_cast<char>(0x80 | (c & 0x3f)));
+        }
+        else if(c < 0x20 || c == '"' || c == '\\') {
+            writeEscaped(c);
+        }
+        else {
+            put(static_cast<char>(c));
+        }
+    }
+    put('"');
+}
+
+void
+JsonWriter::writeLong(int64_t val)
+{
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    char *start = end;
+
+    uint64_t magnitude = val < 0 ? 0 - static_cast<uint64_t>(val) : static_cast<uint64_t>(val);
+    do {
+        *--start = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while(magnitude);
+    if(val < 0) {
+        *--start = '-';
+    }
+    put(start, end - start);
+}
+
+void
+JsonWriter::writeDouble(double val, int precision)
+{
+    if(val != val) {
+        writeString("NaN", 3);
+    }
+    else if(val == std::numeric_limits<double>::infinity()) {
+        writeString("Infinity", 8);
+    }
+    else if(val == -std::numeric_limits<double>::infinity()) {
+        writeString("-Infinity", 9);
+    }
+    else {
+        // enough digits for the value to be read back exactly
+        char digits[32];
+        int size = snprintf(digits, sizeof(digits), "%.*g", precision, val);
+        put(digits, size);
+    }
+}
+
+void
+JsonWriter::writeValue(const Null &)
+{
+    beginValue(AVRO_NULL);
+    put("null", 4);
+    endValue();
+}
+
+void
+JsonWriter::writeValue(bool val)
+{
+    beginValue(AVRO_BOOL);
+    if(val) {
+        put("true", 4);
+    }
+    else {
+        put("false", 5);
+    }
+    endValue();
+}
+
+void
+JsonWriter::writeValue(int32_t val)
+{
+    beginValue(AVRO_INT);
+    writeLong(val);
+    endValue();
+}
+
+void
+JsonWriter::writeValue(int64_t val)
+{
+    beginValue(AVRO_LONG);
+    writeLong(val);
+    endValue();
+}
+
+void
+JsonWriter::writeValue(float val)
+{
+    beginValue(AVRO_FLOAT);
+    writeDouble(val, 9);
+    endValue();
+}
+
+void
+JsonWriter::writeValue(double val)
+{
+    beginValue(AVRO_DOUBLE);
+    writeDouble(val, 17);
+    endValue();
+}
+
+void
+JsonWriter::writeValue(const std::string &val)
+{
+    writeValue(View(reinterpret_cast<const uint8_t *>(val.data()), val.size()));
+}
+
+void
+JsonWriter::writeValue(const View &val)
+{
+    const Entry &entry = table_->entry(beginValue(AVRO_STRING));
+    if(entry.type == AVRO_BYTES) {
+        writeByteString(val.data, val.size);
+    }
+    else {
+        writeString(reinterpret_cast<const char *>(val.data), val.size);
+    }
+    endValue();
+}
+
+void
+JsonWriter::writeBytes(const void *val, size_t size)
+{
+    beginValue(AVRO_BYTES);
+    writeByteString(static_cast<const uint8_t *>(val), size);
+    endValue();
+}
+
+void
+JsonWriter::writeFixed(const uint8_t *val, size_t size)
+{
+    const Entry &entry = table_->entry(beginValue(AVRO_FIXED));
+    if(static_cast<size_t>(entry.fixedSize) != size) {
+        throw Exception("Wrong size of for fixed");
+    }
+    writeByteString(val, size);
+    endValue();
+}
+
+void
+JsonWriter::writeRecord()
+{
+    Frame frame = { beginValue(AVRO_RECORD), 0, 0, false, false };
+    put('{');
+    stack_.push_back(frame);
+    // a record without fields is already complete
+    endValue();
+}
+
+void
+JsonWriter::beginBlock(Type type, int64_t size)
+{
+    if(size < 0) {
+        throw Exception(boost::format("Negative block size %1%") % size);
+    }
+
+    if(!stack_.empty()) {
+        Frame &top = stack_.back();
+        if(table_->entry(top.entry).type == type && top.remaining == 0 && (type != AVRO_MAP || top.key)) {
+            // another block of the array or map that is open
+            top.remaining = size;
+            return;
+        }
+    }
+
+    Frame frame = { beginValue(type), 0, size, true, false };
+    put(type == AVRO_ARRAY ? '[' : '{');
+    stack_.push_back(frame);
+}
+
+void
+JsonWriter::endBlocks(Type type, char close)
+{
+    if(!stack_.empty()) {
+        Frame &top = stack_.back();
+        if(table_->entry(top.entry).type == type && top.remaining == 0 && (type != AVRO_MAP || top.key)) {
+            put(close);
+            stack_.pop_back();
+            endValue();
+            return;
+        }
+    }
+
+    // an array or map without any blocks
+    beginValue(type);
+    put(type == AVRO_ARRAY ? '[' : '{');
+    put(close);
+    endValue();
+}
+
+void
+JsonWriter::writeArrayBlock(int64_t size)
+{
+    beginBlock(AVRO_ARRAY, size);
+}
+
+void
+JsonWriter::writeArrayEnd()
+{
+    endBlocks(AVRO_ARRAY, ']');
+}
+
+void
+JsonWriter::writeMapBlock(int64_t size)
+{
+    beginBlock(AVRO_MAP, size);
+}
+
+void
+JsonWriter::writeMapEnd()
+{
+    endBlocks(AVRO_MAP, '}');
+}
+
+void
+JsonWriter::writeUnion(int64_t choice)
+{
+    size_t index = beginValue(AVRO_UNION);
+    const Entry &entry = table_->entry(index);
+    if(choice < 0 || static_cast<size_t>(choice) >= entry.leaves) {
+        throw Exception("Union out of range");
+    }
+
+    const Entry &branch = table_->entry(table_->leafAt(entry, choice));
+    Frame frame = { index, 0, choice, false, branch.type != AVRO_NULL };
+    if(frame.wrapped) {
+        put('{');
+        writeString(branch.node->hasName() ? branch.node->name() : toString(branch.type));
+        put(':');
+    }
+    stack_.push_back(frame);
+}
+
+void
+JsonWriter::writeEnum(int64_t choice)
+{
+    const Entry &entry = table_->entry(beginValue(AVRO_ENUM));
+    if(choice < 0 || static_cast<size_t>(choice) >= entry.node->names()) {
+        throw Exception("Enum out of range");
+    }
+    writeString(entry.node->nameAt(choice));
+    endValue();
+}
+
+} // namespace avro
@@ -31,7 +31,7 @@ NodeImpl<A,B,C,D>::furtherResolution(const Node &reader) const
     if(reader.type() == AVRO_SYMBOLIC) {
     
         // resolve the symbolic type, and check again
-        const NodePtr &node = reader.leafAt(0);
+        const NodePtr node = static_cast<const NodeSymbolic &>(reader).getNode();
         match = resolve(*node);
     }
     else if(reader.type() == AVRO_UNION) {
@@ -182,10 +182,39 @@ NodeFixed::resolve(const Node &reader) const
 SchemaResolution 
 NodeSymbolic::resolve(const Node &reader) const
 {
-    const NodePtr &node = leafAt(0);
+    const NodePtr node = getNode();
     return node->resolve(reader);
 }
 
+// asumes the writer is NOT a union, and the reader IS a union
+
+SchemaResolution    
+checkUnionMatch(const NodePtr &writer, const NodePtr &reader, size_t &index)
+{
+    SchemaResolution bestMatch = RESOLVE_NO_MATCH;
+ 
+    index = 0;
+    size_t leaves = reader->leaves();
+
+    for(size_t i=0; i < leaves; ++i) {
+
+        const NodePtr &leaf = reader->leafAt(i);
+        SchemaResolution newMatch = writer->resolve(*leaf);
+
+        if(newMatch == RESOLVE_MATCH) {
+            bestMatch = newMatch;
+            index = i;
+            break;
+        }
+        if(bestMatch == RESOLVE_NO_MATCH) {
+            bestMatch = newMatch;
+            index = i;
+        }
+    }
+
+    return bestMatch;
+}
+
 // Wrap an indentation in a struct for ostream operator<< 
 struct indent { 
     indent(int depth) :
@@ -316,4 +345,82 @@ NodeFixed::printJson(std::ostream &os, int depth) const
     os << indent(--depth) << '}';
 }
 
+void 
+NodePrimitive::printCanonicalJson(std::ostream &os) const
+{
+    os << '\"' << type() << '\"';
+}
+
+void 
+NodeSymbolic::printCanonicalJson(std::ostream &os) const
+{
+    os << '\"' << nameAttribute_.get() << '\"';
+}
+
+void 
+NodeRecord::printCanonicalJson(std::ostream &os) const
+{
+    os << "{\"name\":\"" << nameAttribute_.get() << "\",\"type\":\"record\",\"fields\":[";
+    int fields = leafAttributes_.size();
+    for(int i = 0; i < fields; ++i) {
+        if(i > 0) {
+            os << ',';
+        }
+        os << "{\"name\":\"" << leafNameAttributes_.get(i) << "\",\"type\":";
+        leafAttributes_.get(i)->printCanonicalJson(os);
+        os << '}';
+    }
+    os << "]}";
+}
+
+void 
+NodeEnum::printCanonicalJson(std::ostream &os) const
+{
+    os << "{\"name\":\"" << nameAttribute_.get() << "\",\"type\":\"enum\",\"symbols\":[";
+    int names = leafNameAttributes_.size();
+    for(int i = 0; i < names; ++i) {
+        if(i > 0) {
+            os << ',';
+        }
+        os << '\"' << leafNameAttributes_.get(i) << '\"';
+    }
+    os << "]}";
+}
+
+void 
+NodeArray::printCanonicalJson(std::ostream &os) const
+{
+    os << "{\"type\":\"array\",\"items\":";
+    leafAttributes_.get()->printCanonicalJson(os);
+    os << '}';
+}
+
+void 
+NodeMap::printCanonicalJson(std::ostream &os) const
+{
+    os << "{\"type\":\"map\",\"values\":";
+    leafAttributes_.get(1)->printCanonicalJson(os);
+    os << '}';
+}
+
+void 
+NodeUnion::printCanonicalJson(std::ostream &os) const
+{
+    os << '[';
+    int fields = leafAttributes_.size();
+    for(int i = 0; i < fields; ++i) {
+        if(i > 0) {
+            os << ',';
+        }
+        leafAttributes_.get(i)->printCanonicalJson(os);
+    }
+    os << ']';
+}
+
+void 
+NodeFixed::printCanonicalJson(std::ostream &os) const
+{
+    os << "{\"name\":\"" << nameAttribute_.get() << "\",\"type\":\"fixed\",\"size\":" << sizeAttribute_.get() << '}';
+}
+
 } // namespace avro
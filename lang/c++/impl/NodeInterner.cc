@@ -0,0 +1,192 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+
+#include "NodeInterner.hh"
+#include "NodeImpl.hh"
+#include "Fingerprint.hh"
+
+namespace avro {
+
+namespace {
+
+std::string
+canonicalForm(const Node &node)
+{
+    std::ostringstream os;
+    node.printCanonicalJson(os);
+    return os.str();
+}
+
+bool
+isDefinition(const Node &node)
+{
+    return node.hasName() && node.type() != AVRO_SYMBOLIC;
+}
+
+// Walks two identical trees side by side, mapping the names of the types
+// defined in the first to their definitions in the second.
+void
+mapDefinitions(const NodePtr &from, const NodePtr &to, std::map<std::string, NodePtr> &replaced)
+{
+    if(from->type() == AVRO_SYMBOLIC) {
+        return;
+    }
+    if(isDefinition(*from)) {
+        replaced[from->name()] = to;
+    }
+    size_t leaves = from->leaves();
+    for(size_t i = 0; i < leaves; ++i) {
+        mapDefinitions(from->leafAt(i), to->leafAt(i), replaced);
+    }
+}
+
+// Points the symbolic links in the tree at the definitions that replaced
+// the ones they referred to.
+void
+retarget(const NodePtr &node, const std::map<std::string, NodePtr> &replaced)
+{
+    if(node->type() == AVRO_SYMBOLIC) {
+        std::map<std::string, NodePtr>::const_iterator iter = replaced.find(node->name());
+        if(iter != replaced.end()) {
+            NodeSymbolic &symbolic = static_cast<NodeSymbolic &>(*node);
+            if(!symbolic.isSet() || symbolic.getNode() != iter->second) {
+                symbolic.setNode(iter->second);
+            }
+        }
+        return;
+    }
+    size_t leaves = node->leaves();
+    for(size_t i = 0; i < leaves; ++i) {
+        retarget(node->leafAt(i), replaced);
+    }
+}
+
+} // anonymous namespace
+
+NodeInterner::NodeInterner()
+{ }
+
+NodeInterner::~NodeInterner()
+{ }
+
+NodePtr
+NodeInterner::intern(const NodePtr &root)
+{
+    if(!root->locked()) {
+        throw Exception("Only locked schemas can be interned");
+    }
+
+    boost::mutex::scoped_lock lock(mutex_);
+
+    Names defined, referenced;
+    Replacements replaced;
+    NodePtr interned = internNode(root, defined, referenced, replaced);
+    if(!replaced.empty()) {
+        retarget(interned, replaced);
+    }
+    return interned;
+}
+
+// Interns the leaves before the node, so that a type which is not itself
+// self-contained still shares the types it embeds.
+NodePtr
+NodeInterner::internNode(const NodePtr &node, Names &defined, Names &referenced, Replacements &replaced)
+{
+    if(node->type() == AVRO_SYMBOLIC) {
+        referenced.insert(node->name());
+        return node;
+    }
+
+    Names leafDefined, leafReferenced;
+    size_t leaves = node->leaves();
+    for(size_t i = 0; i < leaves; ++i) {
+        const NodePtr &leaf = node->leafAt(i);
+        NodePtr interned = internNode(leaf, leafDefined, leafReferenced, replaced);
+        if(interned != leaf) {
+            node->replaceLeaf(i, interned);
+        }
+    }
+
+    NodePtr result = node;
+    if(isDefinition(*node)) {
+        leafDefined.insert(node->name());
+        if(std::includes(leafDefined.begin(), leafDefined.end(), leafReferenced.begin(), leafReferenced.end())) {
+            result = find(node);
+            if(result != node) {
+                mapDefinitions(node, result, replaced);
+            }
+        }
+    }
+
+    defined.insert(leafDefined.begin(), leafDefined.end());
+    referenced.insert(leafReferenced.begin(), leafReferenced.end());
+    return result;
+}
+
+// Returns the interned type identical to the node, interning the node if
+// there is none.
+NodePtr
+NodeInterner::find(const NodePtr &node)
+{
+    std::string canonical = canonicalForm(*node);
+    uint64_t fingerprint = crc64Avro(canonical.data(), canonical.size());
+
+    std::pair<NodeMap::iterator, NodeMap::iterator> range = nodes_.equal_range(fingerprint);
+    for(NodeMap::iterator iter = range.first; iter != range.second; ) {
+        NodePtr existing = iter->second.lock();
+        if(!existing) {
+            nodes_.erase(iter++);
+            continue;
+        }
+        if(existing == node || canonicalForm(*existing) == canonical) {
+            return existing;
+        }
+        ++iter;
+    }
+
+    nodes_.insert(NodeMap::value_type(fingerprint, node));
+    return node;
+}
+
+size_t
+NodeInterner::size() const
+{
+    boost::mutex::scoped_lock lock(mutex_);
+
+    size_t live = 0;
+    for(NodeMap::const_iterator iter = nodes_.begin(); iter != nodes_.end(); ++iter) {
+        if(!iter->second.expired()) {
+            ++live;
+        }
+    }
+    return live;
+}
+
+NodeInterner &
+NodeInterner::instance()
+{
+    static NodeInterner interner;
+    return interner;
+}
+
+} // namespace avro
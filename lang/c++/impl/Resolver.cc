@@ -17,6 +17,8 @@
  * limitations under the License.
  */
 
+#include <boost/scoped_ptr.hpp>
+
 #include "Resolver.hh"
 #include "Layout.hh"
 #include "NodeImpl.hh"
@@ -44,6 +46,68 @@ NoOp noop;
 #define DEBUG_OUT(str) noop << str 
 #endif
 
+/// Written in place of a reader index in the mapping tables for a writer
+/// symbol or branch that has no counterpart in the reader's schema.
+const int64_t NO_MATCH = -1;
+
+inline void checkChoice(int64_t choice, size_t size)
+{
+    if(static_cast<uint64_t>(choice) >= size) {
+        throw Exception(boost::format("Union branch %1% out of range, the writer's union has %2%") % choice % size);
+    }
+}
+
+/// Maps an enum symbol or union branch of the writer to the reader's, through
+/// the table compiled for it.
+inline int64_t lookup(const int64_t *mapping, size_t size, int64_t index, const char *what)
+{
+    if(static_cast<uint64_t>(index) >= size) {
+        throw Exception(boost::format("%1% %2% out of range, the writer's schema has %3%") % what % index % size);
+    }
+    int64_t mapped = mapping[index];
+    if(mapped == NO_MATCH) {
+        throw Exception(boost::format("%1% %2% of the writer's schema does not match the reader's") % what % index);
+    }
+    return mapped;
+}
+
+/// The setter the layout of a generated array, map or union holds for it.
+template <typename Setter>
+Setter setterAt(const CompoundLayout &offsets, size_t index)
+{
+    const SetterLayout<Setter> *layout = dynamic_cast<const SetterLayout<Setter> *>(&offsets.at(index));
+    if(!layout) {
+        throw Exception("Layout has no setter for an array, map or union, it may be from an older code generator");
+    }
+    return layout->setter();
+}
+
+/// The root of a compiled resolver.  The mappings of all the enums and unions
+/// below it are packed into a single table that it owns, and that they index
+/// directly; reading a symbol or a branch is a bounds check and a load.
+class CompiledResolver : public Resolver
+{
+  public:
+
+    CompiledResolver(Resolver *root, std::vector<int64_t> &table) :
+        Resolver(),
+        root_(root)
+    {
+        // swapping keeps the storage, which the resolvers already point into
+        table_.swap(table);
+    }
+
+    virtual void parse(Reader &reader, uint8_t *address) const
+    {
+        root_->parse(reader, address);
+    }
+
+  private:
+
+    boost::scoped_ptr<Resolver> root_;
+    std::vector<int64_t> table_;
+};
+
 template<typename T>
 class PrimitiveSkipper : public Resolver
 {
@@ -238,8 +302,6 @@ class MapParser : public Resolver
 {
   public:
 
-    typedef uint8_t *(*GenericMapSetter)(uint8_t *map, const std::string &key);
-
     MapParser(ResolverFactory &factory, const NodePtr &writer, const NodePtr &reader, const CompoundLayout &offsets);
 
     virtual void parse(Reader &reader, uint8_t *address) const
@@ -249,7 +311,6 @@ class MapParser : public Resolver
         uint8_t *mapAddress = address + offset_;
 
         std::string key;
-        GenericMapSetter* setter = reinterpret_cast<GenericMapSetter *> (address + setFuncOffset_);
 
         int64_t size = 0;
         do {
@@ -258,7 +319,7 @@ class MapParser : public Resolver
                 reader.readValue(key);
 
                 // create a new map entry and get the address
-                uint8_t *location = (*setter)(mapAddress, key);
+                uint8_t *location = setter_(mapAddress, key);
                 resolver_->parse(reader, location);
             }
         } while (size != 0);
@@ -268,7 +329,7 @@ class MapParser : public Resolver
     
     ResolverPtr  resolver_;
     size_t          offset_;
-    size_t          setFuncOffset_;
+    GenericMapSetter setter_;
 };
 
 class ArraySkipper : public Resolver
@@ -295,8 +356,6 @@ class ArraySkipper : public Resolver
     ResolverPtr resolver_;
 };
 
-typedef uint8_t *(*GenericArraySetter)(uint8_t *array);
-
 class ArrayParser : public Resolver
 {
   public:
@@ -309,14 +368,12 @@ class ArrayParser : public Resolver
 
         uint8_t *arrayAddress = address + offset_;
 
-        GenericArraySetter* setter = reinterpret_cast<GenericArraySetter *> (address + setFuncOffset_);
-
         int64_t size = 0;
         do {
             size = reader.readArrayBlockSize();
             for(int64_t i = 0; i < size; ++i) {
                 // create a new map entry and get the address
-                uint8_t *location = (*setter)(arrayAddress);
+                uint8_t *location = setter_(arrayAddress);
                 resolver_->parse(reader, location);
             }
         } while (size != 0);
@@ -330,7 +387,7 @@ class ArrayParser : public Resolver
     
     ResolverPtr resolver_;
     size_t         offset_;
-    size_t         setFuncOffset_;
+    GenericArraySetter setter_;
 };
 
 class EnumSkipper : public Resolver
@@ -356,40 +413,23 @@ class EnumParser : public Resolver
         VAL
     };
 
-    EnumParser(ResolverFactory &factory, const NodePtr &writer, const NodePtr &reader, const CompoundLayout &offsets) :
-        Resolver(),
-        offset_(offsets.at(0).offset()),
-        readerSize_(reader->names())
-    { 
-        const size_t writerSize = writer->names();
-
-        mapping_.reserve(writerSize);
-
-        for(size_t i = 0; i < writerSize; ++i) {
-            const std::string &name = writer->nameAt(i);
-            size_t readerIndex = readerSize_;
-            reader->nameIndex(name, readerIndex);
-            mapping_.push_back(readerIndex);
-        }
-    }
+    EnumParser(ResolverFactory &factory, const NodePtr &writer, const NodePtr &reader, const CompoundLayout &offsets);
 
     virtual void parse(Reader &reader, uint8_t *address) const
     {
         int64_t val = reader.readEnum();
-        assert(static_cast<size_t>(val) < mapping_.size());
+        int64_t symbol = lookup(mapping_, writerSize_, val, "Enum symbol");
 
-        if(mapping_[val] < readerSize_) {
-            EnumRepresentation* location = reinterpret_cast<EnumRepresentation *> (address + offset_);
-            *location = static_cast<EnumRepresentation>(mapping_[val]);
-            DEBUG_OUT("Setting enum" << *location);
-        }
+        EnumRepresentation* location = reinterpret_cast<EnumRepresentation *> (address + offset_);
+        *location = static_cast<EnumRepresentation>(symbol);
+        DEBUG_OUT("Setting enum" << *location);
     }
 
 protected:
 
     size_t offset_;
-    size_t readerSize_;
-    std::vector<size_t> mapping_;
+    size_t writerSize_;
+    const int64_t *mapping_;
     
 };
 
@@ -403,6 +443,7 @@ class UnionSkipper : public Resolver
     {
         DEBUG_OUT("Skipping union");
         int64_t choice = reader.readUnion();
+        checkChoice(choice, resolvers_.size());
         resolvers_[choice].parse(reader, address);
     }
 
@@ -416,20 +457,17 @@ class UnionParser : public Resolver
 {
   public:
 
-    typedef uint8_t *(*GenericUnionSetter)(uint8_t *, int64_t);
-
     UnionParser(ResolverFactory &factory, const NodePtr &writer, const NodePtr &reader, const CompoundLayout &offsets);
 
     virtual void parse(Reader &reader, uint8_t *address) const
     {
         DEBUG_OUT("Reading union");
         int64_t writerChoice = reader.readUnion();
-        int64_t *readerChoice = reinterpret_cast<int64_t *>(address + choiceOffset_);
+        int64_t readerChoice = lookup(choiceMapping_, resolvers_.size(), writerChoice, "Union branch");
 
-        *readerChoice = choiceMapping_[writerChoice];
-        GenericUnionSetter* setter = reinterpret_cast<GenericUnionSetter *> (address + setFuncOffset_);
+        *reinterpret_cast<int64_t *>(address + choiceOffset_) = readerChoice;
         uint8_t *value = reinterpret_cast<uint8_t *> (address + offset_);
-        uint8_t *location = (*setter)(value, *readerChoice);
+        uint8_t *location = setter_(value, readerChoice);
 
         resolvers_[writerChoice].parse(reader, location);
     }
@@ -437,38 +475,36 @@ class UnionParser : public Resolver
   protected:
     
     ResolverPtrVector resolvers_;
-    std::vector<int64_t> choiceMapping_;
+    const int64_t *choiceMapping_;
     size_t offset_;
     size_t choiceOffset_;
-    size_t setFuncOffset_;
+    GenericUnionSetter setter_;
 };
 
 class UnionToNonUnionParser : public Resolver
 {
   public:
 
-    typedef uint8_t *(*GenericUnionSetter)(uint8_t *, int64_t);
-
     UnionToNonUnionParser(ResolverFactory &factory, const NodePtr &writer, const NodePtr &reader, const Layout &offsets);
 
     virtual void parse(Reader &reader, uint8_t *address) const
     {
         DEBUG_OUT("Reading union to non-union");
         int64_t choice = reader.readUnion();
+        lookup(matches_, resolvers_.size(), choice, "Union branch");
         resolvers_[choice].parse(reader, address);
     }
 
   protected:
     
     ResolverPtrVector resolvers_;
+    const int64_t *matches_;
 };
 
 class NonUnionToUnionParser : public Resolver
 {
   public:
 
-    typedef uint8_t *(*GenericUnionSetter)(uint8_t *, int64_t);
-
     NonUnionToUnionParser(ResolverFactory &factory, const NodePtr &writer, const NodePtr &reader, const CompoundLayout &offsets);
 
     virtual void parse(Reader &reader, uint8_t *address) const
@@ -477,9 +513,8 @@ class NonUnionToUnionParser : public Resolver
 
         int64_t *choice = reinterpret_cast<int64_t *>(address + choiceOffset_);
         *choice = choice_;
-        GenericUnionSetter* setter = reinterpret_cast<GenericUnionSetter *> (address + setFuncOffset_);
         uint8_t *value = reinterpret_cast<uint8_t *> (address + offset_);
-        uint8_t *location = (*setter)(value, choice_);
+        uint8_t *location = setter_(value, choice_);
 
         resolver_->parse(reader, location);
     }
@@ -490,7 +525,7 @@ class NonUnionToUnionParser : public Resolver
     size_t choice_;
     size_t offset_;
     size_t choiceOffset_;
-    size_t setFuncOffset_;
+    GenericUnionSetter setter_;
 };
 
 class FixedSkipper : public Resolver
@@ -624,8 +659,40 @@ class ResolverFactory : private boost::noncopyable {
         return instruction;
     }
 
+    typedef std::vector<std::pair<const int64_t **, size_t> > Fixups;
+
+    std::vector<int64_t> table_;
+    Fixups fixups_;
+
   public:
 
+    /// Appends a mapping to the table shared by the whole resolver.  The
+    /// table moves while it grows, so the resolver is only told where its
+    /// entries are when the factory has finished.
+    void
+    addMapping(const std::vector<int64_t> &mapping, const int64_t **location)
+    {
+        fixups_.push_back(std::make_pair(location, table_.size()));
+        table_.insert(table_.end(), mapping.begin(), mapping.end());
+    }
+
+    Resolver *
+    compile(const NodePtr &writer, const NodePtr &reader, const Layout &offset)
+    {
+        Resolver *root = construct(writer, reader, offset);
+        const int64_t *table = table_.empty() ? 0 : &table_[0];
+        for(Fixups::const_iterator iter = fixups_.begin(); iter != fixups_.end(); ++iter) {
+            *iter->first = table + iter->second;
+        }
+        try {
+            return new CompiledResolver(root, table_);
+        }
+        catch(...) {
+            delete root;
+            throw;
+        }
+    }
+
     Resolver *
     construct(const NodePtr &writer, const NodePtr &reader, const Layout &offset)
     {
@@ -670,7 +737,7 @@ class ResolverFactory : private boost::noncopyable {
         typedef Resolver* (ResolverFactory::*BuilderFunc)(const NodePtr &writer);
 
         NodePtr currentWriter = (writer->type() == AVRO_SYMBOLIC) ?
-            writer->leafAt(0) : writer;
+            resolveSymbol(writer) : writer;
 
         static const BuilderFunc funcs[] = {
             &ResolverFactory::constructPrimitiveSkipper<std::string>, 
@@ -734,6 +801,27 @@ RecordParser::RecordParser(ResolverFactory &factory, const NodePtr &writer, cons
     }
 }
 
+EnumParser::EnumParser(ResolverFactory &factory, const NodePtr &writer, const NodePtr &reader, const CompoundLayout &offsets) :
+    Resolver(),
+    offset_(offsets.at(0).offset()),
+    writerSize_(writer->names())
+{ 
+    std::vector<int64_t> mapping;
+    mapping.reserve(writerSize_);
+
+    for(size_t i = 0; i < writerSize_; ++i) {
+        const std::string &name = writer->nameAt(i);
+        size_t readerIndex = 0;
+        if(reader->nameIndex(name, readerIndex)) {
+            mapping.push_back(readerIndex);
+        }
+        else {
+            mapping.push_back(NO_MATCH);
+        }
+    }
+    factory.addMapping(mapping, &mapping_);
+}
+
 MapSkipper::MapSkipper(ResolverFactory &factory, const NodePtr &writer) :
     Resolver(),
     resolver_(factory.skipper(writer->leafAt(1)))
@@ -743,7 +831,7 @@ MapParser::MapParser(ResolverFactory &factory, const NodePtr &writer, const Node
     Resolver(),
     resolver_(factory.construct(writer->leafAt(1), reader->leafAt(1), offsets.at(1))),
     offset_(offsets.offset()),
-    setFuncOffset_( offsets.at(0).offset())
+    setter_(setterAt<GenericMapSetter>(offsets, 0))
 { }
 
 ArraySkipper::ArraySkipper(ResolverFactory &factory, const NodePtr &writer) :
@@ -755,7 +843,7 @@ ArrayParser::ArrayParser(ResolverFactory &factory, const NodePtr &writer, const
     Resolver(),
     resolver_(factory.construct(writer->leafAt(0), reader->leafAt(0), offsets.at(1))),
     offset_(offsets.offset()),
-    setFuncOffset_(offsets.at(0).offset())
+    setter_(setterAt<GenericArraySetter>(offsets, 0))
 { }
 
 UnionSkipper::UnionSkipper(ResolverFactory &factory, const NodePtr &writer) :
@@ -769,49 +857,17 @@ UnionSkipper::UnionSkipper(ResolverFactory &factory, const NodePtr &writer) :
     }
 }
 
-namespace {
-
-// asumes the writer is NOT a union, and the reader IS a union
-
-SchemaResolution    
-checkUnionMatch(const NodePtr &writer, const NodePtr &reader, size_t &index)
-{
-    SchemaResolution bestMatch = RESOLVE_NO_MATCH;
- 
-    index = 0;
-    size_t leaves = reader->leaves();
-
-    for(size_t i=0; i < leaves; ++i) {
-
-        const NodePtr &leaf = reader->leafAt(i);
-        SchemaResolution newMatch = writer->resolve(*leaf);
-
-        if(newMatch == RESOLVE_MATCH) {
-            bestMatch = newMatch;
-            index = i;
-            break;
-        }
-        if(bestMatch == RESOLVE_NO_MATCH) {
-            bestMatch = newMatch;
-            index = i;
-        }
-    }
-
-    return bestMatch;
-}
-
-};
-
 UnionParser::UnionParser(ResolverFactory &factory, const NodePtr &writer, const NodePtr &reader, const CompoundLayout &offsets) :
     Resolver(),
     offset_(offsets.offset()),
     choiceOffset_(offsets.at(0).offset()),
-    setFuncOffset_(offsets.at(1).offset())
+    setter_(setterAt<GenericUnionSetter>(offsets, 1))
 {
 
     size_t leaves = writer->leaves();
     resolvers_.reserve(leaves);
-    choiceMapping_.reserve(leaves);
+    std::vector<int64_t> mapping;
+    mapping.reserve(leaves);
     for(size_t i = 0; i < leaves; ++i) {
 
         // for each writer, we need a schema match for the reader
@@ -821,23 +877,24 @@ UnionParser::UnionParser(ResolverFactory &factory, const NodePtr &writer, const
         SchemaResolution match = checkUnionMatch(w, reader, index);
 
         if(match == RESOLVE_NO_MATCH) {
+            // never run, the lookup fails first, but keeps the indices dense
             resolvers_.push_back(factory.skipper(w));
-            // push back a non-sensical number
-            choiceMapping_.push_back(reader->leaves());
+            mapping.push_back(NO_MATCH);
         }
         else {
             const NodePtr &r = reader->leafAt(index);
             resolvers_.push_back(factory.construct(w, r, offsets.at(index+2)));
-            choiceMapping_.push_back(index);
+            mapping.push_back(index);
         }
     }
+    factory.addMapping(mapping, &choiceMapping_);
 }
 
 NonUnionToUnionParser::NonUnionToUnionParser(ResolverFactory &factory, const NodePtr &writer, const NodePtr &reader, const CompoundLayout &offsets) :
     Resolver(),
     offset_(offsets.offset()),
     choiceOffset_(offsets.at(0).offset()),
-    setFuncOffset_(offsets.at(1).offset())
+    setter_(setterAt<GenericUnionSetter>(offsets, 1))
 {
 
     SchemaResolution bestMatch = checkUnionMatch(writer, reader, choice_);
@@ -850,10 +907,14 @@ UnionToNonUnionParser::UnionToNonUnionParser(ResolverFactory &factory, const Nod
 {
     size_t leaves = writer->leaves();
     resolvers_.reserve(leaves);
+    std::vector<int64_t> matches;
+    matches.reserve(leaves);
     for(size_t i = 0; i < leaves; ++i) {
         const NodePtr &w = writer->leafAt(i);
         resolvers_.push_back(factory.construct(w, reader, offsets));
+        matches.push_back(w->resolve(*reader) == RESOLVE_NO_MATCH ? NO_MATCH : 0);
     }
+    factory.addMapping(matches, &matches_);
 }
 
 Resolver *constructResolver(const ValidSchema &writerSchema,
@@ -861,7 +922,7 @@ Resolver *constructResolver(const ValidSchema &writerSchema,
                                     const Layout &readerLayout)
 {
     ResolverFactory factory;
-    return factory.construct(writerSchema.root(), readerSchema.root(), readerLayout);
+    return factory.compile(writerSchema.root(), readerSchema.root(), readerLayout);
 }
 
 } // namespace avro
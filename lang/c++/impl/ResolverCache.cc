@@ -0,0 +1,186 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <typeinfo>
+
+#include "ResolverCache.hh"
+#include "Resolver.hh"
+#include "Layout.hh"
+#include "ValidSchema.hh"
+
+namespace avro {
+
+namespace {
+
+template <typename T>
+void appendBytes(std::string &key, const T &value)
+{
+    key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename Setter>
+bool appendSetter(std::string &key, const Layout &layout)
+{
+    const SetterLayout<Setter> *setter = dynamic_cast<const SetterLayout<Setter> *>(&layout);
+    if(setter) {
+        appendBytes(key, setter->setter());
+    }
+    return setter != 0;
+}
+
+void appendLayout(std::string &key, const Layout &layout)
+{
+    key += typeid(layout).name();
+    appendBytes(key, layout.offset());
+
+    const CompoundLayout *compound = dynamic_cast<const CompoundLayout *>(&layout);
+    if(compound) {
+        key += '{';
+        for(size_t i = 0; i < compound->size(); ++i) {
+            appendLayout(key, compound->at(i));
+        }
+        key += '}';
+    }
+    else if(!appendSetter<GenericArraySetter>(key, layout) &&
+            !appendSetter<GenericMapSetter>(key, layout)) {
+        appendSetter<GenericUnionSetter>(key, layout);
+    }
+}
+
+} // namespace
+
+ResolverCache::LayoutKey::LayoutKey(const Layout &layout) :
+    layout_(layout)
+{
+    appendLayout(key_, layout);
+}
+
+bool
+ResolverCache::Key::operator<(const Key &rhs) const
+{
+    if(writer != rhs.writer) {
+        return writer < rhs.writer;
+    }
+    if(reader != rhs.reader) {
+        return reader < rhs.reader;
+    }
+    return *layout < *rhs.layout;
+}
+
+ResolverCache::ResolverCache(size_t capacity) :
+    capacity_(capacity),
+    hits_(0),
+    misses_(0)
+{ }
+
+ResolverCache::ResolverPtr
+ResolverCache::resolver(const ValidSchema &writer, const ValidSchema &reader, const LayoutKey &readerLayout)
+{
+    Key key(writer.fingerprint64(), reader.fingerprint64(), &readerLayout.key_);
+
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        Index::iterator iter = index_.find(key);
+        if(iter != index_.end()) {
+            ++hits_;
+            lru_.splice(lru_.begin(), lru_, iter->second);
+            return iter->second->resolver;
+        }
+        ++misses_;
+    }
+
+    // compile without holding the lock, if another thread compiled the same
+    // resolver meanwhile, the first one stored wins
+    ResolverPtr compiled(constructResolver(writer, reader, readerLayout.layout()));
+
+    boost::mutex::scoped_lock lock(mutex_);
+    Index::iterator iter = index_.find(key);
+    if(iter != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, iter->second);
+        return iter->second->resolver;
+    }
+    lru_.push_front(Entry(key, compiled));
+    index_.insert(std::make_pair(lru_.front().key(), lru_.begin()));
+    evict();
+    return compiled;
+}
+
+void
+ResolverCache::evict()
+{
+    while(lru_.size() > capacity_) {
+        index_.erase(lru_.back().key());
+        lru_.pop_back();
+    }
+}
+
+size_t
+ResolverCache::capacity() const
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    return capacity_;
+}
+
+void
+ResolverCache::setCapacity(size_t capacity)
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    capacity_ = capacity;
+    evict();
+}
+
+size_t
+ResolverCache::size() const
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    return index_.size();
+}
+
+uint64_t
+ResolverCache::hits() const
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    return hits_;
+}
+
+uint64_t
+ResolverCache::misses() const
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    return misses_;
+}
+
+void
+ResolverCache::clear()
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    index_.clear();
+    lru_.clear();
+    hits_ = 0;
+    misses_ = 0;
+}
+
+ResolverCache &
+ResolverCache::instance()
+{
+    static ResolverCache cache;
+    return cache;
+}
+
+} // namespace avro
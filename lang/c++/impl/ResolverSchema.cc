@@ -19,6 +19,7 @@
 
 #include "ResolverSchema.hh"
 #include "Resolver.hh"
+#include "ResolverCache.hh"
 #include "ValidSchema.hh"
 
 namespace avro {
@@ -30,6 +31,22 @@ ResolverSchema::ResolverSchema(
     resolver_(constructResolver(writerSchema, readerSchema, readerLayout))
 { }
 
+ResolverSchema::ResolverSchema(
+        const ValidSchema &writerSchema, 
+        const ValidSchema &readerSchema, 
+        const Layout &readerLayout,
+        ResolverCache &cache) :
+    resolver_(cache.resolver(writerSchema, readerSchema, readerLayout))
+{ }
+
+ResolverSchema::ResolverSchema(
+        const ValidSchema &writerSchema, 
+        const ValidSchema &readerSchema, 
+        const ResolverCache::LayoutKey &readerLayout,
+        ResolverCache &cache) :
+    resolver_(cache.resolver(writerSchema, readerSchema, readerLayout))
+{ }
+
 void
 ResolverSchema::parse(Reader &reader, uint8_t *address) 
 {
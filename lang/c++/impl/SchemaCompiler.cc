@@ -0,0 +1,476 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <boost/noncopyable.hpp>
+
+#include "Compiler.hh"
+#include "NodeImpl.hh"
+#include "Schema.hh"
+#include "ValidSchema.hh"
+
+namespace avro {
+
+namespace {
+
+// deeper schemas are refused rather than risk overflowing the stack, since
+// the compiler recurses once per level
+const size_t MAX_DEPTH = 256;
+
+/// Builds the nodes of a schema directly from JSON text held in memory,
+/// descending once through the document.  Each call to compileJsonSchema
+/// uses its own compiler, and nothing is shared between them, so schemas may
+/// be compiled from many threads at once.
+///
+/// Attributes may appear in any order within an object, so the attributes
+/// of a type are collected until its closing brace and the node is built
+/// from them there.  Attributes avro does not use (doc, namespace, default,
+/// order, aliases and any other metadata) are skipped.
+
+class SchemaCompiler : private boost::noncopyable
+{
+
+  public:
+
+    SchemaCompiler(const char *data, size_t len) :
+        begin_(data),
+        pos_(data),
+        end_(data + len)
+    { }
+
+    NodePtr compile() {
+        NodePtr root = parseSchema(0);
+        if(peek() != 0) {
+            error("Unexpected text after the schema");
+        }
+        return root;
+    }
+
+  private:
+
+    NodePtr parseSchema(size_t depth);
+    NodePtr parseObject(size_t depth);
+    NodePtr namedType(const std::string &name);
+
+    void parseFields(MultiLeaves &fields, LeafNames &names, size_t depth);
+    void parseSymbols(LeafNames &symbols);
+    void parseString(std::string &val);
+    int parseSize();
+    void skipValue(size_t depth);
+
+    void checkDepth(size_t depth) const {
+        if(depth == MAX_DEPTH) {
+            error((boost::format("Schema is nested deeper than %1% levels") % MAX_DEPTH).str());
+        }
+    }
+
+    /// Skips whitespace and returns the next character without consuming it,
+    /// or 0 at the end of the text.
+    char peek() {
+        while(pos_ != end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t')) {
+            ++pos_;
+        }
+        return pos_ == end_ ? 0 : *pos_;
+    }
+
+    char next() {
+        char c = peek();
+        if(c == 0) {
+            error("Unexpected end of schema");
+        }
+        ++pos_;
+        return c;
+    }
+
+    /// Consumes the comma after an element of an array or object, if there
+    /// is one, and returns whether another element follows.
+    bool more() {
+        if(peek() == ',') {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if(next() != c) {
+            error(std::string("Expected '") + c + "'");
+        }
+    }
+
+    void error(const std::string &what) const {
+        throw Exception(boost::format("%1% at offset %2% of JSON schema") % what % (pos_ - begin_));
+    }
+
+    const char *const begin_;
+    const char *pos_;
+    const char *const end_;
+
+    // reused for the keys of objects
+    std::string key_;
+};
+
+NodePtr
+SchemaCompiler::parseSchema(size_t depth)
+{
+    checkDepth(depth);
+    switch(peek()) {
+
+      case '"':
+      {
+        std::string name;
+        parseString(name);
+        return namedType(name);
+      }
+
+      case '{':
+        ++pos_;
+        return parseObject(depth);
+
+      case '[':
+      {
+        ++pos_;
+        MultiLeaves types;
+        if(peek() != ']') {
+            do {
+                types.add(parseSchema(depth + 1));
+            } while(more());
+        }
+        expect(']');
+        return NodePtr(new NodeUnion(types));
+      }
+
+      default:
+        error("Expected a schema");
+    }
+    return NodePtr();
+}
+
+NodePtr
+SchemaCompiler::namedType(const std::string &name)
+{
+    static const struct {
+        const char *name;
+        Type type;
+    } primitives[] = {
+        { "string",  AVRO_STRING },
+        { "bytes",   AVRO_BYTES },
+        { "int",     AVRO_INT },
+        { "long",    AVRO_LONG },
+        { "float",   AVRO_FLOAT },
+        { "double",  AVRO_DOUBLE },
+        { "boolean", AVRO_BOOL },
+        { "null",    AVRO_NULL }
+    };
+
+    for(size_t i = 0; i < sizeof(primitives) / sizeof(primitives[0]); ++i) {
+        if(name == primitives[i].name) {
+            return NodePtr(new NodePrimitive(primitives[i].type));
+        }
+    }
+
+    // a reference to a type defined elsewhere in the schema
+    HasName symbol;
+    symbol.add(name);
+    return NodePtr(new NodeSymbolic(symbol));
+}
+
+NodePtr
+SchemaCompiler::parseObject(size_t depth)
+{
+    std::string type;
+    NodePtr nested;
+
+    HasName name;
+    HasSize size;
+    LeafNames names;
+    MultiLeaves fields;
+    SingleLeaf items;
+    SingleLeaf values;
+
+    if(peek() != '}') {
+        do {
+            parseString(key_);
+            expect(':');
+
+            if(key_ == "type") {
+                if(peek() == '"') {
+                    parseString(type);
+                }
+                else {
+                    nested = parseSchema(depth + 1);
+                }
+            }
+            else if(key_ == "name") {
+                std::string val;
+                parseString(val);
+                name.add(val);
+            }
+            else if(key_ == "size") {
+                size.add(parseSize());
+            }
+            else if(key_ == "symbols") {
+                parseSymbols(names);
+            }
+            else if(key_ == "fields") {
+                parseFields(fields, names, depth);
+            }
+            else if(key_ == "items") {
+                items.add(parseSchema(depth + 1));
+            }
+            else if(key_ == "values") {
+                values.add(parseSchema(depth + 1));
+            }
+            else {
+                skipValue(depth + 1);
+            }
+        } while(more());
+    }
+    expect('}');
+
+    if(nested) {
+        return nested;
+    }
+
+    if(type == "record" || type == "error") {
+        return NodePtr(new NodeRecord(name, fields, names));
+    }
+    else if(type == "enum") {
+        return NodePtr(new NodeEnum(name, names));
+    }
+    else if(type == "fixed") {
+        return NodePtr(new NodeFixed(name, size));
+    }
+    else if(type == "array") {
+        return NodePtr(new NodeArray(items));
+    }
+    else if(type == "map") {
+        return NodePtr(new NodeMap(values));
+    }
+    else if(type.empty()) {
+        error("Schema object has no type");
+    }
+    return namedType(type);
+}
+
+void
+SchemaCompiler::parseFields(MultiLeaves &fields, LeafNames &names, size_t depth)
+{
+    expect('[');
+    if(peek() != ']') {
+        do {
+            expect('{');
+            bool hasName = false;
+            bool hasType = false;
+            if(peek() != '}') {
+                do {
+                    parseString(key_);
+                    expect(':');
+                    if(key_ == "name") {
+                        std::string val;
+                        parseString(val);
+                        names.add(val);
+                        hasName = true;
+                    }
+                    else if(key_ == "type") {
+                        fields.add(parseSchema(depth + 1));
+                        hasType = true;
+                    }
+                    else {
+                        skipValue(depth + 1);
+                    }
+                } while(more());
+            }
+            expect('}');
+            if(!hasName || !hasType) {
+                error("Record field needs a name and a type");
+            }
+        } while(more());
+    }
+    expect(']');
+}
+
+void
+SchemaCompiler::parseSymbols(LeafNames &symbols)
+{
+    expect('[');
+    if(peek() != ']') {
+        std::string symbol;
+        do {
+            parseString(symbol);
+            symbols.add(symbol);
+        } while(more());
+    }
+    expect(']');
+}
+
+void
+SchemaCompiler::parseString(std::string &val)
+{
+    expect('"');
+
+    // names in a schema rarely contain escapes, so look for the end first
+    const char *start = pos_;
+    while(pos_ != end_ && *pos_ != '"' && *pos_ != '\\') {
+        ++pos_;
+    }
+    val.assign(start, pos_);
+
+    while(pos_ != end_ && *pos_ != '"') {
+        char c = *pos_++;
+        if(c == '\\') {
+            if(pos_ == end_) {
+                break;
+            }
+            c = *pos_++;
+            switch(c) {
+              case 'b': c = '\b'; break;
+              case 'f': c = '\f'; break;
+              case 'n': c = '\n'; break;
+              case 'r': c = '\r'; break;
+              case 't': c = '\t'; break;
+              case 'u':
+              {
+                if(end_ - pos_ < 4) {
+                    error("Bad escape in string");
+                }
+                char hex[5] = { pos_[0], pos_[1], pos_[2], pos_[3], 0 };
+                char *stop = 0;
+                unsigned long cp = strtoul(hex, &stop, 16);
+                if(stop != hex + 4) {
+                    error("Bad escape in string");
+                }
+                pos_ += 4;
+                if(cp >= 0x80) {
+                    // multi-byte characters only occur in doc strings,
+                    // which are skipped, so a placeholder will do
+                    cp = '?';
+                }
+                c = static_cast<char>(cp);
+                break;
+              }
+              default:
+                break;
+            }
+        }
+        val.push_back(c);
+    }
+
+    if(pos_ == end_) {
+        error("Unterminated string");
+    }
+    ++pos_;
+}
+
+int
+SchemaCompiler::parseSize()
+{
+    peek();
+    const char *start = pos_;
+    long size = 0;
+    while(pos_ != end_ && *pos_ >= '0' && *pos_ <= '9') {
+        size = size * 10 + (*pos_++ - '0');
+        if(size > 0x7fffffffL) {
+            error("Size is too large");
+        }
+    }
+    if(pos_ == start) {
+        error("Expected a size");
+    }
+    return static_cast<int>(size);
+}
+
+void
+SchemaCompiler::skipValue(size_t depth)
+{
+    checkDepth(depth);
+    switch(peek()) {
+
+      case '"':
+        parseString(key_);
+        break;
+
+      case '{':
+        ++pos_;
+        if(peek() != '}') {
+            do {
+                parseString(key_);
+                expect(':');
+                skipValue(depth + 1);
+            } while(more());
+        }
+        expect('}');
+        break;
+
+      case '[':
+        ++pos_;
+        if(peek() != ']') {
+            do {
+                skipValue(depth + 1);
+            } while(more());
+        }
+        expect(']');
+        break;
+
+      case 0:
+        error("Unexpected end of schema");
+        break;
+
+      default:
+      {
+        // numbers, true, false and null
+        const char *start = pos_;
+        while(pos_ != end_ && strchr(",}] \n\r\t", *pos_) == 0) {
+            ++pos_;
+        }
+        if(pos_ == start) {
+            error("Expected a value");
+        }
+        break;
+      }
+    }
+}
+
+} // namespace
+
+void
+compileJsonSchema(const char *data, size_t len, ValidSchema &schema)
+{
+    SchemaCompiler compiler(data, len);
+    Schema s(compiler.compile());
+    schema.setSchema(s);
+}
+
+bool
+compileJsonSchema(const char *data, size_t len, ValidSchema &schema, std::string &error)
+{
+    bool success = false;
+
+    try {
+        compileJsonSchema(data, len, schema);
+        success = true;
+    }
+    catch (Exception &e) {
+        error = e.what();
+    }
+
+    return success;
+}
+
+} // namespace avro
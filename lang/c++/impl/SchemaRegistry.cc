@@ -0,0 +1,160 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dirent.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+
+#include "SchemaRegistry.hh"
+#include "ValidSchema.hh"
+#include "Compiler.hh"
+#include "NodeInterner.hh"
+#include "Exception.hh"
+
+namespace avro {
+
+namespace {
+
+const size_t INITIAL_CAPACITY = 64;
+
+bool
+endsWith(const std::string &str, const char *suffix)
+{
+    size_t len = strlen(suffix);
+    return str.size() >= len && str.compare(str.size() - len, len, suffix) == 0;
+}
+
+} // anonymous namespace
+
+SchemaRegistry::SchemaRegistry(NodeInterner *interner) :
+    table_(new Table(INITIAL_CAPACITY)),
+    interner_(interner)
+{ 
+    tables_.push_back(table_);
+}
+
+SchemaRegistry::~SchemaRegistry()
+{ }
+
+void
+SchemaRegistry::insert(Table &table, const Entry *entry)
+{
+    size_t i = slot(entry->fingerprint, table);
+    while(table.slots[i]) {
+        i = (i + 1) & table.mask;
+    }
+    __atomic_store_n(&table.slots[i], entry, __ATOMIC_RELEASE);
+}
+
+const ValidSchema &
+SchemaRegistry::add(const SchemaPtr &schema)
+{
+    uint64_t fingerprint = schema->fingerprint64();
+
+    boost::mutex::scoped_lock lock(mutex_);
+
+    const ValidSchema *existing = find(fingerprint);
+    if(existing) {
+        return *existing;
+    }
+
+    // keep the table at most half full, so probes stay short and always
+    // reach an empty slot
+    if((entries_.size() + 1) * 2 > table_->mask + 1) {
+        Table *grown = new Table((table_->mask + 1) * 2);
+        tables_.push_back(grown);
+        for(size_t i = 0; i < entries_.size(); ++i) {
+            insert(*grown, &entries_[i]);
+        }
+        __atomic_store_n(&table_, grown, __ATOMIC_RELEASE);
+    }
+
+    entries_.push_back(new Entry(fingerprint, schema));
+    insert(*table_, &entries_.back());
+    return *schema;
+}
+
+const ValidSchema &
+SchemaRegistry::add(const char *json, size_t len)
+{
+    boost::shared_ptr<ValidSchema> schema(new ValidSchema);
+    compileJsonSchema(json, len, *schema);
+    if(interner_) {
+        schema->intern(*interner_);
+    }
+    return add(schema);
+}
+
+size_t
+SchemaRegistry::addDirectory(const std::string &path)
+{
+    DIR *dir = opendir(path.c_str());
+    if(!dir) {
+        throw Exception(boost::format("Cannot open schema directory %1%") % path);
+    }
+
+    size_t added = 0;
+    try {
+        while(struct dirent *dent = readdir(dir)) {
+            std::string name(dent->d_name);
+            if(!endsWith(name, ".avsc")) {
+                continue;
+            }
+
+            std::string file = path + '/' + name;
+            std::ifstream in(file.c_str());
+            if(!in.good()) {
+                throw Exception(boost::format("Cannot read schema file %1%") % file);
+            }
+            std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+            try {
+                add(json.data(), json.size());
+            }
+            catch (Exception &e) {
+                throw Exception(boost::format("%1%: %2%") % file % e.what());
+            }
+            ++added;
+        }
+    }
+    catch (...) {
+        closedir(dir);
+        throw;
+    }
+
+    closedir(dir);
+    return added;
+}
+
+size_t
+SchemaRegistry::size() const
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    return entries_.size();
+}
+
+SchemaRegistry &
+SchemaRegistry::instance()
+{
+    static SchemaRegistry registry;
+    return registry;
+}
+
+} // namespace avro
@@ -0,0 +1,95 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SingleObject.hh"
+#include "SchemaRegistry.hh"
+#include "ResolverCache.hh"
+#include "ValidSchema.hh"
+
+namespace avro {
+
+namespace {
+
+const uint8_t MARKER[2] = { 0xc3, 0x01 };
+
+} // anonymous namespace
+
+SingleObjectWriter::SingleObjectWriter(const ValidSchema &schema, OutputStreamer &out) :
+    out_(out),
+    writer_(out)
+{
+    header_[0] = MARKER[0];
+    header_[1] = MARKER[1];
+    uint64_t fingerprint = schema.fingerprint64();
+    for(int i = 0; i < 8; ++i) {
+        header_[2 + i] = static_cast<uint8_t>(fingerprint >> (8 * i));
+    }
+}
+
+SingleObjectReader::SingleObjectReader(const ValidSchema &readerSchema, const Layout &readerLayout) :
+    readerSchema_(readerSchema),
+    readerLayout_(readerLayout),
+    registry_(SchemaRegistry::instance()),
+    cache_(ResolverCache::instance()),
+    lastFingerprint_(0),
+    last_(0)
+{ }
+
+SingleObjectReader::SingleObjectReader(const ValidSchema &readerSchema, const Layout &readerLayout,
+                                       SchemaRegistry &registry, ResolverCache &cache) :
+    readerSchema_(readerSchema),
+    readerLayout_(readerLayout),
+    registry_(registry),
+    cache_(cache),
+    lastFingerprint_(0),
+    last_(0)
+{ }
+
+uint64_t
+SingleObjectReader::fingerprint(const uint8_t *data, size_t size)
+{
+    if(size < SINGLE_OBJECT_HEADER_SIZE || data[0] != MARKER[0] || data[1] != MARKER[1]) {
+        throw Exception("Message is not in the single object encoding");
+    }
+    uint64_t fingerprint = 0;
+    for(int i = 7; i >= 0; --i) {
+        fingerprint = (fingerprint << 8) | data[2 + i];
+    }
+    return fingerprint;
+}
+
+const Resolver &
+SingleObjectReader::findResolver(uint64_t fingerprint)
+{
+    Resolvers::iterator iter = resolvers_.find(fingerprint);
+    if(iter == resolvers_.end()) {
+        const ValidSchema *writerSchema = registry_.find(fingerprint);
+        if(!writerSchema) {
+            throw Exception(boost::format("No schema is registered with fingerprint %|016x|") % fingerprint);
+        }
+        ResolverPtr resolver = cache_.resolver(*writerSchema, readerSchema_, readerLayout_);
+        iter = resolvers_.insert(std::make_pair(fingerprint, resolver)).first;
+    }
+
+    lastFingerprint_ = fingerprint;
+    last_ = iter->second.get();
+    return *last_;
+}
+
+} // namespace avro
@@ -0,0 +1,818 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <deque>
+#include <map>
+#include <vector>
+#include <boost/format.hpp>
+
+#include "Transcoder.hh"
+#include "ValidSchema.hh"
+#include "NodeImpl.hh"
+#include "Reader.hh"
+#include "Writer.hh"
+#include "InputStreamer.hh"
+#include "OutputStreamer.hh"
+
+namespace avro {
+
+/// The fields of one record that arrived before the reader wants them.
+struct PendingFields
+{
+    void reset(size_t fields) {
+        if(bytes.size() < fields) {
+            bytes.resize(fields);
+        }
+        for(size_t i = 0; i < fields; ++i) {
+            bytes[i].clear();
+        }
+        ready.assign(fields, false);
+    }
+
+    std::vector<std::vector<uint8_t> > bytes;
+    std::vector<bool> ready;
+};
+
+/// Buffers for reordering fields, one level for each record being
+/// transcoded, innermost last.  Each thread keeps its own, reused from
+/// record to record, so that once they have grown to fit, reordering
+/// fields does not allocate.
+class TranscodeScratch : private boost::noncopyable
+{
+  public:
+
+    TranscodeScratch() :
+        depth(0)
+    {}
+
+    // a deque, so that adding a level leaves the outer ones in place
+    std::deque<PendingFields> levels;
+    size_t depth;
+};
+
+class TranscodeStep : private boost::noncopyable
+{
+  public:
+
+    virtual void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const = 0;
+    virtual ~TranscodeStep() {}
+};
+
+namespace {
+
+/// Output used while skipping, throws away everything written to it.
+class NullStreamer : public OutputStreamer {
+
+  public:
+
+    size_t writeByte(uint8_t byte) {
+        return 1;
+    }
+
+    size_t writeWord(uint32_t word) {
+        return sizeof(word);
+    }
+
+    size_t writeLongWord(uint64_t word) {
+        return sizeof(word);
+    }
+
+    size_t writeBytes(const void *bytes, size_t size) {
+        return size;
+    }
+};
+
+/// Output used to hold fields that arrive before the reader wants them.
+class BufferStreamer : public OutputStreamer {
+
+  public:
+
+    explicit BufferStreamer(std::vector<uint8_t> &buffer) :
+        buffer_(buffer)
+    {}
+
+    size_t writeByte(uint8_t byte) {
+        buffer_.push_back(byte);
+        return 1;
+    }
+
+    size_t writeWord(uint32_t word) {
+        return writeBytes(&word, sizeof(word));
+    }
+
+    size_t writeLongWord(uint64_t word) {
+        return writeBytes(&word, sizeof(word));
+    }
+
+    size_t writeBytes(const void *bytes, size_t size) {
+        const uint8_t *ptr = static_cast<const uint8_t *>(bytes);
+        buffer_.insert(buffer_.end(), ptr, ptr + size);
+        return size;
+    }
+
+  private:
+
+    std::vector<uint8_t> &buffer_;
+};
+
+void
+copyBytes(InputStreamer &in, OutputStreamer &out, size_t size)
+{
+    uint8_t buffer[512];
+    while(size > 0) {
+        size_t chunk = size < sizeof(buffer) ? size : sizeof(buffer);
+        in.readBytes(buffer, chunk);
+        out.writeBytes(buffer, chunk);
+        size -= chunk;
+    }
+}
+
+// The zigzag encoding of an int is also the encoding of the same value as a
+// long, so ints, longs and ints promoted to longs are copied without decoding.
+class VarIntCopier : public TranscodeStep
+{
+  public:
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        uint8_t bytes[10];
+        size_t size = 0;
+        do {
+            if(size == sizeof(bytes)) {
+                throw Exception("Variable length integer is longer than 10 bytes");
+            }
+            in.readByte(bytes[size]);
+        } while(bytes[size++] & 0x80);
+        out.writeBytes(bytes, size);
+    }
+};
+
+class ByteCopier : public TranscodeStep
+{
+  public:
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        uint8_t byte;
+        in.readByte(byte);
+        out.writeByte(byte);
+    }
+};
+
+class WordCopier : public TranscodeStep
+{
+  public:
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        uint32_t word;
+        in.readWord(word);
+        out.writeWord(word);
+    }
+};
+
+class LongWordCopier : public TranscodeStep
+{
+  public:
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        uint64_t word;
+        in.readLongWord(word);
+        out.writeLongWord(word);
+    }
+};
+
+class NullCopier : public TranscodeStep
+{
+  public:
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    { }
+};
+
+/// Strings and bytes: the length, then the raw span of bytes.
+class SpanCopier : public TranscodeStep
+{
+  public:
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        int64_t size;
+        reader.readValue(size);
+        if(size < 0) {
+            throw Exception("Negative length for string or bytes");
+        }
+        Writer writer(out);
+        writer.writeValue(size);
+        copyBytes(in, out, static_cast<size_t>(size));
+    }
+};
+
+class FixedCopier : public TranscodeStep
+{
+  public:
+
+    explicit FixedCopier(size_t size) :
+        size_(size)
+    {}
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        copyBytes(in, out, size_);
+    }
+
+  private:
+
+    size_t size_;
+};
+
+template<typename WT, typename RT>
+class PrimitivePromoter : public TranscodeStep
+{
+  public:
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        WT val;
+        reader.readValue(val);
+        Writer writer(out);
+        writer.writeValue(static_cast<RT>(val));
+    }
+};
+
+/// Consumes a value of the writer's schema, writing nothing.
+class Skipper : public TranscodeStep
+{
+  public:
+
+    explicit Skipper(const TranscodeStep &copier) :
+        copier_(copier)
+    {}
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        NullStreamer discard;
+        copier_.transcode(reader, in, discard, scratch);
+    }
+
+  private:
+
+    const TranscodeStep &copier_;
+};
+
+class EnumTranscoder : public TranscodeStep
+{
+  public:
+
+    EnumTranscoder(const NodePtr &writer, const NodePtr &reader) :
+        name_(writer->name())
+    {
+        const size_t writerSize = writer->names();
+        mapping_.reserve(writerSize);
+        for(size_t i = 0; i < writerSize; ++i) {
+            size_t readerIndex = 0;
+            bool found = reader->nameIndex(writer->nameAt(i), readerIndex);
+            mapping_.push_back(found ? static_cast<int64_t>(readerIndex) : -1);
+        }
+    }
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        int64_t val = reader.readEnum();
+        if(val < 0 || static_cast<size_t>(val) >= mapping_.size() || mapping_[val] < 0) {
+            throw Exception(boost::format("Symbol %1% of enum %2% is not in the reader's schema") % val % name_);
+        }
+        Writer writer(out);
+        writer.writeEnum(mapping_[val]);
+    }
+
+  private:
+
+    std::string name_;
+    std::vector<int64_t> mapping_;
+};
+
+class ArrayTranscoder : public TranscodeStep
+{
+  public:
+
+    explicit ArrayTranscoder(const TranscodeStep &items) :
+        items_(items)
+    {}
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        Writer writer(out);
+        int64_t size = 0;
+        do {
+            size = reader.readArrayBlockSize();
+            writer.writeArrayBlock(size);
+            for(int64_t i = 0; i < size; ++i) {
+                items_.transcode(reader, in, out, scratch);
+            }
+        } while(size != 0);
+    }
+
+  private:
+
+    const TranscodeStep &items_;
+};
+
+class MapTranscoder : public TranscodeStep
+{
+  public:
+
+    explicit MapTranscoder(const TranscodeStep &values) :
+        values_(values)
+    {}
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        Writer writer(out);
+        int64_t size = 0;
+        do {
+            size = reader.readMapBlockSize();
+            writer.writeMapBlock(size);
+            for(int64_t i = 0; i < size; ++i) {
+                keys_.transcode(reader, in, out, scratch);
+                values_.transcode(reader, in, out, scratch);
+            }
+        } while(size != 0);
+    }
+
+  private:
+
+    SpanCopier keys_;
+    const TranscodeStep &values_;
+};
+
+/// Both writer and reader are unions, each writer branch is mapped to the
+/// reader's branch it resolves to.
+class UnionTranscoder : public TranscodeStep
+{
+  public:
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        int64_t choice = reader.readUnion();
+        if(choice < 0 || static_cast<size_t>(choice) >= branches_.size() || !branches_[choice]) {
+            throw Exception(boost::format("Branch %1% of the writer's union does not resolve to the reader's schema") % choice);
+        }
+        if(choices_[choice] >= 0) {
+            Writer writer(out);
+            writer.writeUnion(choices_[choice]);
+        }
+        branches_[choice]->transcode(reader, in, out, scratch);
+    }
+
+    void addBranch(const TranscodeStep *step, int64_t choice) {
+        branches_.push_back(step);
+        choices_.push_back(choice);
+    }
+
+  private:
+
+    std::vector<const TranscodeStep *> branches_;
+
+    // the reader's choice, or -1 if the reader is not a union
+    std::vector<int64_t> choices_;
+};
+
+class NonUnionToUnionTranscoder : public TranscodeStep
+{
+  public:
+
+    NonUnionToUnionTranscoder(const TranscodeStep &step, int64_t choice) :
+        step_(step),
+        choice_(choice)
+    {}
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        Writer writer(out);
+        writer.writeUnion(choice_);
+        step_.transcode(reader, in, out, scratch);
+    }
+
+  private:
+
+    const TranscodeStep &step_;
+    int64_t choice_;
+};
+
+/// Claims the scratch level of the record being transcoded for as long as
+/// it takes.
+class ScratchLevel : private boost::noncopyable
+{
+  public:
+
+    explicit ScratchLevel(TranscodeScratch &scratch) :
+        scratch_(scratch)
+    {
+        if(scratch_.levels.size() == scratch_.depth) {
+            scratch_.levels.push_back(PendingFields());
+        }
+        fields_ = &scratch_.levels[scratch_.depth++];
+    }
+
+    ~ScratchLevel() {
+        --scratch_.depth;
+    }
+
+    PendingFields &fields() {
+        return *fields_;
+    }
+
+  private:
+
+    TranscodeScratch &scratch_;
+    PendingFields *fields_;
+};
+
+class RecordTranscoder : public TranscodeStep
+{
+  public:
+
+    void transcode(Reader &reader, InputStreamer &in, OutputStreamer &out, TranscodeScratch &scratch) const
+    {
+        const size_t readerFields = defaults_.size();
+
+        // Fields are written straight to the output while they arrive in the
+        // reader's order; one that arrives early is held until the fields
+        // before it have been written.
+        ScratchLevel level(scratch);
+        PendingFields &pending = level.fields();
+        bool held = false;
+
+        size_t next = 0;
+        flush(next, pending, held, out);
+
+        const size_t writerFields = fields_.size();
+        for(size_t i = 0; i < writerFields; ++i) {
+            const int target = targets_[i];
+            if(target < 0) {
+                fields_[i]->transcode(reader, in, out, scratch);
+            }
+            else if(static_cast<size_t>(target) == next) {
+                fields_[i]->transcode(reader, in, out, scratch);
+                ++next;
+                flush(next, pending, held, out);
+            }
+            else {
+                if(!held) {
+                    pending.reset(readerFields);
+                    held = true;
+                }
+                BufferStreamer buffer(pending.bytes[target]);
+                fields_[i]->transcode(reader, in, buffer, scratch);
+                pending.ready[target] = true;
+            }
+        }
+        assert(next == readerFields);
+    }
+
+    void addField(const TranscodeStep *step, int target) {
+        fields_.push_back(step);
+        targets_.push_back(target);
+    }
+
+    void setDefaults(const std::vector<bool> &hasDefault, const std::vector<std::vector<uint8_t> > &defaults) {
+        hasDefault_ = hasDefault;
+        defaults_ = defaults;
+    }
+
+  private:
+
+    void flush(size_t &next, const PendingFields &pending, bool held, OutputStreamer &out) const
+    {
+        const size_t readerFields = defaults_.size();
+        while(next < readerFields) {
+            const std::vector<uint8_t> *bytes = 0;
+            if(hasDefault_[next]) {
+                bytes = &defaults_[next];
+            }
+            else if(held && pending.ready[next]) {
+                bytes = &pending.bytes[next];
+            }
+            else {
+                break;
+            }
+            if(!bytes->empty()) {
+                out.writeBytes(&(*bytes)[0], bytes->size());
+            }
+            ++next;
+        }
+    }
+
+    // for each of the writer's fields, the step to process it, and the
+    // index of the reader's field it becomes (or -1 if it is skipped)
+    std::vector<const TranscodeStep *> fields_;
+    std::vector<int> targets_;
+
+    // for each of the reader's fields, whether the writer lacks it, and if so
+    // the encoding of its default
+    std::vector<bool> hasDefault_;
+    std::vector<std::vector<uint8_t> > defaults_;
+};
+
+} // anonymous namespace
+
+class TranscoderFactory : private boost::noncopyable
+{
+  public:
+
+    explicit TranscoderFactory(boost::ptr_vector<TranscodeStep> &steps) :
+        steps_(steps)
+    {}
+
+    const TranscodeStep *
+    construct(const NodePtr &writer, const NodePtr &reader)
+    {
+        NodePtr currentWriter = (writer->type() == AVRO_SYMBOLIC) ?
+            resolveSymbol(writer) : writer;
+
+        NodePtr currentReader = (reader->type() == AVRO_SYMBOLIC) ?
+            resolveSymbol(reader) : reader;
+
+        if(currentWriter->type() == AVRO_UNION) {
+            return constructUnion(currentWriter, currentReader);
+        }
+
+        if(currentReader->type() == AVRO_UNION) {
+            size_t choice = 0;
+            if(checkUnionMatch(currentWriter, currentReader, choice) == RESOLVE_NO_MATCH) {
+                throw noMatch(currentWriter, currentReader);
+            }
+            const TranscodeStep *step = construct(currentWriter, currentReader->leafAt(choice));
+            return add(new NonUnionToUnionTranscoder(*step, choice));
+        }
+
+        SchemaResolution match = currentWriter->resolve(*currentReader);
+        if(match == RESOLVE_NO_MATCH) {
+            throw noMatch(currentWriter, currentReader);
+        }
+
+        switch(currentWriter->type()) {
+
+          case AVRO_STRING:
+          case AVRO_BYTES:
+            return add(new SpanCopier);
+
+          case AVRO_INT:
+            if(match == RESOLVE_PROMOTABLE_TO_FLOAT) {
+                return add(new PrimitivePromoter<int32_t, float>);
+            }
+            if(match == RESOLVE_PROMOTABLE_TO_DOUBLE) {
+                return add(new PrimitivePromoter<int32_t, double>);
+            }
+            return add(new VarIntCopier);
+
+          case AVRO_LONG:
+            if(match == RESOLVE_PROMOTABLE_TO_FLOAT) {
+                return add(new PrimitivePromoter<int64_t, float>);
+            }
+            if(match == RESOLVE_PROMOTABLE_TO_DOUBLE) {
+                return add(new PrimitivePromoter<int64_t, double>);
+            }
+            return add(new VarIntCopier);
+
+          case AVRO_FLOAT:
+            if(match == RESOLVE_PROMOTABLE_TO_DOUBLE) {
+                return add(new PrimitivePromoter<float, double>);
+            }
+            return add(new WordCopier);
+
+          case AVRO_DOUBLE:
+            return add(new LongWordCopier);
+
+          case AVRO_BOOL:
+            return add(new ByteCopier);
+
+          case AVRO_NULL:
+            return add(new NullCopier);
+
+          case AVRO_RECORD:
+            return constructRecord(currentWriter, currentReader);
+
+          case AVRO_ENUM:
+            return add(new EnumTranscoder(currentWriter, currentReader));
+
+          case AVRO_ARRAY:
+            return add(new ArrayTranscoder(*construct(currentWriter->leafAt(0), currentReader->leafAt(0))));
+
+          case AVRO_MAP:
+            return add(new MapTranscoder(*construct(currentWriter->leafAt(1), currentReader->leafAt(1))));
+
+          case AVRO_FIXED:
+            return add(new FixedCopier(currentWriter->fixedSize()));
+
+          default:
+            throw noMatch(currentWriter, currentReader);
+        }
+    }
+
+    const TranscodeStep *
+    skipper(const NodePtr &writer)
+    {
+        return add(new Skipper(*construct(writer, writer)));
+    }
+
+  private:
+
+    Exception noMatch(const NodePtr &writer, const NodePtr &reader) const
+    {
+        return Exception(boost::format("Writer's %1% cannot be resolved to reader's %2%") 
+                % writer->type() % reader->type());
+    }
+
+    template<typename T>
+    const T *add(T *step) {
+        steps_.push_back(step);
+        return step;
+    }
+
+    const TranscodeStep *
+    constructUnion(const NodePtr &writer, const NodePtr &reader)
+    {
+        UnionTranscoder *step = new UnionTranscoder;
+        add(step);
+
+        size_t leaves = writer->leaves();
+        for(size_t i = 0; i < leaves; ++i) {
+            NodePtr w = writer->leafAt(i);
+            if(w->type() == AVRO_SYMBOLIC) {
+                w = resolveSymbol(w);
+            }
+            if(reader->type() == AVRO_UNION) {
+                size_t choice = 0;
+                if(checkUnionMatch(w, reader, choice) == RESOLVE_NO_MATCH) {
+                    step->addBranch(0, -1);
+                }
+                else {
+                    step->addBranch(construct(w, reader->leafAt(choice)), choice);
+                }
+            }
+            else {
+                if(w->resolve(*reader) == RESOLVE_NO_MATCH) {
+                    step->addBranch(0, -1);
+                }
+                else {
+                    step->addBranch(construct(w, reader), -1);
+                }
+            }
+        }
+        return step;
+    }
+
+    const TranscodeStep *
+    constructRecord(const NodePtr &writer, const NodePtr &reader)
+    {
+        // a recursive record refers back to the step being built
+        RecordKey key(writer.get(), reader.get());
+        RecordMap::const_iterator iter = records_.find(key);
+        if(iter != records_.end()) {
+            return iter->second;
+        }
+
+        RecordTranscoder *step = new RecordTranscoder;
+        add(step);
+        records_.insert(std::make_pair(key, step));
+
+        const size_t readerFields = reader->leaves();
+        std::vector<bool> found(readerFields, false);
+
+        size_t leaves = writer->leaves();
+        for(size_t i = 0; i < leaves; ++i) {
+            const NodePtr &w = writer->leafAt(i);
+            size_t readerIndex = 0;
+            if(reader->nameIndex(writer->nameAt(i), readerIndex)) {
+                step->addField(construct(w, reader->leafAt(readerIndex)), readerIndex);
+                found[readerIndex] = true;
+            }
+            else {
+                step->addField(skipper(w), -1);
+            }
+        }
+
+        std::vector<bool> hasDefault(readerFields, false);
+        std::vector<std::vector<uint8_t> > defaults(readerFields);
+        for(size_t i = 0; i < readerFields; ++i) {
+            if(!found[i]) {
+                hasDefault[i] = true;
+                defaultEncoding(reader->leafAt(i), defaults[i], 0);
+            }
+        }
+        step->setDefaults(hasDefault, defaults);
+
+        return step;
+    }
+
+    // The encoding of a default-constructed value of the reader's type.
+    void
+    defaultEncoding(const NodePtr &reader, std::vector<uint8_t> &bytes, int depth)
+    {
+        if(depth > 64) {
+            throw Exception("Cannot construct a default for a recursive type");
+        }
+
+        NodePtr node = (reader->type() == AVRO_SYMBOLIC) ?
+            resolveSymbol(reader) : reader;
+
+        switch(node->type()) {
+
+          case AVRO_FLOAT:
+            bytes.insert(bytes.end(), 4, 0);
+            break;
+
+          case AVRO_DOUBLE:
+            bytes.insert(bytes.end(), 8, 0);
+            break;
+
+          case AVRO_NULL:
+            break;
+
+          case AVRO_FIXED:
+            bytes.insert(bytes.end(), node->fixedSize(), 0);
+            break;
+
+          case AVRO_RECORD:
+            for(size_t i = 0; i < node->leaves(); ++i) {
+                defaultEncoding(node->leafAt(i), bytes, depth + 1);
+            }
+            break;
+
+          case AVRO_UNION:
+            bytes.push_back(0);
+            defaultEncoding(node->leafAt(0), bytes, depth + 1);
+            break;
+
+          default:
+            // zero length, zero count, first symbol, zero or false
+            bytes.push_back(0);
+            break;
+        }
+    }
+
+    typedef std::pair<const Node *, const Node *> RecordKey;
+    typedef std::map<RecordKey, const TranscodeStep *> RecordMap;
+
+    boost::ptr_vector<TranscodeStep> &steps_;
+    RecordMap records_;
+};
+
+Transcoder::Transcoder(const ValidSchema &writer, const ValidSchema &reader) :
+    root_(0),
+    skipper_(0)
+{
+    TranscoderFactory factory(steps_);
+    root_ = factory.construct(writer.root(), reader.root());
+    skipper_ = factory.skipper(writer.root());
+}
+
+Transcoder::~Transcoder()
+{ }
+
+TranscodeScratch &
+Transcoder::scratch() const
+{
+    TranscodeScratch *scratch = scratch_.get();
+    if(!scratch) {
+        scratch = new TranscodeScratch;
+        scratch_.reset(scratch);
+    }
+    return *scratch;
+}
+
+void
+Transcoder::transcode(InputStreamer &in, OutputStreamer &out) const
+{
+    Reader reader(in);
+    root_->transcode(reader, in, out, scratch());
+}
+
+void
+Transcoder::skip(InputStreamer &in) const
+{
+    Reader reader(in);
+    NullStreamer discard;
+    skipper_->transcode(reader, in, discard, scratch());
+}
+
+} // namespace avro
@@ -50,6 +50,12 @@ BOOST_STATIC_ASSERT( (sizeof(typeToString)/sizeof(std::string)) == (AVRO_NUM_TYP
 // and it would be a problem for this flag if we ever supported more than 32 types
 BOOST_STATIC_ASSERT( AVRO_NUM_TYPES < 32 );
 
+const std::string &toString(Type type)
+{
+    static const std::string unknown("unknown");
+    return isAvroTypeOrPseudoType(type) ? strings::typeToString[type] : unknown;
+}
+
 std::ostream &operator<< (std::ostream &os, Type type)
 {
     if(isAvroTypeOrPseudoType(type)) {
@@ -16,12 +16,15 @@
  * limitations under the License.
  */
 
+#include <sstream>
 #include <boost/format.hpp>
 
 #include "ValidSchema.hh"
 #include "SymbolMap.hh"
 #include "Schema.hh"
 #include "Node.hh"
+#include "Validator.hh"
+#include "NodeInterner.hh"
 
 namespace avro {
 
@@ -30,11 +33,14 @@ namespace avro {
 {
     SymbolMap symbolMap;
     validate(root_, symbolMap);
+    compile();
 }
 
 ValidSchema::ValidSchema() :
-   root_(NullSchema().root()) 
-{ }
+   root_(NullSchema().root())
+{ 
+    compile();
+}
 
 void
 ValidSchema::setSchema(const Schema &schema)
@@ -43,6 +49,33 @@ ValidSchema::setSchema(const Schema &schema)
     SymbolMap symbolMap;
     validate(schema.root(), symbolMap);
     root_ = node;
+    compile();
+}
+
+void
+ValidSchema::compile()
+{
+    validationTable_.reset(new ValidationTable(root_));
+
+    std::ostringstream os;
+    root_->printCanonicalJson(os);
+    canonicalForm_ = os.str();
+    fingerprint64_ = crc64Avro(canonicalForm_.data(), canonicalForm_.size());
+    fingerprintSha256_ = sha256(canonicalForm_.data(), canonicalForm_.size());
+}
+
+void
+ValidSchema::intern()
+{
+    intern(NodeInterner::instance());
+}
+
+void
+ValidSchema::intern(NodeInterner &interner)
+{
+    root_ = interner.intern(root_);
+    // the table points to the nodes, so must not keep the old ones alive
+    validationTable_.reset(new ValidationTable(root_));
 }
 
 bool
@@ -100,6 +133,12 @@ ValidSchema::toJson(std::ostream &os) const
     os << '\n';
 }
 
+void 
+ValidSchema::toCanonicalJson(std::ostream &os) const
+{ 
+    os << canonicalForm_;
+}
+
 void 
 ValidSchema::toFlatList(std::ostream &os) const
 { 
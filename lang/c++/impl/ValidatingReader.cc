@@ -78,4 +78,139 @@ ValidatingReader::readArrayBlockSize()
     return readCount();
 }
 
+void
+ValidatingReader::skipBytes()
+{
+    int64_t size = 0;
+    reader_.readValue(size);
+    if(size < 0) {
+        throw Exception(boost::format("Negative length %1% while skipping") % size);
+    }
+    reader_.skipBytes(size);
+}
+
+void
+ValidatingReader::skipBlocks(Type type, int64_t valuesPerItem)
+{
+    checkSafeToGet(type);
+    validator_.advance();
+    while(true) {
+        checkSafeToGet(AVRO_LONG);
+        int64_t count = 0;
+        reader_.readValue(count);
+        if(count < 0) {
+            // the block is followed by its size in bytes, and may be skipped
+            // whole; the validator keeps waiting for the next block's count
+            skipBytes();
+            continue;
+        }
+
+        validator_.advanceWithCount(count);
+        if(count == 0) {
+            break;
+        }
+        for(int64_t i = 0; i < count * valuesPerItem; ++i) {
+            skipValue();
+        }
+
+        // the validator expects the next block of the array or map
+        checkSafeToGet(type);
+        validator_.advance();
+    }
+}
+
+void
+ValidatingReader::skipValue()
+{
+    switch(validator_.nextTypeExpected()) {
+
+      case AVRO_STRING:
+      case AVRO_BYTES:
+        validator_.advance();
+        skipBytes();
+        break;
+
+      case AVRO_INT:
+      {
+        int32_t val;
+        readValue(val);
+        break;
+      }
+
+      case AVRO_LONG:
+      {
+        int64_t val;
+        readValue(val);
+        break;
+      }
+
+      case AVRO_FLOAT:
+      {
+        float val;
+        readValue(val);
+        break;
+      }
+
+      case AVRO_DOUBLE:
+      {
+        double val;
+        readValue(val);
+        break;
+      }
+
+      case AVRO_BOOL:
+      {
+        bool val;
+        readValue(val);
+        break;
+      }
+
+      case AVRO_NULL:
+      {
+        Null val;
+        readValue(val);
+        break;
+      }
+
+      case AVRO_RECORD:
+      {
+        size_t fields = validator_.nextFieldCount();
+        readRecord();
+        for(size_t i = 0; i < fields; ++i) {
+            skipValue();
+        }
+        break;
+      }
+
+      case AVRO_ENUM:
+        readEnum();
+        break;
+
+      case AVRO_ARRAY:
+        skipBlocks(AVRO_ARRAY, 1);
+        break;
+
+      case AVRO_MAP:
+        // each entry is a key and a value
+        skipBlocks(AVRO_MAP, 2);
+        break;
+
+      case AVRO_UNION:
+        readUnion();
+        skipValue();
+        break;
+
+      case AVRO_FIXED:
+      {
+        size_t size = validator_.nextSizeExpected();
+        validator_.advance();
+        reader_.skipBytes(size);
+        break;
+      }
+
+      default:
+        throw Exception(boost::format("Cannot skip value of type %1%") % validator_.nextTypeExpected());
+    }
+}
+
 } // namespace avro
@@ -24,16 +24,93 @@
 
 namespace avro {
 
+namespace {
+
+// use flags instead of strictly types, so that we can be more lax about the type
+// (for example, a long should be able to accept an int type, but not vice versa)
+ValidationTable::flag_t 
+expectedFlags(Type type)
+{
+    typedef ValidationTable::flag_t flag_t;
+    static const flag_t flags[] = {
+        ValidationTable::typeToFlag(AVRO_STRING) | ValidationTable::typeToFlag(AVRO_BYTES),
+        ValidationTable::typeToFlag(AVRO_STRING) | ValidationTable::typeToFlag(AVRO_BYTES),
+        ValidationTable::typeToFlag(AVRO_INT),
+        ValidationTable::typeToFlag(AVRO_INT) | ValidationTable::typeToFlag(AVRO_LONG),
+        ValidationTable::typeToFlag(AVRO_FLOAT),
+        ValidationTable::typeToFlag(AVRO_DOUBLE),
+        ValidationTable::typeToFlag(AVRO_BOOL),
+        ValidationTable::typeToFlag(AVRO_NULL),
+        ValidationTable::typeToFlag(AVRO_RECORD),
+        ValidationTable::typeToFlag(AVRO_ENUM),
+        ValidationTable::typeToFlag(AVRO_ARRAY),
+        ValidationTable::typeToFlag(AVRO_MAP),
+        ValidationTable::typeToFlag(AVRO_UNION),
+        ValidationTable::typeToFlag(AVRO_FIXED)
+    };
+    BOOST_STATIC_ASSERT( (sizeof(flags)/sizeof(flag_t)) == (AVRO_NUM_TYPES) );
+
+    return flags[type];
+}
+
+} // namespace
+
+ValidationTable::ValidationTable(const NodePtr &root) :
+    root_(root)
+{
+    std::map<const Node *, size_t> compiled;
+    compile(root_, compiled);
+}
+
+size_t
+ValidationTable::compile(const NodePtr &node, std::map<const Node *, size_t> &compiled)
+{
+    if(node->type() == AVRO_SYMBOLIC) {
+        NodePtr actualNode = resolveSymbol(node);
+        assert(actualNode);
+        return compile(actualNode, compiled);
+    }
+
+    // a named type appears once in the table however often it is used,
+    // which is also what ends the recursion of recursive types
+    std::map<const Node *, size_t>::const_iterator iter = compiled.find(node.get());
+    if(iter != compiled.end()) {
+        return iter->second;
+    }
+
+    Type type = node->type();
+    assert(type < AVRO_SYMBOLIC);
+
+    size_t index = entries_.size();
+    compiled[node.get()] = index;
+
+    Entry entry;
+    entry.type = type;
+    entry.flags = expectedFlags(type);
+    entry.firstLeaf = leaves_.size();
+    entry.leaves = node->leaves();
+    entry.fixedSize = (type == AVRO_FIXED) ? node->fixedSize() : 0;
+    entry.node = node.get();
+    entries_.push_back(entry);
+
+    leaves_.resize(entry.firstLeaf + entry.leaves);
+    for(size_t i = 0; i < entry.leaves; ++i) {
+        size_t leaf = compile(node->leafAt(i), compiled);
+        leaves_[entry.firstLeaf + i] = leaf;
+    }
+
+    return index;
+}
+
 Validator::Validator(const ValidSchema &schema) :
-    schema_(schema),
-    parseTree_(schema.root()),
+    table_(schema.validationTable()),
     nextType_(AVRO_NULL),
     expectedTypesFlag_(0),
     compoundStarted_(false),
     waitingForCount_(false),
     count_(0)
 {
-    setupOperation(parseTree_);
+    setupOperation(ValidationTable::ROOT);
 }
 
 void 
@@ -55,9 +132,9 @@ Validator::recordAdvance()
     // determine the next record entry to process
     size_t index = (compoundStack_.back().pos)++;
 
-    const NodePtr &node = compoundStack_.back().node;
-    if(index < node->leaves() ) {
-        setupOperation(node->leafAt(index));
+    const ValidationTable::Entry &entry = top();
+    if(index < entry.leaves) {
+        setupOperation(table_->leafAt(entry, index));
     }
     else {
         // done with this record, remove it from the processing stack
@@ -81,7 +158,7 @@ Validator::enumAdvance()
 void
 Validator::countingAdvance()
 {
-    const NodePtr &node = compoundStack_.back().node;
+    const ValidationTable::Entry &entry = top();
 
     if(compoundStarted_) {
         setWaitingForCount();
@@ -94,15 +171,15 @@ Validator::countingAdvance()
         }
         else {
             counters_.push_back(count_);
-            setupOperation(node->leafAt(0));
+            setupOperation(table_->leafAt(entry, 0));
         }
     }
     else {
 
         size_t index = ++(compoundStack_.back().pos);
 
-        if(index < node->leaves() ) {
-            setupOperation(node->leafAt(index));
+        if(index < entry.leaves) {
+            setupOperation(table_->leafAt(entry, index));
         }
         else {
             compoundStack_.back().pos = 0;
@@ -110,11 +187,11 @@ Validator::countingAdvance()
             if(count == 0) {
                 counters_.pop_back();
                 compoundStarted_ = true;
-                nextType_ = node->type();
+                nextType_ = entry.type;
                 expectedTypesFlag_ = typeToFlag(nextType_);
             }
             else {
-                setupOperation(node->leafAt(0));
+                setupOperation(table_->leafAt(entry, 0));
             }
         }
     }
@@ -129,11 +206,11 @@ Validator::unionAdvance()
     }
     else {
         waitingForCount_ = false;
-        NodePtr node = compoundStack_.back().node;
+        const ValidationTable::Entry &entry = top();
 
-        if(count_ < static_cast<int64_t>(node->leaves())) {
+        if(count_ < static_cast<int64_t>(entry.leaves)) {
             compoundStack_.pop_back();
-            setupOperation(node->leafAt(count_));
+            setupOperation(table_->leafAt(entry, count_));
         }
         else {
             throw Exception("Union out of range");
@@ -151,46 +228,43 @@ Validator::fixedAdvance()
 int 
 Validator::nextSizeExpected() const
 {
-    return compoundStack_.back().node->fixedSize();
+    return top().fixedSize;
+}
+
+size_t 
+Validator::nextFieldCount() const
+{
+    return (nextType_ == AVRO_RECORD) ? top().leaves : 0;
 }
 
 void
 Validator::advance()
 {
-    typedef void (Validator::*AdvanceFunc)();
-
-    // only the compound types need advance functions here
-    static const AdvanceFunc funcs[] = {
-        0, // string
-        0, // bytes
-        0, // int
-        0, // long
-        0, // float
-        0, // double
-        0, // bool
-        0, // null
-        &Validator::recordAdvance,
-        &Validator::enumAdvance,
-        &Validator::countingAdvance,
-        &Validator::countingAdvance,
-        &Validator::unionAdvance,
-        &Validator::fixedAdvance
-    };
-    BOOST_STATIC_ASSERT( (sizeof(funcs)/sizeof(AdvanceFunc)) == (AVRO_NUM_TYPES) );
-
     expectedTypesFlag_ = 0;
     // loop until we encounter a next expected type, or we've exited all compound types 
     while(!expectedTypesFlag_ && !compoundStack_.empty() ) {
     
-        Type type = compoundStack_.back().node->type();
-
-        AdvanceFunc func = funcs[type];
-
-        // only compound functions are put on the status stack so it is ok to
-        // assume that func is not null
-        assert(func);
-
-        ((this)->*(func))();
+        // only compound types are put on the status stack
+        switch(top().type) {
+          case AVRO_RECORD:
+            recordAdvance();
+            break;
+          case AVRO_ENUM:
+            enumAdvance();
+            break;
+          case AVRO_ARRAY:
+          case AVRO_MAP:
+            countingAdvance();
+            break;
+          case AVRO_UNION:
+            unionAdvance();
+            break;
+          case AVRO_FIXED:
+            fixedAdvance();
+            break;
+          default:
+            assert(0);
+        }
     }
 
     if(compoundStack_.empty()) {
@@ -213,49 +287,14 @@ Validator::advanceWithCount(int64_t count)
 }
 
 void
-Validator::setupFlag(Type type)
+Validator::setupOperation(size_t index)
 {
-    // use flags instead of strictly types, so that we can be more lax about the type
-    // (for example, a long should be able to accept an int type, but not vice versa)
-    static const flag_t flags[] = {
-        typeToFlag(AVRO_STRING) | typeToFlag(AVRO_BYTES),
-        typeToFlag(AVRO_STRING) | typeToFlag(AVRO_BYTES),
-        typeToFlag(AVRO_INT),
-        typeToFlag(AVRO_INT) | typeToFlag(AVRO_LONG),
-        typeToFlag(AVRO_FLOAT),
-        typeToFlag(AVRO_DOUBLE),
-        typeToFlag(AVRO_BOOL),
-        typeToFlag(AVRO_NULL),
-        typeToFlag(AVRO_RECORD),
-        typeToFlag(AVRO_ENUM),
-        typeToFlag(AVRO_ARRAY),
-        typeToFlag(AVRO_MAP),
-        typeToFlag(AVRO_UNION),
-        typeToFlag(AVRO_FIXED)
-    };
-    BOOST_STATIC_ASSERT( (sizeof(flags)/sizeof(flag_t)) == (AVRO_NUM_TYPES) );
-
-    expectedTypesFlag_ = flags[type];
-}
-
-void
-Validator::setupOperation(const NodePtr &node)
-{
-    nextType_ = node->type();
-
-    if(nextType_ == AVRO_SYMBOLIC) {
-        NodePtr actualNode = resolveSymbol(node);
-        assert(actualNode);
-        setupOperation(actualNode);
-        return;
-    }
-
-    assert(nextType_ < AVRO_SYMBOLIC);
-
-    setupFlag(nextType_);
+    const ValidationTable::Entry &entry = table_->entry(index);
+    nextType_ = entry.type;
+    expectedTypesFlag_ = entry.flags;
 
     if(!isPrimitive(nextType_)) {
-        compoundStack_.push_back(CompoundType(node));
+        compoundStack_.push_back(CompoundType(index));
         compoundStarted_ = true;
     }
 }
@@ -275,9 +314,12 @@ Validator::getCurrentRecordName(std::string &name) const
         idx = compoundStack_.size() -2;
     }
     
-    if(idx >= 0 && compoundStack_[idx].node->type() == AVRO_RECORD) {
-        name = compoundStack_[idx].node->name();
-        found = true;
+    if(idx >= 0) {
+        const ValidationTable::Entry &entry = table_->entry(compoundStack_[idx].entry);
+        if(entry.type == AVRO_RECORD) {
+            name = entry.node->name();
+            found = true;
+        }
     }
     return found;
 }
@@ -288,12 +330,14 @@ Validator::getNextFieldName(std::string &name) const
     bool found = false;
     name.clear();
     int idx = isCompound(nextType_) ? compoundStack_.size()-2 : compoundStack_.size()-1;
-    if(idx >= 0 && compoundStack_[idx].node->type() == AVRO_RECORD) {
-        size_t pos = compoundStack_[idx].pos-1;
-        const NodePtr &node = compoundStack_[idx].node;
-        if(pos < node->leaves()) {
-            name = node->nameAt(pos);
-            found = true;
+    if(idx >= 0) {
+        const ValidationTable::Entry &entry = table_->entry(compoundStack_[idx].entry);
+        if(entry.type == AVRO_RECORD) {
+            size_t pos = compoundStack_[idx].pos-1;
+            if(pos < entry.leaves) {
+                name = entry.node->nameAt(pos);
+                found = true;
+            }
         }
     }
     return found;
@@ -27,6 +27,7 @@ headers = '''
 #include "Exception.hh"
 #include "AvroSerialize.hh"
 #include "AvroParse.hh"
+#include "AvroSize.hh"
 #include "Layout.hh"
 '''
 
@@ -53,6 +54,15 @@ def doSymbolic(args):
     addForwardDeclare(args[1])
     return (args[1], args[1])
 
+# The size of a value of the generated or primitive type.  The generated
+# encodedSize() functions call each other directly, since the
+# is_serializable traits that avro::encodedSize() dispatches on are only
+# declared at the end of the header.
+def sizeOf(type, value) :
+    if typeToC.has_key(type) :
+        return 'avro::encodedSize(' + value + ')'
+    return 'encodedSize(' + value + ', boost::true_type())'
+
 def addLayout(name, type, var) :
     result = '        add(new $offsetType$(offset + offsetof($name$, $var$)));\n'
     result = result.replace('$name$', name)
@@ -87,6 +97,11 @@ inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &
 $serializefields$
 }
 
+inline size_t encodedSize(const $name$ &val, const boost::true_type &) {
+    size_t size = 0;
+$sizefields$    return size;
+}
+
 template <typename Parser>
 inline void parse(Parser &p, $name$ &val, const boost::true_type &) {
     p.readRecord();
@@ -108,9 +123,11 @@ def doRecord(args):
     structDef = structDef.replace('$name$', typename);
     fields = ''
     serializefields = ''
+    sizefields = ''
     parsefields = ''
     initlist = ''
     offsetlist = ''
+    layout = True
     end = False
     while not end:
         line = getNextLine()
@@ -123,14 +140,18 @@ def doRecord(args):
             fieldtypename, fieldtype = processType(fieldline)
             fields += '    ' +  fieldtypename + ' ' + fieldname + ';\n'
             serializefields += '    serialize(s, val.' + fieldname + ');\n'
+            sizefields += '    size += ' + sizeOf(fieldtype, 'val.' + fieldname) + ';\n'
             initlist += '        ' + fieldname + '(),\n'
             parsefields += '    parse(p, val.' + fieldname + ');\n'
             offsetlist += addLayout(typename, fieldtype, fieldname)
+            layout = layout and hasLayout(fieldtype)
     structDef = structDef.replace('$initializers$', initlist)
     structDef = structDef.replace('$recordfields$', fields)
     structDef = structDef.replace('$serializefields$', serializefields)
+    structDef = structDef.replace('$sizefields$', sizefields)
     structDef = structDef.replace('$parsefields$', parsefields)
     structDef = structDef.replace('$offsetlist$', offsetlist)
+    structDef = dropLayout(typename, structDef, layout)
     addStruct(typename, structDef)
     return (typename,typename)
 
@@ -138,12 +159,9 @@ uniontypestemplate = 'typedef $type$ Choice$N$Type'
 unionTemplate = '''struct $name$ {
 
 $typedeflist$
-    typedef void* (*GenericSetter)($name$ *, int64_t);
-
     $name$() : 
         choice(0), 
-        value(T0()),
-        genericSetter(&$name$::genericSet)
+        value(T0())
     { }
 
 $setfuncs$
@@ -170,7 +188,6 @@ $setfuncs$
 
     int64_t choice; 
     boost::any value;
-    GenericSetter genericSetter;
 };
 
 template <typename Serializer>
@@ -183,10 +200,19 @@ $switchserialize$
     }
 }
 
+inline size_t encodedSize(const $name$ &val, const boost::true_type &) {
+    size_t size = avro::encodedInt64Size(val.choice);
+    switch(val.choice) {
+$switchsize$
+    default :
+        throw avro::Exception("Unrecognized union choice");
+    }
+    return size;
+}
+
 template <typename Parser>
 inline void parse(Parser &p, $name$ &val, const boost::true_type &) {
-    val.choice = p.readUnion();
-    switch(val.choice) {
+$readunion$
 $switchparse$
     default :
         throw avro::Exception("Unrecognized union choice");
@@ -195,17 +221,34 @@ $switchparse$
 
 class $name$_Layout : public avro::CompoundLayout {
   public:
+    static uint8_t *setter(uint8_t *u, int64_t choice) {
+        return static_cast<uint8_t *>($name$::genericSet(reinterpret_cast<$name$ *>(u), choice));
+    }
+
     $name$_Layout(size_t offset = 0) :
         CompoundLayout(offset)
     {
         add(new avro::PrimitiveLayout(offset + offsetof($name$, choice)));
-        add(new avro::PrimitiveLayout(offset + offsetof($name$, genericSetter)));
+        add(new avro::UnionSetterLayout(&$name$_Layout::setter));
 $offsetlist$    }
 }; 
 '''
 
 unionser = '      case $choice$:\n        serialize(s, val.getValue< $type$ >());\n        break;\n'
-unionpar = '      case $choice$:\n        { $type$ chosenVal; parse(p, chosenVal); val.value = chosenVal; }\n        break;\n'
+unionsize = '      case $choice$:\n        size += $size$;\n        break;\n'
+unionpar = {
+False : '      case $choice$:\n        { $type$ chosenVal; parse(p, chosenVal); val.value = chosenVal; }\n        break;\n',
+True : '      case $choice$:\n        if(!same) {\n            val.value = $type$();\n        }\n        parse(p, *boost::any_cast< $type$ >(&val.value));\n        break;\n'
+}
+
+readunion = {
+False : '''    val.choice = p.readUnion();
+    switch(val.choice) {''',
+True : '''    int64_t choice = p.readUnion();
+    bool same = (choice == val.choice);
+    val.choice = choice;
+    switch(choice) {'''
+}
 
 setfunc =  '''    void set_$name$(const $type$ &val) {
         choice = $N$;
@@ -222,11 +265,13 @@ def doUnion(args):
     structDef = unionTemplate
     uniontypes = ''
     switchserialize= ''
+    switchsize= ''
     switchparse= ''
     typename = 'Union_of'
     setters = ''
     switches = ''
     offsetlist = ''
+    layout = True
     i = 0
     end = False
     while not end:
@@ -240,7 +285,11 @@ def doUnion(args):
             switch = switch.replace('$choice$', str(i))
             switch = switch.replace('$type$', uniontype)
             switchserialize += switch 
-            switch = unionpar
+            switch = unionsize
+            switch = switch.replace('$choice$', str(i))
+            switch = switch.replace('$size$', sizeOf(name, 'val.getValue< ' + uniontype + ' >()'))
+            switchsize += switch 
+            switch = unionpar[reuse]
             switch = switch.replace('$choice$', str(i))
             switch = switch.replace('$type$', uniontype)
             switchparse += switch 
@@ -252,14 +301,18 @@ def doUnion(args):
             switch = switcher
             switches += switch.replace('$N$', str(i))
             offsetlist += addSimpleLayout(name)
+            layout = layout and hasLayout(name)
         i+= 1
     structDef = structDef.replace('$name$', typename)
     structDef = structDef.replace('$typedeflist$', uniontypes)
     structDef = structDef.replace('$switchserialize$', switchserialize)
+    structDef = structDef.replace('$switchsize$', switchsize)
+    structDef = structDef.replace('$readunion$', readunion[reuse])
     structDef = structDef.replace('$switchparse$', switchparse)
     structDef = structDef.replace('$setfuncs$', setters)
     structDef = structDef.replace('$switch$', switches)
     structDef = structDef.replace('$offsetlist$', offsetlist)
+    structDef = dropLayout(typename, structDef, layout)
     addStruct(typename, structDef)
     return (typename,typename)
 
@@ -281,6 +334,10 @@ inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &
     s.writeEnum(val.value);
 }
 
+inline size_t encodedSize(const $name$ &val, const boost::true_type &) {
+    return avro::encodedInt64Size(val.value);
+}
+
 template <typename Parser>
 inline void parse(Parser &p, $name$ &val, const boost::true_type &) {
     val.value = static_cast<$name$::EnumSymbols>(p.readEnum());
@@ -321,11 +378,9 @@ def doEnum(args):
 arrayTemplate = '''struct $name$ {
     typedef $valuetype$ ValueType;
     typedef std::vector<ValueType> ArrayType;
-    typedef ValueType* (*GenericSetter)($name$ *);
     
     $name$() :
-        value(),
-        genericSetter(&$name$::genericSet)
+        value()
     { }
 
     static ValueType *genericSet($name$ *array) {
@@ -338,8 +393,6 @@ arrayTemplate = '''struct $name$ {
     }
 
     ArrayType value;
-    GenericSetter genericSetter;
-
 };
 
 template <typename Serializer>
@@ -354,9 +407,39 @@ inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &
     s.writeArrayEnd();
 }
 
+inline size_t encodedSize(const $name$ &val, const boost::true_type &) {
+    const size_t count = val.value.size();
+    size_t size = 1;
+    if(count) {
+        size += avro::encodedInt64Size(count);
+        for(size_t i = 0; i < count; ++i) {
+            size += $itemsize$;
+        }
+    }
+    return size;
+}
+
 template <typename Parser>
 inline void parse(Parser &p, $name$ &val, const boost::true_type &) {
-    val.value.clear();
+$parsearray$
+}
+
+class $name$_Layout : public avro::CompoundLayout {
+  public:
+    static uint8_t *setter(uint8_t *array) {
+        return reinterpret_cast<uint8_t *>($name$::genericSet(reinterpret_cast<$name$ *>(array)));
+    }
+
+    $name$_Layout(size_t offset = 0) :
+        CompoundLayout(offset)
+    {
+        add(new avro::ArraySetterLayout(&$name$_Layout::setter));
+$offsetlist$    }
+}; 
+'''
+
+parseArray = {
+False : '''    val.value.clear();
     while(1) {
         int size = p.readArrayBlockSize();
         if(size > 0) {
@@ -369,29 +452,39 @@ inline void parse(Parser &p, $name$ &val, const boost::true_type &) {
         else {
             break;
         }
+    } ''',
+True : '''    size_t count = 0;
+    while(1) {
+        int size = p.readArrayBlockSize();
+        if(size > 0) {
+            val.value.reserve(count + size);
+            while (size-- > 0) { 
+                if(count == val.value.size()) {
+                    val.value.push_back($name$::ValueType());
+                }
+                parse(p, val.value[count++]);
+            }
+        }
+        else {
+            break;
+        }
     } 
+    val.value.erase(val.value.begin() + count, val.value.end());'''
 }
 
-class $name$_Layout : public avro::CompoundLayout {
-  public:
-    $name$_Layout(size_t offset = 0) :
-        CompoundLayout(offset)
-    {
-        add(new avro::PrimitiveLayout(offset + offsetof($name$, genericSetter)));
-$offsetlist$    }
-}; 
-'''
-
 def doArray(args):
-    structDef = arrayTemplate
+    structDef = arrayTemplate.replace('$parsearray$', parseArray[reuse])
     line = getNextLine()
     arraytype, typename = processType(line)
     offsetlist = addSimpleLayout(typename)
+    layout = hasLayout(typename)
+    structDef = structDef.replace('$itemsize$', sizeOf(typename, 'val.value[i]'))
     typename = 'Array_of_' + typename
 
     structDef = structDef.replace('$name$', typename)
     structDef = structDef.replace('$valuetype$', arraytype)
     structDef = structDef.replace('$offsetlist$', offsetlist)
+    structDef = dropLayout(typename, structDef, layout)
 
     line = getNextLine()
     if line[0] != 'end': print 'error'
@@ -401,26 +494,21 @@ def doArray(args):
 
 mapTemplate = '''struct $name$ {
     typedef $valuetype$ ValueType;
-    typedef std::map<std::string, ValueType> MapType;
-    typedef ValueType* (*GenericSetter)($name$ *, const std::string &);
+$maptypedef$
     
     $name$() :
-        value(),
-        genericSetter(&$name$::genericSet)
+        value()
     { }
 
     void addValue(const std::string &key, const ValueType &val) {
-        value.insert(MapType::value_type(key, val));
+$addvalue$
     }
 
     static ValueType *genericSet($name$ *map, const std::string &key) { 
-        map->value[key] = ValueType();
-        return &(map->value[key]);
+$genericset$
     }
 
     MapType value;
-    GenericSetter genericSetter;
-
 };
 
 template <typename Serializer>
@@ -438,35 +526,189 @@ inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &
     s.writeMapEnd();
 }
 
+inline size_t encodedSize(const $name$ &val, const boost::true_type &) {
+    size_t size = 1;
+    if(val.value.size()) {
+        size += avro::encodedInt64Size(val.value.size());
+        $name$::MapType::const_iterator iter = val.value.begin();
+        $name$::MapType::const_iterator end  = val.value.end();
+        while(iter!=end) {
+            size += avro::encodedSize(iter->first);
+            size += $itemsize$;
+            ++iter;
+        }
+    }
+    return size;
+}
+
 template <typename Parser>
 inline void parse(Parser &p, $name$ &val, const boost::true_type &) {
-    val.value.clear();
+$parsemap$
+}
+
+class $name$_Layout : public avro::CompoundLayout {
+  public:
+    static uint8_t *setter(uint8_t *map, const std::string &key) {
+        return reinterpret_cast<uint8_t *>($name$::genericSet(reinterpret_cast<$name$ *>(map), key));
+    }
+
+    $name$_Layout(size_t offset = 0) :
+        CompoundLayout(offset)
+    {
+        add(new avro::MapSetterLayout(&$name$_Layout::setter));
+$offsetlist$    }
+}; 
+'''
+
+# How generated maps hold their values, chosen with --maps.  The associative
+# containers parse each value in place, behind a single lookup of its key; a
+# duplicate key overwrites the value before it.  The vector keeps the entries
+# in the order they were decoded, duplicates included, and suits maps that
+# are only iterated.
+
+mapKinds = {
+'map' : {
+'header' : '',
+'maptypedef' : '    typedef std::map<std::string, ValueType> MapType;',
+'addvalue' : '        value.insert(MapType::value_type(key, val));',
+'genericset' : '''        ValueType &val = map->value[key];
+        val = ValueType();
+        return &val;''',
+'parsemap' : '''    val.value.clear();
+    std::string key;
     while(1) {
         int size = p.readMapBlockSize();
         if(size > 0) {
             while (size-- > 0) { 
-                std::string key;
                 parse(p, key);
-                $name$::ValueType m;
-                parse(p, m);
-                val.value.insert($name$::MapType::value_type(key, m));
+                parse(p, val.value[key]);
+            }
+        }
+        else {
+            break;
+        }
+    } ''',
+'reusemap' : '''    std::string key;
+    $name$::MapType::iterator next = val.value.begin();
+    bool inPlace = true;
+    while(1) {
+        int size = p.readMapBlockSize();
+        if(size > 0) {
+            while (size-- > 0) { 
+                parse(p, key);
+                if(inPlace && next != val.value.end() && next->first == key) {
+                    parse(p, next->second);
+                    ++next;
+                }
+                else {
+                    if(inPlace) {
+                        val.value.erase(next, val.value.end());
+                        inPlace = false;
+                    }
+                    parse(p, val.value[key]);
+                }
+            }
+        }
+        else {
+            break;
+        }
+    } 
+    if(inPlace) {
+        val.value.erase(next, val.value.end());
+    }'''
+},
+'hash' : {
+'header' : '#include <boost/unordered_map.hpp>',
+'maptypedef' : '    typedef boost::unordered_map<std::string, ValueType> MapType;',
+},
+'vector' : {
+'header' : '#include <utility>',
+'maptypedef' : '    typedef std::vector<std::pair<std::string, ValueType> > MapType;',
+'addvalue' : '        value.push_back(MapType::value_type(key, val));',
+'genericset' : '''        map->value.push_back(MapType::value_type(key, ValueType()));
+        return &map->value.back().second;''',
+'parsemap' : '''    val.value.clear();
+    while(1) {
+        int size = p.readMapBlockSize();
+        if(size > 0) {
+            val.value.reserve(val.value.size() + size);
+            while (size-- > 0) { 
+                val.value.push_back($name$::MapType::value_type());
+                parse(p, val.value.back().first);
+                parse(p, val.value.back().second);
+            }
+        }
+        else {
+            break;
+        }
+    } ''',
+'reusemap' : '''    size_t count = 0;
+    while(1) {
+        int size = p.readMapBlockSize();
+        if(size > 0) {
+            val.value.reserve(count + size);
+            while (size-- > 0) { 
+                if(count == val.value.size()) {
+                    val.value.push_back($name$::MapType::value_type());
+                }
+                parse(p, val.value[count].first);
+                parse(p, val.value[count++].second);
             }
         }
         else {
             break;
         }
     } 
+    val.value.erase(val.value.begin() + count, val.value.end());'''
+},
 }
 
-class $name$_Layout : public avro::CompoundLayout {
-  public:
-    $name$_Layout(size_t offset = 0) :
-        CompoundLayout(offset)
-    {
-        add(new avro::PrimitiveLayout(offset + offsetof($name$, genericSetter)));
-$offsetlist$    }
-}; 
-'''
+for kind in ('addvalue', 'genericset', 'parsemap', 'reusemap') :
+    mapKinds['hash'][kind] = mapKinds['map'][kind]
+
+mapKind = 'map'
+
+# With --reuse, parse() overwrites the object it is given in place instead
+# of building its containers afresh: array and map entries that are already
+# there are parsed into, and only the surplus is erased, a union that keeps
+# its branch parses into the value it holds, and strings and vectors keep
+# their capacity.  A consumer that parses record after record into the same
+# object stops allocating once the object has grown to fit them.  An
+# associative map parses in place while the keys arrive in the order it
+# holds them, as they do when written from the same kind of map.
+
+reuse = False
+
+# With --views, string and bytes fields are avro::View, pointing into the
+# buffer the record was parsed from, so parsing them neither copies nor
+# allocates.  Only those fields: arrays still fill vectors, map keys stay
+# std::string and a union holds its value in a boost::any, so a record
+# parses without allocating only if it has none of them.  The records can
+# only be parsed from a MemoryStreamer and must not outlive its buffer.  A
+# Layout can only fill std::string and std::vector<uint8_t>, so the types
+# that hold a View, directly or through other types, get no _Layout class,
+# and resolving into them with a ResolverSchema does not compile.
+
+views = False
+
+def useViews() :
+    globals()['views'] = True
+    typeToC['string'] = 'avro::View'
+    typeToC['bytes'] = 'avro::View'
+
+# the generated types whose _Layout class was left out
+layoutless = {}
+
+def hasLayout(type) :
+    if views and type in ('string', 'bytes') :
+        return False
+    return not layoutless.has_key(type)
+
+def dropLayout(name, structDef, layout) :
+    if layout :
+        return structDef
+    layoutless[name] = True
+    return structDef[:structDef.index('class ' + name + '_Layout')].rstrip() + '\n'
 
 def doMap(args):
     structDef = mapTemplate
@@ -475,11 +717,18 @@ def doMap(args):
     maptype, typename = processType(line);
 
     offsetlist = addSimpleLayout(typename)
+    layout = hasLayout(typename)
+    structDef = structDef.replace('$itemsize$', sizeOf(typename, 'iter->second'))
     typename = 'Map_of_' + typename
 
+    if reuse :
+        structDef = structDef.replace('$parsemap$', mapKinds[mapKind]['reusemap'])
+    for key in ('maptypedef', 'addvalue', 'genericset', 'parsemap') :
+        structDef = structDef.replace('$' + key + '$', mapKinds[mapKind][key])
     structDef = structDef.replace('$name$', typename)
     structDef = structDef.replace('$valuetype$', maptype)
     structDef = structDef.replace('$offsetlist$', offsetlist)
+    structDef = dropLayout(typename, structDef, layout)
 
     line = getNextLine()
     if line[0] != 'end': print 'error'
@@ -503,6 +752,10 @@ inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &
     s.writeFixed(val.value);
 }
 
+inline size_t encodedSize(const $name$ &, const boost::true_type &) {
+    return $name$::fixedSize;
+}
+
 template <typename Parser>
 inline void parse(Parser &p, $name$ &val, const boost::true_type &) {
     p.readFixed(val.value);
@@ -540,6 +793,10 @@ inline void serialize(Serializer &s, const $name$ &val, const boost::true_type &
     s.writeValue(val.value);
 }
 
+inline size_t encodedSize(const $name$ &val, const boost::true_type &) {
+    return avro::encodedSize(val.value);
+}
+
 template <typename Parser>
 inline void parse(Parser &p, $name$ &val, const boost::true_type &) {
     p.readValue(val.value);
@@ -560,6 +817,7 @@ def doPrimitiveStruct(type):
     name =  type.capitalize()
     structDef = structDef.replace('$name$', name);
     structDef = structDef.replace('$type$', typeToC[type]);
+    structDef = dropLayout(name, structDef, hasLayout(type))
     addStruct(name, structDef)
 
 compoundBuilder= { 'record' : doRecord, 'union' : doUnion, 'enum' : doEnum, 
@@ -592,12 +850,397 @@ def getNextLine():
 
     if line == '':
         globals()["done"] = True
-    return line.split(' ')
+    fields = line.split(' ')
+    readerLines.append(fields)
+    return fields
     
+# Resolving parse functions.  Given the flat list of a schema that data was
+# written with (--writer), the generator emits resolvingParse(), which reads
+# that data into the types generated for the reader's schema with the
+# resolution hard coded: fields the reader does not have are skipped,
+# values are promoted, enum symbols are mapped through a table, and union
+# branches are chosen, all without the Resolver tree or Layouts.  Where the
+# two schemas agree, it calls the generated parse().
+
+readerLines = []
+writerSchemas = []
+
+def readTree(lines) :
+    line = lines.pop(0)
+    type = line[0]
+    node = { 'type' : type }
+    if type in ('record', 'enum', 'symbolic') :
+        node['name'] = line[1]
+    if type == 'fixed' :
+        node['name'] = line[1]
+        node['size'] = int(line[2])
+    if type == 'record' :
+        node['fields'] = []
+        while lines[0][0] != 'end' :
+            fieldname = lines.pop(0)[1]
+            node['fields'].append((fieldname, readTree(lines)))
+    elif type == 'enum' :
+        node['symbols'] = []
+        while lines[0][0] != 'end' :
+            node['symbols'].append(lines.pop(0)[1])
+    elif type == 'array' :
+        node['items'] = readTree(lines)
+    elif type == 'map' :
+        readTree(lines) # the key, always a string
+        node['values'] = readTree(lines)
+    elif type == 'union' :
+        node['branches'] = []
+        while lines[0][0] != 'end' :
+            node['branches'].append(readTree(lines))
+    if type in ('record', 'enum', 'fixed', 'array', 'map', 'union') :
+        lines.pop(0) # end
+    return node
+
+def definitions(node, defs) :
+    if node['type'] in ('record', 'enum', 'fixed') :
+        defs[node['name']] = node
+    for child in children(node) :
+        definitions(child, defs)
+    return defs
+
+def children(node) :
+    type = node['type']
+    if type == 'record' : return [f[1] for f in node['fields']]
+    if type == 'array' : return [node['items']]
+    if type == 'map' : return [node['values']]
+    if type == 'union' : return node['branches']
+    return []
+
+def cppType(node) :
+    type = node['type']
+    if typeToC.has_key(type) : return (typeToC[type], type)
+    if type in ('record', 'enum', 'fixed', 'symbolic') : return (node['name'], node['name'])
+    if type == 'array' :
+        name = 'Array_of_' + cppType(node['items'])[1]
+    elif type == 'map' :
+        name = 'Map_of_' + cppType(node['values'])[1]
+    else :
+        name = 'Union_of' + ''.join(['_' + cppType(b)[1] for b in node['branches']])
+    return (name, name)
+
+promotions = { 'int' : ('long', 'float', 'double'), 'long' : ('float', 'double'), 'float' : ('double',) }
+
+class ResolverGenerator :
+
+    def __init__(self, writer, reader) :
+        self.writer = writer
+        self.reader = reader
+        self.writerDefs = definitions(writer, {})
+        self.readerDefs = definitions(reader, {})
+        self.functions = {}
+        self.prototypes = []
+        self.bodies = []
+
+    def fail(self, message) :
+        import sys
+        sys.stderr.write('Cannot resolve the writer schema: ' + message + '\n')
+        sys.exit(1)
+
+    def wdef(self, node) :
+        if node['type'] == 'symbolic' : return self.writerDefs[node['name']]
+        return node
+
+    def rdef(self, node) :
+        if node['type'] == 'symbolic' : return self.readerDefs[node['name']]
+        return node
+
+    # 2 if the writer's type is the reader's, 1 if it can be promoted or
+    # resolved to it, 0 if not
+    def match(self, w, r) :
+        w = self.wdef(w)
+        r = self.rdef(r)
+        if w['type'] == 'union' or r['type'] == 'union' : return 0
+        if w['type'] != r['type'] :
+            return r['type'] in promotions.get(w['type'], ()) and 1 or 0
+        if w['type'] in ('record', 'enum') : return w['name'] == r['name'] and 2 or 0
+        if w['type'] == 'fixed' : return (w['name'] == r['name'] and w['size'] == r['size']) and 2 or 0
+        if w['type'] in ('array', 'map') : return min(1, self.match(children(w)[0], children(r)[0]))
+        return 2
+
+    # whether a branch of a writer's union can be read as the reader's r;
+    # a branch that cannot is only an error if the data holds it
+    def resolvable(self, w, r) :
+        r = self.rdef(r)
+        if r['type'] == 'union' :
+            return max([self.match(w, b) for b in r['branches']]) > 0
+        return self.match(w, r) > 0
+
+    def same(self, w, r, seen) :
+        w = self.wdef(w)
+        r = self.rdef(r)
+        if w['type'] != r['type'] : return False
+        if w['type'] in ('record', 'enum', 'fixed') :
+            if w['name'] != r['name'] : return False
+            if seen.has_key(w['name']) : return True
+            seen[w['name']] = True
+        if w['type'] == 'record' :
+            if [f[0] for f in w['fields']] != [f[0] for f in r['fields']] : return False
+        elif w['type'] == 'enum' :
+            return w['symbols'] == r['symbols']
+        elif w['type'] == 'fixed' :
+            return w['size'] == r['size']
+        wc = children(w)
+        rc = children(r)
+        if len(wc) != len(rc) : return False
+        for i in range(len(wc)) :
+            if not self.same(wc[i], rc[i], seen) : return False
+        return True
+
+    def function(self, key, signature, make) :
+        if not self.functions.has_key(key) :
+            name = 'resolve%d' % len(self.functions)
+            self.functions[key] = name
+            self.prototypes.append('inline void ' + signature.replace('$func$', name) + ';\n')
+            self.bodies.append('inline void ' + signature.replace('$func$', name) + ' {\n' + make() + '}\n')
+        return self.functions[key]
+
+    # code reading the writer's w into the reader's r held in target
+    def resolve(self, w, r, target, indent) :
+        w = self.wdef(w)
+        r = self.rdef(r)
+        if w['type'] != 'union' and self.same(w, r, {}) :
+            return indent + 'parse(p, ' + target + ');\n'
+        if w['type'] == 'union' or r['type'] in ('record', 'enum', 'array', 'map', 'union') :
+            rtype = cppType(r)[0]
+            name = self.function((id(w), id(r)), '$func$(avro::Reader &p, ' + rtype + ' &val)',
+                lambda : self.compound(w, r))
+            return indent + name + '(p, ' + target + ');\n'
+        if self.match(w, r) == 1 :
+            return indent + '{ ' + typeToC[w['type']] + ' v; parse(p, v); ' + target + ' = static_cast<' + typeToC[r['type']] + '>(v); }\n'
+        self.fail(w['type'] + ' cannot be read as ' + cppType(r)[1])
+
+    def compound(self, w, r) :
+        rtype = cppType(r)[0]
+        code = ''
+        if w['type'] == 'union' :
+            code += '    switch(p.readUnion()) {\n'
+            for i in range(len(w['branches'])) :
+                branch = w['branches'][i]
+                code += '      case %d:\n' % i
+                if self.resolvable(branch, r) :
+                    code += self.resolve(branch, r, 'val', '        ')
+                else :
+                    code += '        throw avro::Exception("Writer union branch %d cannot be read as %s");\n' % (i, cppType(r)[1])
+                code += '        break;\n'
+            code += '      default:\n        throw avro::Exception("Unrecognized union choice");\n    }\n'
+        elif r['type'] == 'union' :
+            choices = [self.match(w, b) for b in r['branches']]
+            best = max(choices)
+            if best == 0 :
+                self.fail(cppType(w)[1] + ' is not in ' + cppType(r)[1])
+            k = choices.index(best)
+            code += '    ' + rtype + '::T%d chosen;\n' % k
+            code += self.resolve(w, r['branches'][k], 'chosen', '    ')
+            code += '    val.choice = %d;\n    val.value = chosen;\n' % k
+        elif w['type'] != r['type'] or not self.match(w, r) :
+            self.fail(cppType(w)[1] + ' cannot be read as ' + cppType(r)[1])
+        elif w['type'] == 'record' :
+            readerFields = dict(r['fields'])
+            code += '    p.readRecord();\n'
+            for fieldname, field in w['fields'] :
+                if readerFields.has_key(fieldname) :
+                    code += self.resolve(field, readerFields[fieldname], 'val.' + fieldname, '    ')
+                else :
+                    code += self.skip(field, '    ')
+        elif w['type'] == 'enum' :
+            table = []
+            for symbol in w['symbols'] :
+                if symbol in r['symbols'] :
+                    table.append(r['symbols'].index(symbol))
+                else :
+                    table.append(-1)
+            code += '    static const int symbols[] = { ' + ', '.join([str(t) for t in table]) + ' };\n'
+            code += '    int64_t symbol = p.readEnum();\n'
+            code += '    if(symbol < 0 || symbol >= %d || symbols[symbol] < 0) {\n' % len(table)
+            code += '        throw avro::Exception("Enum symbol is not in the reader\'s ' + r['name'] + '");\n    }\n'
+            code += '    val.value = static_cast<' + rtype + '::EnumSymbols>(symbols[symbol]);\n'
+        elif w['type'] == 'array' :
+            code += '    val.value.clear();\n'
+            code += '    for(int64_t size = p.readArrayBlockSize(); size > 0; size = p.readArrayBlockSize()) {\n'
+            code += '        val.value.reserve(val.value.size() + size);\n'
+            code += '        while(size-- > 0) {\n'
+            code += '            val.value.push_back(' + rtype + '::ValueType());\n'
+            code += self.resolve(w['items'], r['items'], 'val.value.back()', '            ')
+            code += '        }\n    }\n'
+        else :
+            code += '    val.value.clear();\n'
+            if mapKind == 'vector' :
+                value = 'val.value.back().second'
+            else :
+                value = 'val.value[key]'
+                code += '    std::string key;\n'
+            code += '    for(int64_t size = p.readMapBlockSize(); size > 0; size = p.readMapBlockSize()) {\n'
+            code += '        while(size-- > 0) {\n'
+            if mapKind == 'vector' :
+                code += '            val.value.push_back(' + rtype + '::MapType::value_type());\n'
+                code += '            parse(p, val.value.back().first);\n'
+            else :
+                code += '            parse(p, key);\n'
+            code += self.resolve(w['values'], r['values'], value, '            ')
+            code += '        }\n    }\n'
+        return code
+
+    # code reading past the writer's w
+    def skip(self, w, indent) :
+        w = self.wdef(w)
+        type = w['type']
+        if type == 'null' :
+            return ''
+        if type in ('string', 'bytes') :
+            return indent + '{ int64_t len; p.readValue(len); p.skipBytes(len); }\n'
+        if type == 'fixed' :
+            return indent + 'p.skipBytes(%d);\n' % w['size']
+        if type == 'enum' :
+            return indent + 'p.readEnum();\n'
+        if typeToC.has_key(type) :
+            return indent + '{ ' + typeToC[type] + ' v; p.readValue(v); }\n'
+        name = self.function((id(w), None), '$func$(avro::Reader &p)', lambda : self.skipCompound(w))
+        return indent + name + '(p);\n'
+
+    def skipCompound(self, w) :
+        type = w['type']
+        code = ''
+        if type == 'record' :
+            for fieldname, field in w['fields'] :
+                code += self.skip(field, '    ')
+        elif type == 'union' :
+            code += '    switch(p.readUnion()) {\n'
+            for i in range(len(w['branches'])) :
+                code += '      case %d:\n' % i
+                code += self.skip(w['branches'][i], '        ')
+                code += '        break;\n'
+            code += '      default:\n        throw avro::Exception("Unrecognized union choice");\n    }\n'
+        else :
+            if type == 'array' :
+                code += '    for(int64_t size = p.readArrayBlockSize(); size > 0; size = p.readArrayBlockSize()) {\n'
+            else :
+                code += '    for(int64_t size = p.readMapBlockSize(); size > 0; size = p.readMapBlockSize()) {\n'
+            code += '        while(size-- > 0) {\n'
+            if type == 'map' :
+                code += self.skip({ 'type' : 'string' }, '            ')
+            code += self.skip(children(w)[0], '            ')
+            code += '        }\n    }\n'
+        return code
+
+    def generate(self, label) :
+        rtype = cppType(self.reader)[0]
+        entry = self.resolve(self.writer, self.reader, 'val', '    ')
+        code = 'namespace %s {\n\n' % label
+        code += '/// Reads data written with the %s schema into the reader\'s types.\n\n' % label
+        code += ''.join(self.prototypes) + '\n'
+        code += '\n'.join(self.bodies) + '\n'
+        code += 'inline void resolvingParse(avro::Reader &p, ' + rtype + ' &val) {\n' + entry + '}\n\n'
+        code += '} // namespace %s\n' % label
+        return code
+
+# Columnar batches.  With --batch, the root record also gets a
+# struct-of-arrays twin, $name$Batch, holding one std::vector per leaf
+# field, and parseBatch(), which decodes n records and appends each of
+# their fields to its column.  Nested records are flattened into columns
+# named after the path to the field (nestedrecord_inval1); every other
+# type, a recursive record included, becomes a column of its generated
+# type.  Booleans are stored as uint8_t, so that no column is a packed
+# std::vector<bool> and a numeric column can be aggregated straight out
+# of its contiguous storage without constructing any records.  The columns
+# grow geometrically however few records each call parses, and a call that
+# throws leaves the batch as it found it, every column the same length.
+
+batch = False
+
+batchTemplate = '''struct $name$Batch {
+$columns$
+    size_t size() const {
+        return $first$.size();
+    }
+
+    void reserve(size_t n) {
+$reserve$    }
+
+    void grow(size_t n) {
+        if($first$.capacity() < n) {
+            size_t doubled = 2 * $first$.capacity();
+            reserve(n < doubled ? doubled : n);
+        }
+    }
+
+    void resize(size_t n) {
+$resize$    }
+
+    void clear() {
+$clear$    }
+};
+
+template <typename Parser>
+inline void parseBatch(Parser &p, $name$Batch &val, size_t n) {
+    const size_t start = val.size();
+    val.grow(start + n);
+    try {
+        for (size_t i = 0; i < n; ++i) {
+$parsecolumns$        }
+    }
+    catch(...) {
+        val.resize(start);
+        throw;
+    }
+}
+'''
+
+boolColumnTemplate = '''        {
+            bool value;
+            parse(p, value);
+            val.$column$.push_back(value);
+        }
+'''
+
+def batchColumns(node, prefix, defs, seen, columns, parse) :
+    parse.append('        p.readRecord();\n')
+    for fieldname, field in node['fields'] :
+        column = prefix + fieldname
+        if field['type'] == 'symbolic' and defs.has_key(field['name']) :
+            field = defs[field['name']]
+        if field['type'] == 'record' and field['name'] not in seen :
+            batchColumns(field, column + '_', defs, seen + [field['name']], columns, parse)
+        elif field['type'] == 'boolean' :
+            columns.append(('uint8_t', column))
+            parse.append(boolColumnTemplate.replace('$column$', column))
+        else :
+            ctype = cppType(field)[0]
+            columns.append((ctype.endswith('>') and ctype + ' ' or ctype, column))
+            parse.append('        val.%s.push_back(%s());\n' % (column, ctype))
+            parse.append('        parse(p, val.%s.back());\n' % column)
+
+def generateBatch() :
+    root = readTree(list(readerLines))
+    if root['type'] != 'record' :
+        return ''
+    columns = []
+    parse = []
+    batchColumns(root, '', definitions(root, {}), [root['name']], columns, parse)
+    if not columns :
+        return ''
+    code = batchTemplate.replace('$name$', root['name'])
+    code = code.replace('$first$', columns[0][1])
+    code = code.replace('$columns$', ''.join(['    std::vector<%s> %s;\n' % c for c in columns]))
+    code = code.replace('$reserve$', ''.join(['        %s.reserve(n);\n' % c[1] for c in columns]))
+    code = code.replace('$resize$', ''.join(['        %s.resize(n);\n' % c[1] for c in columns]))
+    code = code.replace('$clear$', ''.join(['        %s.clear();\n' % c[1] for c in columns]))
+    code = code.replace('$parsecolumns$', ''.join(['    ' + line for line in ''.join(parse).splitlines(True)]))
+    return code
+
 def writeHeader():
     print "#ifndef %s_AvroGenerated_hh__" % namespace
     print "#define %s_AvroGenerated_hh__" % namespace
-    print headers
+    print headers + mapKinds[mapKind]['header']
+    if views:
+        print '#include "View.hh"'
+    if writerSchemas:
+        print '#include "Reader.hh"'
+
     print "namespace %s {\n" % namespace
 
     for x in forwardDeclareList:
@@ -607,6 +1250,12 @@ def writeHeader():
         print "/*----------------------------------------------------------------------------------*/\n"
         print "%s\n" % x
 
+    if batch:
+        code = generateBatch()
+        if code:
+            print "/*----------------------------------------------------------------------------------*/\n"
+            print "%s\n" % code
+
     print "\n} // namespace %s\n" % namespace
 
     print "namespace avro {\n"
@@ -615,6 +1264,13 @@ def writeHeader():
 
     print "\n} // namespace avro\n"
 
+    if writerSchemas:
+        reader = readTree(list(readerLines))
+        print "namespace %s {\n" % namespace
+        for label, lines in writerSchemas:
+            print ResolverGenerator(readTree(lines), reader).generate(label)
+        print "} // namespace %s\n" % namespace
+
     print "#endif // %s_AvroGenerated_hh__" % namespace
 
 
@@ -623,13 +1279,25 @@ def usage():
     print "-i, --input=FILE      input file to read (default is stdin)"
     print "-o, --output=PATH     output file to generate (default is stdout)"
     print "-n, --namespace=LABEL namespace for schema (default is avrouser)"
+    print "-w, --writer=LABEL:FILE  emit LABEL::resolvingParse(), which reads data"
+    print "                      written with the schema precompiled in FILE into"
+    print "                      the generated types (may be repeated)"
+    print "-m, --maps=KIND       container for maps: map (std::map, the default),"
+    print "                      hash (boost::unordered_map) or vector (the entries"
+    print "                      in decode order)"
+    print "-r, --reuse           parse() reuses the containers and strings of the"
+    print "                      object it overwrites"
+    print "-v, --views           string and bytes fields point into the parsed"
+    print "                      buffer (avro::View) instead of copying it"
+    print "-b, --batch           also emit a struct-of-arrays batch of the root"
+    print "                      record and parseBatch(), which fills it"
 
 if __name__ == "__main__":
     from sys import argv
     import getopt,sys
 
     try:
-        opts, args = getopt.getopt(argv[1:], "hi:o:n:", ["help", "input=", "output=", "namespace="])
+        opts, args = getopt.getopt(argv[1:], "hi:o:n:m:w:rvb", ["help", "input=", "output=", "namespace=", "maps=", "writer=", "reuse", "views", "batch"])
 
     except getopt.GetoptError, err:
         print str(err) 
@@ -659,6 +1327,28 @@ if __name__ == "__main__":
                 print "Could not open file " + a
         elif o in ("-n", "--namespace"):
             namespace = a
+        elif o in ("-m", "--maps"):
+            if not mapKinds.has_key(a):
+                print "Unknown map container " + a
+                usage()
+                sys.exit(2)
+            mapKind = a
+        elif o in ("-r", "--reuse"):
+            reuse = True
+        elif o in ("-v", "--views"):
+            useViews()
+        elif o in ("-b", "--batch"):
+            batch = True
+        elif o in ("-w", "--writer"):
+            try:
+                label, path = a.split(':', 1)
+                writerFile = open(path, 'r')
+                lines = [line.rstrip('\n').split(' ') for line in writerFile if line.strip()]
+                writerFile.close()
+                writerSchemas.append((label, lines))
+            except:
+                print "Could not read writer schema " + a
+                sys.exit(2)
         elif o in ("-h", "--help"):
             usage()
             sys.exit()
@@ -0,0 +1,510 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Times the library's alternative code paths against each other.  This is
+// built by "make check" but not run as a test, since the numbers only mean
+// something on a quiet machine:
+//
+//     top_srcdir=. ./benchmark [iterations]
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <new>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Compiler.hh"
+#include "BinarySchema.hh"
+#include "Schema.hh"
+#include "ValidSchema.hh"
+#include "Writer.hh"
+#include "UncheckedWriter.hh"
+#include "ValidatingWriter.hh"
+#include "ValidatingReader.hh"
+#include "JsonWriter.hh"
+#include "JsonReader.hh"
+#include "ResolverSchema.hh"
+#include "ResolvingReader.hh"
+#include "InputStreamer.hh"
+#include "OutputStreamer.hh"
+#include "testgen.hh" // < generated header
+#include "testgen2.hh" // < generated header, with bigrecord::resolvingParse()
+
+// counts every heap allocation, for the benchmarks that report them
+size_t gAllocations = 0;
+
+void *operator new(size_t size) throw(std::bad_alloc)
+{
+    ++gAllocations;
+    void *p = malloc(size ? size : 1);
+    if(p == 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) throw()
+{
+    free(p);
+}
+
+namespace {
+
+double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+void report(const std::string &name, double seconds, int iterations)
+{
+    std::cout << name << ": " << (seconds * 1e6 / iterations) << " us per iteration\n";
+}
+
+void reportThroughput(const std::string &name, double seconds, size_t bytes)
+{
+    std::cout << name << ": " << (bytes / seconds / 1e6) << " MB/s\n";
+}
+
+std::string gSrcPath(".");
+
+// verboseint is left out: its metadata is not JSON, which only the flex
+// lexer's lenient skipping accepts
+const char *gSchemas[] = {
+    "array", "bigrecord", "bigrecord2", "enum", "fixed", "int", "map",
+    "nested", "recinrec", "record", "record2", "union", "unionwithmap"
+};
+
+void readSchema(const char *name, avro::ValidSchema &schema)
+{
+    std::string file = gSrcPath + "/jsonschemas/" + name;
+    std::ifstream in(file.c_str());
+    if(!in.good()) {
+        std::cerr << "Cannot read " << file << '\n';
+        exit(1);
+    }
+    avro::compileJsonSchema(in, schema);
+}
+
+std::vector<std::string> readSchemas()
+{
+    std::vector<std::string> schemas;
+    for(size_t i = 0; i < sizeof(gSchemas) / sizeof(gSchemas[0]); ++i) {
+        std::string file = gSrcPath + "/jsonschemas/" + gSchemas[i];
+        std::ifstream in(file.c_str());
+        if(!in.good()) {
+            std::cerr << "Cannot read " << file << '\n';
+            exit(1);
+        }
+        schemas.push_back(std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>()));
+    }
+    return schemas;
+}
+
+// Compiles every schema in jsonschemas with the flex/bison compiler and with
+// the in-memory compiler, and loads them from their binary form.
+void benchCompiler(int iterations)
+{
+    std::vector<std::string> schemas = readSchemas();
+
+    double start = now();
+    for(int i = 0; i < iterations; ++i) {
+        for(size_t j = 0; j < schemas.size(); ++j) {
+            std::istringstream is(schemas[j]);
+            avro::ValidSchema schema;
+            avro::compileJsonSchema(is, schema);
+        }
+    }
+    report("compileJsonSchema(istream) all jsonschemas", now() - start, iterations);
+
+    start = now();
+    for(int i = 0; i < iterations; ++i) {
+        for(size_t j = 0; j < schemas.size(); ++j) {
+            avro::ValidSchema schema;
+            avro::compileJsonSchema(schemas[j].data(), schemas[j].size(), schema);
+        }
+    }
+    report("compileJsonSchema(memory)  all jsonschemas", now() - start, iterations);
+
+    std::vector<std::vector<uint8_t> > binaries(schemas.size());
+    for(size_t j = 0; j < schemas.size(); ++j) {
+        avro::ValidSchema schema;
+        avro::compileJsonSchema(schemas[j].data(), schemas[j].size(), schema);
+        avro::writeBinarySchema(schema, binaries[j]);
+    }
+
+    start = now();
+    for(int i = 0; i < iterations; ++i) {
+        for(size_t j = 0; j < binaries.size(); ++j) {
+            avro::ValidSchema schema;
+            avro::readBinarySchema(&binaries[j][0], binaries[j].size(), schema);
+        }
+    }
+    report("readBinarySchema           all jsonschemas", now() - start, iterations);
+}
+
+// Looks up every field of a 600 field record by name, before the record is
+// locked (map) and after ValidSchema has locked it (frozen hash table).
+void benchNameIndex(int iterations)
+{
+    const int fields = 600;
+    std::vector<std::string> names;
+    avro::RecordSchema building("Wide");
+    avro::RecordSchema locked("Wide");
+    for(int i = 0; i < fields; ++i) {
+        std::ostringstream name;
+        name << "field_" << i;
+        names.push_back(name.str());
+        building.addField(name.str(), avro::LongSchema());
+        locked.addField(name.str(), avro::LongSchema());
+    }
+    avro::ValidSchema schema(locked);
+
+    const avro::NodePtr *nodes[] = { &building.root(), &schema.root() };
+    const char *labels[] = {
+        "nameIndex 600 fields, unlocked", 
+        "nameIndex 600 fields, locked  "
+    };
+    for(int n = 0; n < 2; ++n) {
+        const avro::NodePtr &node = *nodes[n];
+        size_t sum = 0;
+        double start = now();
+        for(int i = 0; i < iterations; ++i) {
+            for(int j = 0; j < fields; ++j) {
+                size_t index = 0;
+                node->nameIndex(names[j], index);
+                sum += index;
+            }
+        }
+        if(sum != static_cast<size_t>(iterations) * fields * (fields - 1) / 2) {
+            std::cerr << "nameIndex returned wrong indices\n";
+            exit(1);
+        }
+        report(labels[n], now() - start, iterations);
+    }
+}
+
+// Counts the bytes written to it and drops them, so that only the
+// serializer's own work is measured.
+class SinkStreamer : public avro::OutputStreamer {
+
+  public:
+
+    SinkStreamer() :
+        size_(0)
+    {}
+
+    size_t writeByte(uint8_t) {
+        return write(1);
+    }
+
+    size_t writeWord(uint32_t) {
+        return write(4);
+    }
+
+    size_t writeLongWord(uint64_t) {
+        return write(8);
+    }
+
+    size_t writeBytes(const void *, size_t size) {
+        return write(size);
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+  private:
+
+    size_t write(size_t size) {
+        size_ += size;
+        return size;
+    }
+
+    size_t size_;
+};
+
+// testgen's RootRecord, with strings too long for a small string buffer
+void makeRecord(testgen::RootRecord &record)
+{
+    record.mylong = 212;
+    record.nestedrecord.inval2 = "a string longer than any small string buffer";
+    record.mymap.addValue("a key longer than any small string buffer", 100);
+    record.mymap.addValue("two", 200);
+    record.myarray.addValue(3434.9);
+    record.myarray.addValue(-63445.9);
+    testgen::Map_of_int map;
+    map.addValue("another key longer than any small string buffer", 1);
+    record.myunion.set_Map_of_int(map);
+    record.anotherunion.set_bytes(std::vector<uint8_t>(64, 1));
+    record.anothernested.inval2 = "another string longer than any small string buffer";
+    memset(record.myfixed.value, 0, testgen::md5::fixedSize);
+    record.bytes.resize(64, 2);
+}
+
+// Serializes the record and counts the heap allocations it takes.
+void benchSerialize(int iterations)
+{
+    testgen::RootRecord record;
+    makeRecord(record);
+
+    SinkStreamer out;
+    avro::Writer writer(out);
+    size_t before = gAllocations;
+    double start = now();
+    for(int i = 0; i < iterations; ++i) {
+        avro::serialize(writer, record);
+    }
+    double seconds = now() - start;
+    size_t allocations = gAllocations - before;
+    report("serialize testgen::RootRecord", seconds, iterations);
+    std::cout << "serialize testgen::RootRecord: " 
+        << static_cast<double>(allocations) / iterations 
+        << " allocations per record, " << out.size() / iterations << " bytes\n";
+}
+
+// Serializes the record through an OStreamer, and with an UncheckedWriter
+// into memory sized once up front, or sized for each record.
+void benchUncheckedWriter(int iterations)
+{
+    testgen::RootRecord record;
+    makeRecord(record);
+
+    std::ostringstream ostring;
+    avro::OStreamer os(ostring);
+    avro::Writer writer(os);
+    double start = now();
+    for(int i = 0; i < iterations; ++i) {
+        ostring.seekp(0);
+        avro::serialize(writer, record);
+    }
+    report("serialize Writer(OStreamer)        ", now() - start, iterations);
+
+    std::vector<uint8_t> buffer(avro::encodedSize(record));
+    size_t size = 0;
+    start = now();
+    for(int i = 0; i < iterations; ++i) {
+        avro::UncheckedWriter unchecked(&buffer[0]);
+        avro::serialize(unchecked, record);
+        size += unchecked.size();
+    }
+    report("serialize UncheckedWriter          ", now() - start, iterations);
+
+    start = now();
+    for(int i = 0; i < iterations; ++i) {
+        size_t needed = avro::encodedSize(record);
+        if(needed > buffer.size()) {
+            buffer.resize(needed);
+        }
+        avro::UncheckedWriter unchecked(&buffer[0]);
+        avro::serialize(unchecked, record);
+        size += unchecked.size();
+    }
+    report("encodedSize + UncheckedWriter      ", now() - start, iterations);
+
+    if(size != 2 * iterations * ostring.str().size()) {
+        std::cerr << "UncheckedWriter wrote the wrong number of bytes\n";
+        exit(1);
+    }
+}
+
+std::string encodeRecord(const testgen::RootRecord &record)
+{
+    std::ostringstream ostring;
+    avro::OStreamer os(ostring);
+    avro::Writer writer(os);
+    avro::serialize(writer, record);
+    return ostring.str();
+}
+
+// Serializes and parses the record, each with a new writer or reader, with
+// and without validation against the bigrecord schema.
+void benchValidation(int iterations)
+{
+    avro::ValidSchema schema;
+    readSchema("bigrecord", schema);
+    testgen::RootRecord record;
+    makeRecord(record);
+
+    SinkStreamer out;
+    double start = now();
+    for(int i = 0; i < iterations; ++i) {
+        avro::Writer writer(out);
+        avro::serialize(writer, record);
+    }
+    report("serialize Writer                   ", now() - start, iterations);
+
+    start = now();
+    for(int i = 0; i < iterations; ++i) {
+        avro::ValidatingWriter writer(schema, out);
+        avro::serialize(writer, record);
+    }
+    report("serialize ValidatingWriter         ", now() - start, iterations);
+
+    std::string data = encodeRecord(record);
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.data());
+    testgen::RootRecord parsed;
+
+    start = now();
+    for(int i = 0; i < iterations; ++i) {
+        avro::MemoryStreamer in(bytes, data.size());
+        avro::Reader reader(in);
+        avro::parse(reader, parsed);
+    }
+    report("parse Reader                       ", now() - start, iterations);
+
+    start = now();
+    for(int i = 0; i < iterations; ++i) {
+        avro::MemoryStreamer in(bytes, data.size());
+        avro::ValidatingReader reader(schema, in);
+        avro::parse(reader, parsed);
+    }
+    report("parse ValidatingReader             ", now() - start, iterations);
+}
+
+// Writes the record as JSON and reads it back, in a stream of as many
+// records as there are iterations.
+void benchJson(int iterations)
+{
+    avro::ValidSchema schema;
+    readSchema("bigrecord", schema);
+    testgen::RootRecord record;
+    makeRecord(record);
+
+    SinkStreamer out;
+    avro::JsonWriter writer(schema, out);
+    double start = now();
+    for(int i = 0; i < iterations; ++i) {
+        avro::serialize(writer, record);
+    }
+    reportThroughput("JsonWriter bigrecord               ", now() - start, out.size());
+
+    std::ostringstream ostring;
+    {
+        avro::OStreamer os(ostring);
+        avro::JsonWriter json(schema, os);
+        for(int i = 0; i < iterations; ++i) {
+            avro::serialize(json, record);
+        }
+    }
+    std::string data = ostring.str();
+
+    avro::MemoryStreamer in(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+    avro::JsonReader reader(schema, in);
+    testgen::RootRecord parsed;
+    start = now();
+    for(int i = 0; i < iterations; ++i) {
+        avro::parse(reader, parsed);
+    }
+    reportThroughput("JsonReader bigrecord               ", now() - start, data.size());
+}
+
+// Parses data written with bigrecord into a new testgen2::RootRecord, whose
+// schema is bigrecord2, with the runtime resolver and with the generated
+// resolvingParse(), against parsing the same record written with bigrecord2
+// into it with parse().
+void benchResolving(int iterations)
+{
+    avro::ValidSchema writerSchema;
+    readSchema("bigrecord", writerSchema);
+    avro::ValidSchema readerSchema;
+    readSchema("bigrecord2", readerSchema);
+
+    testgen::RootRecord record;
+    makeRecord(record);
+    std::string data = encodeRecord(record);
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.data());
+
+    std::string sameData;
+    {
+        avro::MemoryStreamer in(bytes, data.size());
+        avro::Reader reader(in);
+        testgen2::RootRecord resolved;
+        testgen2::bigrecord::resolvingParse(reader, resolved);
+
+        std::ostringstream ostring;
+        avro::OStreamer os(ostring);
+        avro::Writer writer(os);
+        avro::serialize(writer, resolved);
+        sameData = ostring.str();
+    }
+    const uint8_t *sameBytes = reinterpret_cast<const uint8_t *>(sameData.data());
+
+    double start = now();
+    for(int i = 0; i < iterations; ++i) {
+        avro::MemoryStreamer in(sameBytes, sameData.size());
+        avro::Reader reader(in);
+        testgen2::RootRecord parsed;
+        avro::parse(reader, parsed);
+    }
+    report("parse, same schema                 ", now() - start, iterations);
+
+    testgen2::RootRecord_Layout layout;
+    avro::ResolverSchema resolverSchema(writerSchema, readerSchema, layout);
+    start = now();
+    for(int i = 0; i < iterations; ++i) {
+        avro::MemoryStreamer in(bytes, data.size());
+        avro::ResolvingReader reader(resolverSchema, in);
+        testgen2::RootRecord parsed;
+        reader.parse(parsed);
+    }
+    report("ResolvingReader::parse             ", now() - start, iterations);
+
+    start = now();
+    for(int i = 0; i < iterations; ++i) {
+        avro::MemoryStreamer in(bytes, data.size());
+        avro::Reader reader(in);
+        testgen2::RootRecord parsed;
+        testgen2::bigrecord::resolvingParse(reader, parsed);
+    }
+    report("generated resolvingParse           ", now() - start, iterations);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *srcPath = getenv("top_srcdir");
+    if(srcPath) {
+        gSrcPath = srcPath;
+    }
+    int iterations = (argc > 1) ? atoi(argv[1]) : 1000;
+
+    try {
+        benchCompiler(iterations);
+        benchNameIndex(iterations);
+        benchSerialize(iterations);
+        benchUncheckedWriter(iterations);
+        benchValidation(iterations);
+        benchJson(iterations);
+        benchResolving(iterations);
+    }
+    catch (std::exception &e) {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+#include "CodeGenerator.hh"
+#include "Compiler.hh"
+#include "ValidSchema.hh"
+
+// Compiles the schema on stdin and prints the C++ header for its types,
+// with compile-time traits for each of them (see CodeGenerator.hh).
+
+int main(int argc, char **argv)
+{
+    std::string ns("avrouser");
+    if(argc == 3 && strcmp(argv[1], "-n") == 0) {
+        ns = argv[2];
+    }
+    else if(argc != 1) {
+        std::cerr << "Usage: " << argv[0] << " [-n namespace] < schema" << std::endl;
+        return 1;
+    }
+
+    try {
+        avro::ValidSchema schema;
+        avro::compileJsonSchema(std::cin, schema);
+        avro::generateCppCode(schema, ns, std::cout);
+    }
+    catch (std::exception &e) {
+        std::cerr << "Failed to generate code for schema: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -18,18 +18,43 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fstream>
 
 #include "Compiler.hh"
 #include "ValidSchema.hh"
+#include "BinarySchema.hh"
 
-int main()
+// Compiles the schema on stdin and prints its flat list.  With -b, the
+// compiled schema is also saved to a file in binary form (see
+// BinarySchema.hh), to be loaded later without compiling it again.
+
+int main(int argc, char **argv)
 {
+    const char *binaryFile = 0;
+    if(argc == 3 && strcmp(argv[1], "-b") == 0) {
+        binaryFile = argv[2];
+    }
+    else if(argc != 1) {
+        std::cerr << "Usage: " << argv[0] << " [-b binary-schema-file] < schema" << std::endl;
+        return 1;
+    }
+
     int ret = 0;
     try {
         avro::ValidSchema schema;
         avro::compileJsonSchema(std::cin, schema);
 
         schema.toFlatList(std::cout);
+
+        if(binaryFile) {
+            std::ofstream out(binaryFile, std::ios::binary);
+            avro::writeBinarySchema(schema, out);
+            if(!out.good()) {
+                std::cerr << "Failed to write " << binaryFile << std::endl;
+                ret = 1;
+            }
+        }
     }
     catch (std::exception &e) {
         std::cerr << "Failed to parse or compile schema: " << e.what() << std::endl;
@@ -18,17 +18,29 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <new>
 #include <fstream>
 #include <sstream>
 #include <boost/test/included/unit_test_framework.hpp>
 
 #include "testgen.hh" // < generated header
 #include "testgen2.hh" // < generated header
+#include "testgen3.hh" // < generated header, maps are hash tables
+#include "testgen4.hh" // < generated header, maps are vectors
+#include "testgen5.hh" // < generated header, strings and bytes are views
+#include "testgen6.hh" // < generated header, parse() reuses the object
+#include "testgen7.hh" // < generated by gencppcode, with schema_traits
+#include "testgen8.hh" // < generated header, with a columnar RootRecordBatch
 
 #include "OutputStreamer.hh"
 #include "InputStreamer.hh"
 #include "Serializer.hh"
+#include "SingleObject.hh"
+#include "SchemaRegistry.hh"
+#include "JsonWriter.hh"
+#include "JsonReader.hh"
 #include "Writer.hh"
+#include "UncheckedWriter.hh"
 #include "ValidatingWriter.hh"
 #include "Reader.hh"
 #include "ValidatingReader.hh"
@@ -37,6 +49,28 @@
 #include "Compiler.hh"
 #include "ResolvingReader.hh"
 #include "ResolverSchema.hh"
+#include "ResolverCache.hh"
+#include "Transcoder.hh"
+#include "BatchReader.hh"
+
+// counts the heap allocations of the whole program, so tests can check
+// that a piece of code makes none
+size_t gAllocations = 0;
+
+void *operator new(size_t size) throw(std::bad_alloc)
+{
+    ++gAllocations;
+    void *p = malloc(size ? size : 1);
+    if(p == 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) throw()
+{
+    free(p);
+}
 
 std::string gWriter ("jsonschemas/bigrecord");
 std::string gReader ("jsonschemas/bigrecord2");
@@ -174,10 +208,9 @@ void setRecord(testgen::RootRecord &myRecord)
     myRecord.nestedrecord.inval2 = "hello world";
     myRecord.nestedrecord.inval3 = std::numeric_limits<int32_t>::max();
 
-    Map_of_int::GenericSetter setter = myRecord.mymap.genericSetter;
-    Map_of_int::ValueType *val = setter(&myRecord.mymap, "one");
+    Map_of_int::ValueType *val = Map_of_int::genericSet(&myRecord.mymap, "one");
     *val = 100;
-    val = setter(&myRecord.mymap, "two");
+    val = Map_of_int::genericSet(&myRecord.mymap, "two");
     *val = 200;
 
     myRecord.myarray.addValue(3434.9);
@@ -336,6 +369,300 @@ struct TestCodeGenerator {
         //checkOk(myRecord_, inRecord);
     }
 
+    void testParserJson()
+    {
+        std::ostringstream ostring;
+        avro::OStreamer os(ostring);
+        avro::JsonWriter s (schema_, os);
+
+        avro::serialize(s, myRecord_);
+
+        testgen::RootRecord inRecord;
+        std::istringstream istring(ostring.str());
+        avro::IStreamer is(istring);
+        avro::JsonReader p(schema_, is);
+        avro::parse(p, inRecord);
+
+        checkOk(myRecord_, inRecord);
+    }
+
+    template<typename T>
+    void parseString(const std::string &data, T &record)
+    {
+        std::istringstream istring(data);
+        avro::IStreamer is(istring);
+        avro::Reader p(is);
+        avro::parse(p, record);
+    }
+
+    void testMapContainers()
+    {
+        std::ostringstream ostring;
+        avro::OStreamer os(ostring);
+        avro::Writer s (os);
+        avro::serialize(s, myRecord_);
+        std::string data = ostring.str();
+
+        testgen3::RootRecord hashed;
+        parseString(data, hashed);
+        BOOST_CHECK_EQUAL(hashed.mymap.value.size(), 2U);
+        BOOST_CHECK_EQUAL(hashed.mymap.value["one"], 100);
+        BOOST_CHECK_EQUAL(hashed.mymap.value["two"], 200);
+        const testgen3::Map_of_int &unionMap = hashed.myunion.getValue<testgen3::Map_of_int>();
+        BOOST_CHECK_EQUAL(unionMap.value.size(), 2U);
+        BOOST_CHECK(unionMap.value.find("two") != unionMap.value.end());
+
+        // the entries stay in the order they were written
+        testgen4::RootRecord flat;
+        parseString(data, flat);
+        const testgen4::Map_of_int::MapType &entries = flat.mymap.value;
+        BOOST_REQUIRE_EQUAL(entries.size(), 2U);
+        BOOST_CHECK_EQUAL(entries[0].first, "one");
+        BOOST_CHECK_EQUAL(entries[0].second, 100);
+        BOOST_CHECK_EQUAL(entries[1].first, "two");
+        BOOST_CHECK_EQUAL(entries[1].second, 200);
+
+        std::ostringstream rewritten;
+        avro::OStreamer ros(rewritten);
+        avro::Writer rs (ros);
+        avro::serialize(rs, flat);
+        BOOST_CHECK(rewritten.str() == data);
+
+        // parsing again replaces the entries
+        parseString(data, flat);
+        BOOST_CHECK_EQUAL(flat.mymap.value.size(), 2U);
+    }
+
+    void testViews()
+    {
+        std::ostringstream ostring;
+        avro::OStreamer os(ostring);
+        avro::Writer s (os);
+        avro::serialize(s, myRecord_);
+        std::string data = ostring.str();
+        const uint8_t *begin = reinterpret_cast<const uint8_t *>(data.data());
+        const uint8_t *end = begin + data.size();
+
+        testgen5::RootRecord viewed;
+        avro::MemoryStreamer ms(begin, data.size());
+        avro::Reader p(ms);
+        avro::parse(p, viewed);
+        BOOST_CHECK_EQUAL(ms.remaining(), 0U);
+
+        const avro::View &inval2 = viewed.nestedrecord.inval2;
+        BOOST_CHECK(inval2 == myRecord_.nestedrecord.inval2);
+        BOOST_CHECK(inval2.data > begin && inval2.data + inval2.size < end);
+        BOOST_CHECK_EQUAL(viewed.anothernested.inval2.str(), myRecord_.anothernested.inval2);
+        BOOST_REQUIRE_EQUAL(viewed.bytes.size, 2U);
+        BOOST_CHECK_EQUAL(viewed.bytes.data[0], 10);
+        BOOST_CHECK_EQUAL(viewed.bytes.data[1], 20);
+        BOOST_REQUIRE_EQUAL(viewed.anotherunion.choice, 0);
+        const avro::View &unionBytes = viewed.anotherunion.getValue<avro::View>();
+        BOOST_REQUIRE_EQUAL(unionBytes.size, 2U);
+        BOOST_CHECK_EQUAL(unionBytes.data[1], 2);
+        BOOST_CHECK_EQUAL(viewed.mymap.value["two"], 200);
+
+        // a record of no arrays, maps or unions parses without allocating
+        std::ostringstream nestedString;
+        {
+            avro::OStreamer nos(nestedString);
+            avro::Writer ns(nos);
+            avro::serialize(ns, myRecord_.nestedrecord);
+        }
+        const std::string nestedData = nestedString.str();
+        testgen5::Nested nested;
+        size_t before = gAllocations;
+        for(int i = 0; i < 10; ++i) {
+            avro::MemoryStreamer nms(reinterpret_cast<const uint8_t *>(nestedData.data()), nestedData.size());
+            avro::Reader np(nms);
+            avro::parse(np, nested);
+        }
+        BOOST_CHECK_EQUAL(gAllocations - before, 0U);
+        BOOST_CHECK(nested.inval2 == myRecord_.nestedrecord.inval2);
+
+        std::ostringstream rewritten;
+        avro::OStreamer ros(rewritten);
+        avro::Writer rs (ros);
+        avro::serialize(rs, viewed);
+        BOOST_CHECK(rewritten.str() == data);
+
+        // a stream has no buffer to point into
+        std::istringstream istring(data);
+        avro::IStreamer is(istring);
+        avro::Reader streamed(is);
+        BOOST_CHECK_THROW(avro::parse(streamed, viewed), avro::Exception);
+    }
+
+    template<typename T>
+    std::string serializeString(const T &record)
+    {
+        std::ostringstream ostring;
+        avro::OStreamer os(ostring);
+        avro::Writer s (os);
+        avro::serialize(s, record);
+        return ostring.str();
+    }
+
+    template<typename T>
+    void parseMemory(const std::string &data, T &record)
+    {
+        avro::MemoryStreamer ms(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+        avro::Reader p(ms);
+        avro::parse(p, record);
+    }
+
+    void testReuse()
+    {
+        testgen::RootRecord source = myRecord_;
+        source.nestedrecord.inval2 = "a string longer than any small string buffer";
+        source.bytes.resize(100, 7);
+        std::string data = serializeString(source);
+
+        testgen6::RootRecord record;
+        parseMemory(data, record);
+
+        size_t before = gAllocations;
+        for(int i = 0; i < 10; ++i) {
+            parseMemory(data, record);
+        }
+        BOOST_CHECK_EQUAL(gAllocations - before, 0U);
+        BOOST_CHECK(serializeString(record) == data);
+
+        // a record of another shape still overwrites everything
+        testgen::RootRecord other = myRecord_;
+        other.mymap.value.erase("one");
+        other.mymap.value["three"] = 300;
+        other.myarray.value.pop_back();
+        other.myunion.set_float(1.5);
+        other.bytes.clear();
+        data = serializeString(other);
+        parseMemory(data, record);
+        BOOST_CHECK(serializeString(record) == data);
+        BOOST_CHECK_EQUAL(record.mymap.value.size(), 2U);
+        BOOST_CHECK_EQUAL(record.mymap.value["three"], 300);
+    }
+
+    void testEncodedSize()
+    {
+        std::string data = serializeString(myRecord_);
+        BOOST_CHECK_EQUAL(avro::encodedSize(myRecord_), data.size());
+
+        testgen::RootRecord empty;
+        BOOST_CHECK_EQUAL(avro::encodedSize(empty), serializeString(empty).size());
+
+        testgen4::RootRecord flat;
+        parseString(data, flat);
+        BOOST_CHECK_EQUAL(avro::encodedSize(flat), data.size());
+
+        testgen5::RootRecord viewed;
+        parseMemory(data, viewed);
+        BOOST_CHECK_EQUAL(avro::encodedSize(viewed), data.size());
+
+        BOOST_CHECK_EQUAL(avro::encodedSize(myRecord_.nestedrecord), 
+            8 + 1 + myRecord_.nestedrecord.inval2.size() + 5);
+    }
+
+    void testUncheckedWriter()
+    {
+        std::string data = serializeString(myRecord_);
+        std::vector<uint8_t> buffer(avro::encodedSize(myRecord_) + 1, 0xff);
+        avro::UncheckedWriter w(&buffer[0]);
+        avro::serialize(w, myRecord_);
+        BOOST_REQUIRE_EQUAL(w.size(), data.size());
+        BOOST_CHECK(memcmp(data.data(), &buffer[0], data.size()) == 0);
+        BOOST_CHECK_EQUAL(buffer.back(), 0xff);
+    }
+
+    void testBatch()
+    {
+        testgen::RootRecord second = myRecord_;
+        second.mylong = -5;
+        second.nestedrecord.inval1 = 0.25;
+        second.anothernested.inval3 = 42;
+        second.mybool = !myRecord_.mybool;
+        second.myarray.value.push_back(9.5);
+        std::string data = serializeString(myRecord_) + serializeString(second);
+
+        testgen8::RootRecordBatch batch;
+        avro::MemoryStreamer ms(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+        avro::Reader p(ms);
+        testgen8::parseBatch(p, batch, 1);
+        testgen8::parseBatch(p, batch, 1);
+
+        BOOST_CHECK_EQUAL(batch.size(), 2U);
+        BOOST_CHECK_EQUAL(batch.mylong[0], myRecord_.mylong);
+        BOOST_CHECK_EQUAL(batch.mylong[1], -5);
+        BOOST_CHECK_EQUAL(batch.nestedrecord_inval1[0], myRecord_.nestedrecord.inval1);
+        BOOST_CHECK_EQUAL(batch.nestedrecord_inval1[1], 0.25);
+        BOOST_CHECK_EQUAL(batch.nestedrecord_inval2[1], myRecord_.nestedrecord.inval2);
+        BOOST_CHECK_EQUAL(batch.anothernested_inval3[1], 42);
+        BOOST_CHECK_EQUAL(batch.mybool[0], myRecord_.mybool);
+        BOOST_CHECK_EQUAL(batch.mybool[1], second.mybool);
+        BOOST_CHECK_EQUAL(batch.myarray[1].value.size(), myRecord_.myarray.value.size() + 1);
+        BOOST_CHECK_EQUAL(batch.anotherint[1], myRecord_.anotherint);
+        BOOST_CHECK(batch.bytes[1] == myRecord_.bytes);
+
+        // a record cut short throws and leaves every column as it was
+        std::string truncated = data.substr(0, data.size() / 2 + data.size() / 4);
+        avro::MemoryStreamer tms(reinterpret_cast<const uint8_t *>(truncated.data()), truncated.size());
+        avro::Reader tp(tms);
+        BOOST_CHECK_THROW(testgen8::parseBatch(tp, batch, 2), avro::Exception);
+        BOOST_CHECK_EQUAL(batch.size(), 2U);
+        BOOST_CHECK_EQUAL(batch.nestedrecord_inval2.size(), 2U);
+        BOOST_CHECK_EQUAL(batch.anothernested_inval1.size(), 2U);
+        BOOST_CHECK_EQUAL(batch.bytes.size(), 2U);
+        BOOST_CHECK_EQUAL(batch.mylong[1], -5);
+
+        // parsing a record at a time still grows the columns geometrically
+        std::string many;
+        for(int i = 0; i < 64; ++i) {
+            many += data;
+        }
+        batch.clear();
+        avro::MemoryStreamer mms(reinterpret_cast<const uint8_t *>(many.data()), many.size());
+        avro::Reader mp(mms);
+        size_t growths = 0;
+        for(int i = 0; i < 128; ++i) {
+            size_t capacity = batch.bytes.capacity();
+            testgen8::parseBatch(mp, batch, 1);
+            if(batch.bytes.capacity() != capacity) {
+                ++growths;
+            }
+        }
+        BOOST_CHECK_EQUAL(batch.size(), 128U);
+        BOOST_CHECK(growths <= 8);
+
+        batch.clear();
+        BOOST_CHECK_EQUAL(batch.size(), 0U);
+    }
+
+    void testNativeGenerator()
+    {
+        std::string data = serializeString(myRecord_);
+        testgen7::RootRecord record;
+        parseString(data, record);
+        BOOST_CHECK(serializeString(record) == data);
+        BOOST_CHECK_EQUAL(avro::encodedSize(record), data.size());
+        BOOST_CHECK_EQUAL(record.nestedrecord.inval2, myRecord_.nestedrecord.inval2);
+
+        typedef avro::schema_traits<testgen7::RootRecord> RootTraits;
+        typedef avro::schema_traits<testgen7::md5> Md5Traits;
+        typedef avro::schema_traits<testgen7::ExampleEnum> EnumTraits;
+        BOOST_STATIC_ASSERT(RootTraits::fieldCount == 12);
+        BOOST_STATIC_ASSERT(!RootTraits::isBounded);
+        BOOST_STATIC_ASSERT(Md5Traits::isFixedSize && Md5Traits::maxEncodedSize == 16);
+        BOOST_STATIC_ASSERT(EnumTraits::isFixedSize && EnumTraits::maxEncodedSize == 1);
+        BOOST_STATIC_ASSERT(avro::schema_traits<testgen7::Nested>::fieldCount == 3);
+    }
+
+    // the setters live in the layouts, not in every object
+    void testContainerSizes()
+    {
+        BOOST_CHECK_EQUAL(sizeof(testgen::Array_of_double), sizeof(testgen::Array_of_double::ArrayType));
+        BOOST_CHECK_EQUAL(sizeof(testgen::Map_of_int), sizeof(testgen::Map_of_int::MapType));
+        BOOST_CHECK_EQUAL(sizeof(testgen::Union_of_bytes_null), sizeof(int64_t) + sizeof(boost::any));
+    }
+
     void testNameIndex()
     {
         const avro::NodePtr &node = schema_.root();
@@ -354,17 +681,47 @@ struct TestCodeGenerator {
         BOOST_CHECK_EQUAL(index, 1U);
     }
 
+    void testCompileInMemory(const std::string &file)
+    {
+        std::ifstream in(file.c_str());
+        std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        avro::ValidSchema streamed;
+        std::istringstream is(json);
+        avro::compileJsonSchema(is, streamed);
+
+        avro::ValidSchema schema;
+        avro::compileJsonSchema(json.data(), json.size(), schema);
+
+        std::ostringstream expected;
+        streamed.toJson(expected);
+        std::ostringstream actual;
+        schema.toJson(actual);
+        BOOST_CHECK_EQUAL(actual.str(), expected.str());
+    }
+
     void test() 
     {
         std::cout << "Running code generation tests\n";
 
         testNameIndex();
+        testContainerSizes();
+        testCompileInMemory(gWriter);
+        testCompileInMemory(gReader);
 
         serializeToScreen();
         serializeToScreenValid();
 
         testParser();
         testParserValid();
+        testParserJson();
+        testMapContainers();
+        testViews();
+        testReuse();
+        testEncodedSize();
+        testUncheckedWriter();
+        testNativeGenerator();
+        testBatch();
 
         std::cout << "Finished code generation tests\n";
     }
@@ -381,6 +738,69 @@ struct TestCodeGenerator {
 
 };
 
+// the registry shares schemas that belong to the test
+struct NoDelete {
+    void operator()(const void *) const {}
+};
+
+// a batch task whose first range throws something other than an exception
+class ThrowingTask : public avro::BatchTask {
+
+  public:
+
+    void run(size_t begin, size_t) const {
+        if(begin == 0) {
+            throw 1;
+        }
+    }
+};
+
+// writes into a buffer of fixed size, so writing allocates nothing
+class FixedStreamer : public avro::OutputStreamer {
+
+  public:
+
+    FixedStreamer() :
+        size_(0)
+    {}
+
+    size_t writeByte(uint8_t byte) {
+        return writeBytes(&byte, 1);
+    }
+
+    size_t writeWord(uint32_t word) {
+        return writeBytes(&word, sizeof(word));
+    }
+
+    size_t writeLongWord(uint64_t word) {
+        return writeBytes(&word, sizeof(word));
+    }
+
+    size_t writeBytes(const void *bytes, size_t size) {
+        BOOST_REQUIRE(size_ + size <= sizeof(data_));
+        memcpy(data_ + size_, bytes, size);
+        size_ += size;
+        return size;
+    }
+
+    const uint8_t *data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    void clear() {
+        size_ = 0;
+    }
+
+  private:
+
+    uint8_t data_[64];
+    size_t size_;
+};
+
 struct TestSchemaResolving {
 
     void checkArray(const testgen::Array_of_double &a1, const testgen2::Array_of_double &a2) 
@@ -485,6 +905,41 @@ struct TestSchemaResolving {
         return ostring.str();
     }
 
+    // the same data through the parse function generated for this writer
+    void testResolvingParse()
+    {
+        std::string data = serializeWriteRecordToString();
+        std::istringstream istring(data);
+        avro::IStreamer is(istring);
+        avro::Reader r(is);
+
+        testgen2::RootRecord record;
+        testgen2::bigrecord::resolvingParse(r, record);
+        checkOk(writeRecord_, record);
+
+        // a writer union with a branch the reader dropped reads its other
+        // branches, and fails only on data in the dropped one
+        std::ostringstream ostring;
+        {
+            avro::OStreamer os(ostring);
+            avro::Writer w(os);
+            w.writeUnion(1);
+            w.writeValue(2.5f);
+            w.writeValue(int32_t(7));
+            w.writeUnion(3);
+            w.writeValue(std::string("dropped"));
+            w.writeValue(int32_t(8));
+        }
+        std::istringstream estring(ostring.str());
+        avro::IStreamer es(estring);
+        avro::Reader er(es);
+        testgen2::extrabranch::resolvingParse(er, record);
+        BOOST_CHECK_EQUAL(record.myunion.choice, 1);
+        BOOST_CHECK_EQUAL(record.myunion.getValue<float>(), 2.5f);
+        BOOST_CHECK_EQUAL(record.anotherint, 7);
+        BOOST_CHECK_THROW(testgen2::extrabranch::resolvingParse(er, record), avro::Exception);
+    }
+
     void parseData(const std::string &data, avro::ResolverSchema &xSchema)
     {
         std::istringstream istring(data);
@@ -509,7 +964,245 @@ struct TestSchemaResolving {
         printRecord(readRecord_);
 
         checkOk(writeRecord_, readRecord_);
+        testResolvingParse();
         std::cout << "Finished schema resolution tests\n";
+
+        testCache();
+        testTranscoder();
+        testBatch();
+        testSingleObject();
+    }
+
+    template<typename T>
+    std::string singleObject(const avro::ValidSchema &schema, const T &record)
+    {
+        std::ostringstream ostring;
+        avro::OStreamer os(ostring);
+        avro::SingleObjectWriter writer(schema, os);
+        writer.write(record);
+        return ostring.str();
+    }
+
+    void testSingleObject()
+    {
+        std::cout << "Running single object tests\n";
+
+        std::string fromWriter = singleObject(writerSchema_, writeRecord_);
+        BOOST_CHECK_EQUAL(fromWriter.compare(10, std::string::npos, serializeWriteRecordToString()), 0);
+
+        testgen2::RootRecord_Layout layout;
+        avro::ResolverCache cache;
+        avro::SchemaRegistry registry;
+        avro::SingleObjectReader reader(readerSchema_, layout, registry, cache);
+
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(fromWriter.data());
+        BOOST_CHECK_EQUAL(avro::SingleObjectReader::fingerprint(data, fromWriter.size()), writerSchema_.fingerprint64());
+        BOOST_CHECK_THROW(reader.read(data, fromWriter.size(), readRecord_), avro::Exception);
+        BOOST_CHECK_THROW(avro::SingleObjectReader::fingerprint(data + 1, fromWriter.size() - 1), avro::Exception);
+
+        registry.add(boost::shared_ptr<const avro::ValidSchema>(&writerSchema_, NoDelete()));
+        registry.add(boost::shared_ptr<const avro::ValidSchema>(&readerSchema_, NoDelete()));
+
+        readRecord_ = testgen2::RootRecord();
+        reader.read(data, fromWriter.size(), readRecord_);
+        checkOk(writeRecord_, readRecord_);
+
+        // messages from either schema, each resolver compiled once
+        std::string fromReader = singleObject(readerSchema_, readRecord_);
+        for(int i = 0; i < 10; ++i) {
+            const std::string &message = (i % 2) ? fromReader : fromWriter;
+            readRecord_ = testgen2::RootRecord();
+            reader.read(reinterpret_cast<const uint8_t *>(message.data()), message.size(), readRecord_);
+            checkOk(writeRecord_, readRecord_);
+        }
+        BOOST_CHECK_EQUAL(cache.misses(), 2U);
+        BOOST_CHECK_EQUAL(cache.hits(), 0U);
+
+        // once the resolver is known, framing a record and reading it back
+        // allocate nothing; the record has no union, whose boost::any would
+        const char json[] = "{\"type\":\"record\",\"name\":\"Pair\",\"fields\":["
+            "{\"name\":\"a\",\"type\":\"long\"},{\"name\":\"b\",\"type\":\"long\"}]}";
+        avro::ValidSchema pair;
+        avro::compileJsonSchema(json, sizeof(json) - 1, pair);
+        avro::CompoundLayout pairLayout;
+        pairLayout.add(new avro::PrimitiveLayout(0));
+        pairLayout.add(new avro::PrimitiveLayout(sizeof(int64_t)));
+        registry.add(boost::shared_ptr<const avro::ValidSchema>(&pair, NoDelete()));
+        avro::SingleObjectReader pairReader(pair, pairLayout, registry, cache);
+
+        FixedStreamer out;
+        avro::SingleObjectWriter pairWriter(pair, out);
+        int64_t values[2] = { 0, 0 };
+        size_t before = 0;
+        int wrong = 0;
+        for(int64_t i = 0; i < 100; ++i) {
+            if(i == 1) {
+                before = gAllocations;
+            }
+            out.clear();
+            pairWriter.writeHeader();
+            pairWriter.writer().writeValue(i);
+            pairWriter.writer().writeValue(-i);
+            pairReader.read(out.data(), out.size(), values);
+            if(values[0] != i || values[1] != -i) {
+                ++wrong;
+            }
+        }
+        BOOST_CHECK_EQUAL(gAllocations - before, 0U);
+        BOOST_CHECK_EQUAL(wrong, 0);
+
+        std::cout << "Finished single object tests\n";
+    }
+
+    void testBatch()
+    {
+        std::cout << "Running batch tests\n";
+        testgen2::RootRecord_Layout layout;
+        avro::ResolverSchema xSchema(writerSchema_, readerSchema_, layout);
+
+        const size_t count = 50;
+        std::ostringstream ostring;
+        {
+            avro::OStreamer os(ostring);
+            avro::Writer s(os);
+            testgen::RootRecord record = writeRecord_;
+            for(size_t i = 0; i < count; ++i) {
+                record.mylong = i;
+                avro::serialize(s, record);
+            }
+        }
+        const std::string data = ostring.str();
+
+        std::vector<testgen2::RootRecord> records;
+        {
+            std::istringstream istring(data);
+            avro::IStreamer is(istring);
+            avro::ResolvingReader r(xSchema, is);
+            r.parseBatch(records, count);
+        }
+        BOOST_CHECK_EQUAL(records.size(), count);
+        for(size_t i = 0; i < records.size(); ++i) {
+            BOOST_CHECK_EQUAL(records[i].mylong, static_cast<int64_t>(i));
+            checkOk(writeRecord_, records[i]);
+        }
+
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.data());
+        std::vector<size_t> offsets;
+        avro::indexRecords(writerSchema_, bytes, data.size(), offsets);
+        BOOST_CHECK_EQUAL(offsets.size(), count);
+
+        std::vector<testgen2::RootRecord> parallel(count);
+        avro::parallelParseBatch(xSchema, bytes, data.size(), offsets, &parallel[0], 4);
+        for(size_t i = 0; i < parallel.size(); ++i) {
+            BOOST_CHECK_EQUAL(parallel[i].mylong, static_cast<int64_t>(i));
+            checkOk(writeRecord_, parallel[i]);
+        }
+
+        // a truncated block fails on the thread that reaches its end
+        BOOST_CHECK_THROW(
+            avro::parallelParseBatch(xSchema, bytes, data.size() - 1, offsets, &parallel[0], 4),
+            avro::Exception);
+
+        // and so does any other thread, whatever it throws
+        BOOST_CHECK_THROW(avro::runBatchTask(ThrowingTask(), count, 4), avro::Exception);
+
+        // a batch that fails to parse appends nothing
+        {
+            avro::MemoryStreamer in(bytes, data.size() - 1);
+            avro::ResolvingReader r(xSchema, in);
+            BOOST_CHECK_THROW(r.parseBatch(records, count), avro::Exception);
+        }
+        BOOST_CHECK_EQUAL(records.size(), count);
+        std::cout << "Finished batch tests\n";
+    }
+
+    void testTranscoder()
+    {
+        std::cout << "Running transcoder tests\n";
+        avro::Transcoder transcoder(writerSchema_, readerSchema_);
+
+        std::istringstream istring(serializeWriteRecordToString());
+        avro::IStreamer is(istring);
+        std::ostringstream ostring;
+        avro::OStreamer os(ostring);
+        transcoder.transcode(is, os);
+
+        // the transcoded data is plain data of the reader's schema
+        std::istringstream transcoded(ostring.str());
+        avro::IStreamer tis(transcoded);
+        avro::Reader r(tis);
+        readRecord_ = testgen2::RootRecord();
+        avro::parse(r, readRecord_);
+
+        checkOk(writeRecord_, readRecord_);
+        std::cout << "Finished transcoder tests\n";
+    }
+
+    void testCache()
+    {
+        std::cout << "Running resolver cache tests\n";
+        testgen2::RootRecord_Layout layout;
+        avro::ResolverCache cache(1);
+
+        avro::ResolverSchema xSchema(writerSchema_, readerSchema_, layout, cache);
+        avro::ResolverSchema ySchema(writerSchema_, readerSchema_, layout, cache);
+        BOOST_CHECK_EQUAL(cache.misses(), 1U);
+        BOOST_CHECK_EQUAL(cache.hits(), 1U);
+        BOOST_CHECK_EQUAL(cache.size(), 1U);
+
+        readRecord_ = testgen2::RootRecord();
+        parseData(serializeWriteRecordToString(), ySchema);
+        checkOk(writeRecord_, readRecord_);
+
+        // a different schema pair evicts the least recently used resolver
+        avro::ResolverSchema zSchema(readerSchema_, readerSchema_, layout, cache);
+        BOOST_CHECK_EQUAL(cache.size(), 1U);
+        avro::ResolverSchema again(writerSchema_, readerSchema_, layout, cache);
+        BOOST_CHECK_EQUAL(cache.misses(), 3U);
+        BOOST_CHECK_EQUAL(cache.hits(), 1U);
+
+        // layouts built by hand are told apart by their contents
+        const char json[] = "{\"type\":\"record\",\"name\":\"Pair\",\"fields\":["
+            "{\"name\":\"a\",\"type\":\"long\"},{\"name\":\"b\",\"type\":\"long\"}]}";
+        avro::ValidSchema pair;
+        avro::compileJsonSchema(json, sizeof(json) - 1, pair);
+        avro::CompoundLayout forward;
+        forward.add(new avro::PrimitiveLayout(0));
+        forward.add(new avro::PrimitiveLayout(sizeof(int64_t)));
+        avro::CompoundLayout backward;
+        backward.add(new avro::PrimitiveLayout(sizeof(int64_t)));
+        backward.add(new avro::PrimitiveLayout(0));
+        avro::ResolverCache handmade;
+        avro::ResolverSchema forwardSchema(pair, pair, forward, handmade);
+        avro::ResolverSchema backwardSchema(pair, pair, backward, handmade);
+        BOOST_CHECK_EQUAL(handmade.misses(), 2U);
+
+        // a layout described once is found again without allocating
+        avro::ResolverCache::LayoutKey backwardKey(backward);
+        avro::ResolverCache::ResolverPtr found = handmade.resolver(pair, pair, backwardKey);
+        size_t before = gAllocations;
+        for(int i = 0; i < 10; ++i) {
+            BOOST_CHECK(handmade.resolver(pair, pair, backwardKey) == found);
+        }
+        BOOST_CHECK_EQUAL(gAllocations - before, 0U);
+        BOOST_CHECK_EQUAL(handmade.misses(), 2U);
+        BOOST_CHECK_EQUAL(handmade.hits(), 11U);
+
+        int64_t values[2] = { 0, 0 };
+        std::ostringstream ostring;
+        {
+            avro::OStreamer os(ostring);
+            avro::Writer writer(os);
+            writer.writeValue(int64_t(1));
+            writer.writeValue(int64_t(2));
+        }
+        std::istringstream istring(ostring.str());
+        avro::IStreamer is(istring);
+        avro::ResolvingReader reader(backwardSchema, is);
+        reader.parse(values);
+        BOOST_CHECK_EQUAL(values[0], 2);
+        BOOST_CHECK_EQUAL(values[1], 1);
+        std::cout << "Finished resolver cache tests\n";
     }
 
     TestSchemaResolving()
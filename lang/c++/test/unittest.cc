@@ -16,10 +16,17 @@
  * limitations under the License.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
+#include <algorithm>
 #include <boost/test/included/unit_test_framework.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 #include "Zigzag.hh"
 #include "Node.hh"
@@ -30,7 +37,19 @@
 #include "Parser.hh"
 #include "SymbolMap.hh"
 #include "Compiler.hh"
+#include "BinarySchema.hh"
+#include "CodeGenerator.hh"
 #include "SchemaResolution.hh"
+#include "GenericValue.hh"
+#include "SchemaRegistry.hh"
+#include "NodeInterner.hh"
+#include "NodeImpl.hh"
+#include "JsonWriter.hh"
+#include "JsonReader.hh"
+#include "ResolvingReader.hh"
+#include "Transcoder.hh"
+#include "InputStreamer.hh"
+#include "Layout.hh"
 
 #include "AvroSerialize.hh"
 
@@ -159,6 +178,29 @@ struct TestSchema
         BOOST_CHECK_EQUAL(found, false);
     }
 
+    // locking the record freezes its names into a hash table, which must
+    // find the same indices the map did
+    void checkWideNameLookup() {
+        const size_t fields = 600;
+        RecordSchema wide("Wide");
+        for(size_t i = 0; i < fields; ++i) {
+            wide.addField(boost::str(boost::format("f%1%") % i), IntSchema());
+        }
+        ValidSchema schema(wide);
+        const NodePtr &node = schema.root();
+        BOOST_CHECK_EQUAL(node->locked(), true);
+
+        size_t index = fields;
+        for(size_t i = 0; i < fields; ++i) {
+            bool found = node->nameIndex(boost::str(boost::format("f%1%") % i), index);
+            BOOST_CHECK_EQUAL(found, true);
+            BOOST_CHECK_EQUAL(index, i);
+        }
+        BOOST_CHECK_EQUAL(node->nameIndex("f600", index), false);
+        BOOST_CHECK_EQUAL(node->nameIndex("", index), false);
+        BOOST_CHECK_EQUAL(node->nameIndex("F1", index), false);
+    }
+
     template<typename Serializer>
     void printUnion(Serializer &s, int path)
     {
@@ -403,6 +445,7 @@ struct TestSchema
         schema_.toFlatList(std::cout);
 
         checkNameLookup();
+        checkWideNameLookup();
 
         printEncoding();
         printValidatingEncoding(0);
@@ -424,11 +467,21 @@ struct TestEncoding {
     void compare(int32_t val) {
         uint32_t encoded = encodeZigzag32(val);
         BOOST_CHECK_EQUAL(decodeZigzag32(encoded), val);
+        boost::array<uint8_t, 5> bytes;
+        BOOST_CHECK_EQUAL(encodedInt32Size(val), encodeInt32(val, bytes));
+        uint8_t raw[5];
+        BOOST_CHECK_EQUAL(encodeInt32(val, raw), encodedInt32Size(val));
+        BOOST_CHECK(std::equal(raw, raw + encodedInt32Size(val), bytes.begin()));
     }
 
     void compare(int64_t val) {
         uint64_t encoded = encodeZigzag64(val);
         BOOST_CHECK_EQUAL(decodeZigzag64(encoded), val);
+        boost::array<uint8_t, 10> bytes;
+        BOOST_CHECK_EQUAL(encodedInt64Size(val), encodeInt64(val, bytes));
+        uint8_t raw[10];
+        BOOST_CHECK_EQUAL(encodeInt64(val, raw), encodedInt64Size(val));
+        BOOST_CHECK(std::equal(raw, raw + encodedInt64Size(val), bytes.begin()));
     }
 
     template<typename IntType>
@@ -451,9 +504,22 @@ struct TestEncoding {
         testEncoding<IntType>(std::numeric_limits<IntType>::max()-1000, std::numeric_limits<IntType>::max());
     }
 
+    // the sizes change where a power of two needs another 7 bits
+    void testSizes()
+    {
+        for(int shift = 0; shift < 63; ++shift) {
+            int64_t val = static_cast<int64_t>(1) << shift;
+            compare(val);
+            compare(val - 1);
+            compare(-val);
+            compare(-val - 1);
+        }
+    }
+
     void test() {
         testEncoding<int32_t>();
         testEncoding<int64_t>();
+        testSizes();
     }
 
 };
@@ -584,12 +650,42 @@ struct TestNested
     }
 
 
+    void testSkipRecurse() {
+        std::ostringstream ostring;
+        OStreamer os(ostring);
+        {
+            Serializer<ValidatingWriter> s(schema_, os);
+            s.writeRecord();
+            s.writeLong(1);
+            s.writeUnion(1);
+            {
+                s.writeRecord();
+                s.writeLong(2);
+                s.writeUnion(0);
+                s.writeNull();
+                s.writeBool(false);
+            }
+            s.writeBool(true);
+        }
+        std::cout << "SkipRecurse\n";
+
+        std::istringstream istring(ostring.str());
+        IStreamer is(istring);
+        Parser<ValidatingReader> p(schema_, is);
+        p.readRecord();
+        BOOST_CHECK_EQUAL(p.readLong(), 1);
+        // the union holds the rest of the list
+        p.skip();
+        BOOST_CHECK_EQUAL(p.readBool(), true);
+    }
+
     void test() {
         createSchema();
         testToScreen();
 
         testParseNoRecurse();
         testParseRecurse();
+        testSkipRecurse();
 
     }
 
@@ -615,6 +711,56 @@ struct TestGenerated
         serialize(writer, Null());
         serialize(writer, f);
         
+        testCodeGenerator();
+    }
+
+    static std::string generate(const std::string &json)
+    {
+        ValidSchema schema;
+        compileJsonSchema(json.data(), json.size(), schema);
+        std::ostringstream os;
+        generateCppCode(schema, "gen", os);
+        return os.str();
+    }
+
+    static bool contains(const std::string &code, const std::string &text)
+    {
+        return code.find(text) != std::string::npos;
+    }
+
+    void testCodeGenerator()
+    {
+        // 8 + 1 + 4 + 1 bytes, whatever the values
+        std::string code = generate(
+            "{\"type\":\"record\",\"name\":\"Point\",\"fields\":["
+            "{\"name\":\"x\",\"type\":\"double\"},"
+            "{\"name\":\"valid\",\"type\":\"boolean\"},"
+            "{\"name\":\"id\",\"type\":{\"type\":\"fixed\",\"name\":\"Id\",\"size\":4}},"
+            "{\"name\":\"kind\",\"type\":{\"type\":\"enum\",\"name\":\"Kind\",\"symbols\":[\"A\",\"B\"]}}]}");
+        BOOST_CHECK(contains(code, "struct Point {"));
+        BOOST_CHECK(contains(code, "template <> struct schema_traits<gen::Point> {\n"
+            "    enum {\n"
+            "        fieldCount = 4,\n"
+            "        isFixedSize = 1,\n"
+            "        isBounded = 1,\n"
+            "        maxEncodedSize = 14\n"));
+        BOOST_CHECK(contains(code, "inline size_t encodedSize(const Point &, const boost::true_type &) {\n"
+            "    return 14;\n"));
+
+        // varints are bounded but not fixed
+        code = generate("{\"type\":\"record\",\"name\":\"Pair\",\"fields\":["
+            "{\"name\":\"a\",\"type\":\"int\"},{\"name\":\"b\",\"type\":[\"null\",\"long\"]}]}");
+        BOOST_CHECK(contains(code, "isFixedSize = 0,\n        isBounded = 1,\n        maxEncodedSize = 16\n"));
+
+        // a recursive record is forward declared and unbounded
+        code = generate("{\"type\":\"record\",\"name\":\"List\",\"fields\":["
+            "{\"name\":\"value\",\"type\":\"long\"},{\"name\":\"next\",\"type\":[\"null\",\"List\"]}]}");
+        BOOST_CHECK(contains(code, "struct List;"));
+        BOOST_CHECK(contains(code, "template <> struct schema_traits<gen::List> {\n"
+            "    enum {\n"
+            "        fieldCount = 2,\n"
+            "        isFixedSize = 0,\n"
+            "        isBounded = 0,\n"));
     }
 };
 
@@ -646,14 +792,403 @@ struct TestBadStuff
         std::cout << "(intentional) error: " << error << '\n';
     }
 
+    void testBadSchemaInMemory()
+    {
+        const char *bad[] = {
+            "{ \"type\" : \"wrong\" }",
+            "{ \"type\" : \"record\", \"name\" : \"R\", \"fields\" : [ { \"name\" : \"f\" } ] }",
+            "{ \"type\" : \"array\", \"items\" : \"int\" } }",
+            "{ \"type\" : \"fixed\", \"name\" : \"F\", \"size\" : ",
+            "{ \"name\" : \"nothing\" }"
+        };
+
+        for(size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+            avro::ValidSchema schema;
+            std::string error;
+            bool result = avro::compileJsonSchema(bad[i], strlen(bad[i]), schema, error);
+            BOOST_CHECK_EQUAL(result, false);
+            BOOST_CHECK(!error.empty());
+        }
+    }
+
     void test() 
     {
         std::cout << "TestBadStuff\n";
         testBadFile();
         testBadSchema();
+        testBadSchemaInMemory();
     }
 };
 
+struct TestCompiler
+{
+    // attributes are in no particular order and include metadata the
+    // compiler does not use
+    static const char *json()
+    {
+        return
+            "{ \"fields\" : [\n"
+            "    { \"type\" : \"long\", \"name\" : \"id\", \"doc\" : \"an \\\"id\\\"\" },\n"
+            "    { \"name\" : \"kind\", \"default\" : \"small\",\n"
+            "      \"type\" : { \"symbols\" : [ \"small\", \"large\" ], \"type\" : \"enum\", \"name\" : \"Kind\" } },\n"
+            "    { \"name\" : \"tags\", \"type\" : { \"type\" : \"map\", \"values\" : { \"type\" : \"array\", \"items\" : \"string\" } } },\n"
+            "    { \"name\" : \"digest\", \"type\" : [ \"null\", { \"size\" : 16, \"type\" : \"fixed\", \"name\" : \"Digest\" } ],\n"
+            "      \"default\" : null, \"order\" : \"ignore\", \"aliases\" : [ \"hash\", { \"x\" : [ 1.5e3, true ] } ] },\n"
+            "    { \"name\" : \"next\", \"type\" : { \"type\" : [ \"null\", \"Generic\" ] } }\n"
+            "  ],\n"
+            "  \"namespace\" : \"org.example\", \"name\" : \"Generic\", \"type\" : \"record\" }";
+    }
+
+    void compile()
+    {
+        for(int i = 0; i < 200; ++i) {
+            avro::ValidSchema schema;
+            avro::compileJsonSchema(json(), strlen(json()), schema);
+        }
+    }
+
+    static std::string hex(const Sha256Digest &digest)
+    {
+        std::ostringstream os;
+        for(size_t i = 0; i < digest.size(); ++i) {
+            os << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(digest[i]);
+        }
+        return os.str();
+    }
+
+    void testCanonicalForm(const ValidSchema &schema)
+    {
+        BOOST_CHECK_EQUAL(schema.canonicalForm(),
+            "{\"name\":\"Generic\",\"type\":\"record\",\"fields\":["
+            "{\"name\":\"id\",\"type\":\"long\"},"
+            "{\"name\":\"kind\",\"type\":{\"name\":\"Kind\",\"type\":\"enum\",\"symbols\":[\"small\",\"large\"]}},"
+            "{\"name\":\"tags\",\"type\":{\"type\":\"map\",\"values\":{\"type\":\"array\",\"items\":\"string\"}}},"
+            "{\"name\":\"digest\",\"type\":[\"null\",{\"name\":\"Digest\",\"type\":\"fixed\",\"size\":16}]},"
+            "{\"name\":\"next\",\"type\":[\"null\",\"Generic\"]}]}");
+        BOOST_CHECK_EQUAL(schema.fingerprint64(), 0x7f56c772156f31c2ULL);
+        BOOST_CHECK_EQUAL(hex(schema.fingerprintSha256()),
+            "a1a8040130072ffb9e59292330d93d95a8a59d2e34429b13ced4029896dc64ee");
+
+        // the example in the specification
+        IntSchema intSchema;
+        ValidSchema primitive(intSchema);
+        BOOST_CHECK_EQUAL(primitive.canonicalForm(), "\"int\"");
+        BOOST_CHECK_EQUAL(primitive.fingerprint64(), 8247732601305521295ULL);
+        BOOST_CHECK_EQUAL(hex(primitive.fingerprintSha256()),
+            "3f2b87a9fe7cc9b13835598c3981cd45e3e355309e5090aa0933d7becb6fba45");
+
+        BOOST_CHECK_EQUAL(crc64Avro("", 0), CRC64_AVRO_EMPTY);
+        BOOST_CHECK_EQUAL(hex(sha256("", 0)),
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    }
+
+    void testBinarySchema(const ValidSchema &schema)
+    {
+        std::vector<uint8_t> binary;
+        writeBinarySchema(schema, binary);
+
+        ValidSchema loaded;
+        readBinarySchema(&binary[0], binary.size(), loaded);
+        BOOST_CHECK_EQUAL(loaded.canonicalForm(), schema.canonicalForm());
+        std::ostringstream expected, actual;
+        schema.toJson(expected);
+        loaded.toJson(actual);
+        BOOST_CHECK_EQUAL(actual.str(), expected.str());
+
+        // the recursive link is resolved again
+        const NodePtr &link = loaded.root()->leafAt(4)->leafAt(1);
+        BOOST_CHECK_EQUAL(static_cast<const NodeSymbolic &>(*link).getNode(), loaded.root());
+
+        std::string bytes(binary.begin(), binary.end());
+        std::istringstream is(bytes);
+        ValidSchema streamed;
+        readBinarySchema(is, streamed);
+        BOOST_CHECK_EQUAL(streamed.fingerprint64(), schema.fingerprint64());
+
+        std::vector<uint8_t> bad(binary);
+        bad[bad.size() / 2] ^= 0x20;
+        BOOST_CHECK_THROW(readBinarySchema(&bad[0], bad.size(), loaded), Exception);
+
+        bad = binary;
+        bad[4] = BINARY_SCHEMA_VERSION + 1;
+        BOOST_CHECK_THROW(readBinarySchema(&bad[0], bad.size(), loaded), Exception);
+
+        BOOST_CHECK_THROW(readBinarySchema(&binary[0], binary.size() - 1, loaded), Exception);
+        BOOST_CHECK_THROW(readBinarySchema(reinterpret_cast<const uint8_t *>(json()), strlen(json()), loaded), Exception);
+
+        // a schema nested too deep is refused before it can exhaust the stack
+        std::vector<uint8_t> nested = nestedArrays(200);
+        readBinarySchema(&nested[0], nested.size(), loaded);
+        BOOST_CHECK_EQUAL(loaded.root()->type(), AVRO_ARRAY);
+        nested = nestedArrays(100000);
+        BOOST_CHECK_THROW(readBinarySchema(&nested[0], nested.size(), loaded), Exception);
+    }
+
+    // a binary schema of arrays of arrays of ints, with a good checksum
+    static std::vector<uint8_t> nestedArrays(size_t depth)
+    {
+        const uint8_t header[] = { 'A', 'V', 'S', 'B', BINARY_SCHEMA_VERSION };
+        std::vector<uint8_t> binary(header, header + sizeof(header));
+        binary.insert(binary.end(), depth, static_cast<uint8_t>(AVRO_ARRAY));
+        binary.push_back(static_cast<uint8_t>(AVRO_INT));
+        uint64_t checksum = crc64Avro(&binary[0], binary.size());
+        for(int i = 0; i < 8; ++i) {
+            binary.push_back(static_cast<uint8_t>(checksum >> (8 * i)));
+        }
+        return binary;
+    }
+
+    // a JSON schema of arrays of arrays of ints
+    static std::string jsonNestedArrays(size_t depth)
+    {
+        std::string json;
+        for(size_t i = 0; i < depth; ++i) {
+            json += "{\"type\":\"array\",\"items\":";
+        }
+        json += "\"int\"";
+        json.append(depth, '}');
+        return json;
+    }
+
+    void testDepth()
+    {
+        ValidSchema schema;
+        std::string nested = jsonNestedArrays(200);
+        compileJsonSchema(nested.data(), nested.size(), schema);
+        BOOST_CHECK_EQUAL(schema.root()->type(), AVRO_ARRAY);
+        nested = jsonNestedArrays(100000);
+        BOOST_CHECK_THROW(compileJsonSchema(nested.data(), nested.size(), schema), Exception);
+
+        // metadata that is skipped is held to the same limit
+        std::string doc = "{\"type\":\"int\",\"doc\":";
+        doc.append(100000, '[');
+        doc.append(100000, ']');
+        doc += "}";
+        BOOST_CHECK_THROW(compileJsonSchema(doc.data(), doc.size(), schema), Exception);
+    }
+
+    void test()
+    {
+        std::cout << "TestCompiler\n";
+
+        avro::ValidSchema schema;
+        avro::compileJsonSchema(json(), strlen(json()), schema);
+
+        const NodePtr &root = schema.root();
+        BOOST_CHECK_EQUAL(root->type(), AVRO_RECORD);
+        BOOST_CHECK_EQUAL(root->name(), "Generic");
+        BOOST_CHECK_EQUAL(root->leaves(), 5U);
+        BOOST_CHECK_EQUAL(root->nameAt(4), "next");
+        BOOST_CHECK_EQUAL(root->leafAt(0)->type(), AVRO_LONG);
+        BOOST_CHECK_EQUAL(root->leafAt(1)->type(), AVRO_ENUM);
+        BOOST_CHECK_EQUAL(root->leafAt(1)->nameAt(1), "large");
+        BOOST_CHECK_EQUAL(root->leafAt(2)->leafAt(1)->type(), AVRO_ARRAY);
+        BOOST_CHECK_EQUAL(root->leafAt(3)->leafAt(1)->fixedSize(), 16);
+        BOOST_CHECK_EQUAL(root->leafAt(4)->leafAt(1)->type(), AVRO_SYMBOLIC);
+
+        testCanonicalForm(schema);
+        testBinarySchema(schema);
+        testDepth();
+
+        // compiling from several threads at once
+        boost::thread_group threads;
+        for(int i = 0; i < 4; ++i) {
+            threads.create_thread(boost::bind(&TestCompiler::compile, this));
+        }
+        threads.join_all();
+    }
+};
+
+struct TestRegistry
+{
+    static std::string recordSchema(int i)
+    {
+        std::ostringstream os;
+        os << "{\"type\":\"record\",\"name\":\"R" << i << "\",\"fields\":[{\"name\":\"f\",\"type\":\"long\"}]}";
+        return os.str();
+    }
+
+    void read()
+    {
+        // every schema published before a lookup starts must be found
+        while(!__atomic_load_n(&done_, __ATOMIC_ACQUIRE)) {
+            size_t known = __atomic_load_n(&published_, __ATOMIC_ACQUIRE);
+            for(size_t i = 0; i < known; ++i) {
+                const ValidSchema *schema = registry_.find(fingerprints_[i]);
+                if(!schema || schema->fingerprint64() != fingerprints_[i]) {
+                    __atomic_add_fetch(&failures_, 1, __ATOMIC_RELAXED);
+                }
+            }
+        }
+    }
+
+    void testConcurrent()
+    {
+        // the fingerprints are all known before the readers start, and only
+        // the count of those registered changes while they run
+        std::vector<std::string> schemas;
+        for(size_t i = 0; i < count; ++i) {
+            schemas.push_back(recordSchema(i));
+            ValidSchema schema;
+            compileJsonSchema(schemas[i].data(), schemas[i].size(), schema);
+            fingerprints_[i] = schema.fingerprint64();
+        }
+        published_ = 0;
+        done_ = false;
+        failures_ = 0;
+
+        boost::thread_group readers;
+        for(int i = 0; i < 4; ++i) {
+            readers.create_thread(boost::bind(&TestRegistry::read, this));
+        }
+        for(size_t i = 0; i < count; ++i) {
+            const ValidSchema &schema = registry_.add(schemas[i].data(), schemas[i].size());
+            BOOST_CHECK_EQUAL(schema.fingerprint64(), fingerprints_[i]);
+            __atomic_store_n(&published_, i + 1, __ATOMIC_RELEASE);
+        }
+        __atomic_store_n(&done_, true, __ATOMIC_RELEASE);
+        readers.join_all();
+
+        BOOST_CHECK_EQUAL(failures_, 0);
+        BOOST_CHECK_EQUAL(registry_.size(), count);
+
+        // the same schema written differently is the one already registered
+        std::string spaced = "{ \"name\" : \"R7\", \"type\" : \"record\", \"fields\" : [ { \"type\" : \"long\", \"name\" : \"f\" } ] }";
+        const ValidSchema &same = registry_.add(spaced.data(), spaced.size());
+        BOOST_CHECK_EQUAL(&same, registry_.find(fingerprints_[7]));
+        BOOST_CHECK_EQUAL(registry_.size(), count);
+
+        IntSchema intSchema;
+        ValidSchema unknown(intSchema);
+        BOOST_CHECK(registry_.find(unknown.fingerprint64()) == 0);
+    }
+
+    void testDirectory()
+    {
+        char path[] = "/tmp/avroregistryXXXXXX";
+        BOOST_REQUIRE(mkdtemp(path));
+        std::string dir(path);
+
+        const char *files[] = { "a.avsc", "b.avsc", "notes.txt" };
+        for(int i = 0; i < 3; ++i) {
+            std::ofstream out((dir + '/' + files[i]).c_str());
+            out << recordSchema(2000 + i);
+        }
+
+        SchemaRegistry registry;
+        BOOST_CHECK_EQUAL(registry.addDirectory(dir), 2U);
+        BOOST_CHECK_EQUAL(registry.size(), 2U);
+        BOOST_CHECK_THROW(registry.addDirectory(dir + "/missing"), Exception);
+
+        for(int i = 0; i < 3; ++i) {
+            remove((dir + '/' + files[i]).c_str());
+        }
+        rmdir(path);
+    }
+
+    void test()
+    {
+        std::cout << "TestRegistry\n";
+        testConcurrent();
+        testDirectory();
+    }
+
+    static const size_t count = 1000;
+
+    SchemaRegistry registry_;
+    uint64_t fingerprints_[count];
+    size_t published_;
+    bool done_;
+    int failures_;
+};
+
+const size_t TestRegistry::count;
+
+struct TestInterner
+{
+    static std::string header(const char *idType)
+    {
+        return std::string("{\"type\":\"record\",\"name\":\"Header\",\"fields\":[{\"name\":\"id\",\"type\":\"") + idType +
+            "\"},{\"name\":\"kind\",\"type\":{\"type\":\"enum\",\"name\":\"Kind\",\"symbols\":[\"A\",\"B\"]}}]}";
+    }
+
+    // Wrap refers to Kind, which is defined outside it
+    static std::string wrapped(const char *name)
+    {
+        return std::string("{\"type\":\"record\",\"name\":\"") + name + "\",\"fields\":["
+            "{\"name\":\"kind\",\"type\":{\"type\":\"enum\",\"name\":\"Kind\",\"symbols\":[\"A\",\"B\"]}},"
+            "{\"name\":\"wrap\",\"type\":{\"type\":\"record\",\"name\":\"Wrap\",\"fields\":[{\"name\":\"k\",\"type\":\"Kind\"}]}}]}";
+    }
+
+    void compile(const std::string &json, ValidSchema &schema)
+    {
+        compileJsonSchema(json.data(), json.size(), schema);
+        std::ostringstream before;
+        schema.toJson(before);
+        uint64_t fingerprint = schema.fingerprint64();
+
+        schema.intern(interner_);
+
+        std::ostringstream after;
+        schema.toJson(after);
+        BOOST_CHECK_EQUAL(before.str(), after.str());
+        BOOST_CHECK_EQUAL(schema.fingerprint64(), fingerprint);
+        BOOST_CHECK(schema.validationTable());
+    }
+
+    static NodePtr target(const NodePtr &node)
+    {
+        BOOST_REQUIRE_EQUAL(node->type(), AVRO_SYMBOLIC);
+        return static_cast<const NodeSymbolic &>(*node).getNode();
+    }
+
+    void test()
+    {
+        std::cout << "TestInterner\n";
+
+        std::string a = "{\"type\":\"record\",\"name\":\"A\",\"fields\":[{\"name\":\"header\",\"type\":" + header("long") +
+            "},{\"name\":\"kind\",\"type\":\"Kind\"},{\"name\":\"x\",\"type\":\"int\"}]}";
+        std::string b = "{\"type\":\"record\",\"name\":\"B\",\"fields\":[{\"name\":\"header\",\"type\":" + header("long") +
+            "},{\"name\":\"y\",\"type\":\"string\"}]}";
+        std::string c = "{\"type\":\"record\",\"name\":\"C\",\"fields\":[{\"name\":\"header\",\"type\":" + header("int") + "}]}";
+
+        ValidSchema schemaA, schemaB, schemaC, schemaD, schemaE, schemaA2;
+        compile(a, schemaA);
+        compile(b, schemaB);
+        compile(c, schemaC);
+        compile(wrapped("D"), schemaD);
+        compile(wrapped("E"), schemaE);
+        compile(a, schemaA2);
+
+        const NodePtr &headerA = schemaA.root()->leafAt(0);
+        const NodePtr &kind = headerA->leafAt(1);
+        BOOST_CHECK_EQUAL(headerA, schemaB.root()->leafAt(0));
+        BOOST_CHECK(headerA != schemaC.root()->leafAt(0));
+        BOOST_CHECK_EQUAL(kind, schemaC.root()->leafAt(0)->leafAt(1));
+        BOOST_CHECK_EQUAL(schemaA2.root(), schemaA.root());
+
+        // the link to Kind follows it to the shared definition
+        BOOST_CHECK_EQUAL(target(schemaA.root()->leafAt(1)), kind);
+
+        // Wrap is not self-contained, so only the Kind it refers to is shared
+        const NodePtr &wrapD = schemaD.root()->leafAt(1);
+        const NodePtr &wrapE = schemaE.root()->leafAt(1);
+        BOOST_CHECK(wrapD != wrapE);
+        BOOST_CHECK_EQUAL(schemaD.root()->leafAt(0), kind);
+        BOOST_CHECK_EQUAL(schemaE.root()->leafAt(0), kind);
+        BOOST_CHECK_EQUAL(target(wrapE->leafAt(0)), kind);
+
+        // Kind, both Headers, A, B, C, D and E
+        BOOST_CHECK_EQUAL(interner_.size(), 8U);
+
+        SchemaRegistry registry(&interner_);
+        const ValidSchema &registered = registry.add(b.data(), b.size());
+        BOOST_CHECK_EQUAL(registered.root(), schemaB.root());
+    }
+
+    NodeInterner interner_;
+};
+
 struct TestResolution
 {
     TestResolution() :
@@ -748,6 +1283,53 @@ struct TestResolution
         BOOST_CHECK_EQUAL(resolve(unionOne_, double_), RESOLVE_PROMOTABLE_TO_DOUBLE);
         BOOST_CHECK_EQUAL(resolve(unionTwo_, float_), RESOLVE_PROMOTABLE_TO_FLOAT);
         BOOST_CHECK_EQUAL(resolve(unionOne_, unionTwo_), RESOLVE_MATCH);
+
+        testEnumMapping();
+    }
+
+    void testEnumMapping()
+    {
+        ValidSchema writer;
+        {
+            EnumSchema symbols("Symbols");
+            symbols.addSymbol("zero");
+            symbols.addSymbol("one");
+            symbols.addSymbol("two");
+            writer.setSchema(symbols);
+        }
+        ValidSchema reader;
+        {
+            EnumSchema symbols("Symbols");
+            symbols.addSymbol("two");
+            symbols.addSymbol("zero");
+            reader.setSchema(symbols);
+        }
+
+        std::ostringstream ostring;
+        OStreamer os(ostring);
+        Writer w(os);
+        w.writeEnum(2);
+        w.writeEnum(0);
+        w.writeEnum(1);
+        w.writeEnum(3);
+
+        CompoundLayout layout;
+        layout.add(new PrimitiveLayout(0));
+        ResolverSchema schema(writer, reader, layout);
+
+        std::istringstream istring(ostring.str());
+        IStreamer is(istring);
+        ResolvingReader r(schema, is);
+
+        int value = -1;
+        r.parse(value);
+        BOOST_CHECK_EQUAL(value, 0);
+        r.parse(value);
+        BOOST_CHECK_EQUAL(value, 1);
+
+        // a symbol the reader does not have, then one the writer does not
+        BOOST_CHECK_THROW(r.parse(value), Exception);
+        BOOST_CHECK_THROW(r.parse(value), Exception);
     }
 
   private:
@@ -772,6 +1354,549 @@ struct TestResolution
 };
 
 
+struct TestTranscoder
+{
+    static void compile(const std::string &json, ValidSchema &schema)
+    {
+        compileJsonSchema(json.data(), json.size(), schema);
+    }
+
+    static std::string transcode(const Transcoder &transcoder, const std::string &data, size_t count = 1)
+    {
+        MemoryStreamer in(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+        std::ostringstream ostring;
+        OStreamer out(ostring);
+        for(size_t i = 0; i < count; ++i) {
+            transcoder.transcode(in, out);
+        }
+        return ostring.str();
+    }
+
+    void testEnums()
+    {
+        ValidSchema writer;
+        compile("{\"type\":\"enum\",\"name\":\"E\",\"symbols\":[\"zero\",\"one\",\"two\"]}", writer);
+        ValidSchema reader;
+        compile("{\"type\":\"enum\",\"name\":\"E\",\"symbols\":[\"two\",\"zero\"]}", reader);
+        Transcoder transcoder(writer, reader);
+
+        std::ostringstream ostring;
+        {
+            OStreamer os(ostring);
+            Writer w(os);
+            w.writeEnum(2);
+            w.writeEnum(0);
+            w.writeEnum(1);
+        }
+        std::string data = ostring.str();
+
+        std::istringstream istring(transcode(transcoder, data, 2));
+        IStreamer is(istring);
+        Reader r(is);
+        BOOST_CHECK_EQUAL(r.readEnum(), 0);
+        BOOST_CHECK_EQUAL(r.readEnum(), 1);
+
+        // a symbol the reader does not have
+        BOOST_CHECK_THROW(transcode(transcoder, data.substr(2)), Exception);
+
+        // which can still be skipped
+        std::string skipped = data.substr(2) + data.substr(0, 1);
+        MemoryStreamer in(reinterpret_cast<const uint8_t *>(skipped.data()), skipped.size());
+        transcoder.skip(in);
+        std::ostringstream after;
+        OStreamer out(after);
+        transcoder.transcode(in, out);
+        BOOST_CHECK_EQUAL(after.str(), std::string(1, '\0'));
+    }
+
+    void testUnions()
+    {
+        ValidSchema writer;
+        compile("[\"int\",\"string\",\"null\"]", writer);
+        ValidSchema reader;
+        compile("[\"null\",\"string\",\"long\"]", reader);
+        Transcoder transcoder(writer, reader);
+
+        std::ostringstream ostring;
+        {
+            OStreamer os(ostring);
+            Writer w(os);
+            w.writeUnion(0);
+            w.writeValue(int32_t(-5));
+            w.writeUnion(1);
+            w.writeValue(std::string("text"));
+            w.writeUnion(2);
+        }
+
+        std::istringstream istring(transcode(transcoder, ostring.str(), 3));
+        IStreamer is(istring);
+        Reader r(is);
+        int64_t number = 0;
+        std::string text;
+        BOOST_CHECK_EQUAL(r.readUnion(), 2);
+        r.readValue(number);
+        BOOST_CHECK_EQUAL(number, -5);
+        BOOST_CHECK_EQUAL(r.readUnion(), 1);
+        r.readValue(text);
+        BOOST_CHECK_EQUAL(text, "text");
+        BOOST_CHECK_EQUAL(r.readUnion(), 0);
+    }
+
+    void testPromotions()
+    {
+        ValidSchema writer;
+        compile("{\"type\":\"record\",\"name\":\"R\",\"fields\":["
+            "{\"name\":\"a\",\"type\":\"int\"},{\"name\":\"b\",\"type\":\"int\"},"
+            "{\"name\":\"c\",\"type\":\"int\"},{\"name\":\"d\",\"type\":\"long\"},"
+            "{\"name\":\"e\",\"type\":\"long\"},{\"name\":\"f\",\"type\":\"float\"}]}", writer);
+        ValidSchema reader;
+        compile("{\"type\":\"record\",\"name\":\"R\",\"fields\":["
+            "{\"name\":\"a\",\"type\":\"long\"},{\"name\":\"b\",\"type\":\"float\"},"
+            "{\"name\":\"c\",\"type\":\"double\"},{\"name\":\"d\",\"type\":\"float\"},"
+            "{\"name\":\"e\",\"type\":\"double\"},{\"name\":\"f\",\"type\":\"double\"}]}", reader);
+        Transcoder transcoder(writer, reader);
+
+        std::ostringstream ostring;
+        {
+            OStreamer os(ostring);
+            Writer w(os);
+            w.writeValue(int32_t(-70000));
+            w.writeValue(int32_t(3));
+            w.writeValue(int32_t(-4));
+            w.writeValue(int64_t(5000000000LL));
+            w.writeValue(int64_t(-6));
+            w.writeValue(0.5f);
+        }
+
+        std::istringstream istring(transcode(transcoder, ostring.str()));
+        IStreamer is(istring);
+        Reader r(is);
+        int64_t l = 0;
+        float f = 0;
+        double d = 0;
+        r.readValue(l);
+        BOOST_CHECK_EQUAL(l, -70000);
+        r.readValue(f);
+        BOOST_CHECK_EQUAL(f, 3.0f);
+        r.readValue(d);
+        BOOST_CHECK_EQUAL(d, -4.0);
+        r.readValue(f);
+        BOOST_CHECK_EQUAL(f, 5000000000.0f);
+        r.readValue(d);
+        BOOST_CHECK_EQUAL(d, -6.0);
+        r.readValue(d);
+        BOOST_CHECK_EQUAL(d, 0.5);
+    }
+
+    void testSkippedFields()
+    {
+        // x and y swap places, and the writer's skipped record is dropped
+        ValidSchema writer;
+        compile("{\"type\":\"record\",\"name\":\"R\",\"fields\":["
+            "{\"name\":\"x\",\"type\":\"string\"},"
+            "{\"name\":\"skipped\",\"type\":{\"type\":\"record\",\"name\":\"S\",\"fields\":["
+                "{\"name\":\"values\",\"type\":{\"type\":\"array\",\"items\":\"long\"}},"
+                "{\"name\":\"flag\",\"type\":\"boolean\"}]}},"
+            "{\"name\":\"y\",\"type\":\"long\"}]}", writer);
+        ValidSchema reader;
+        compile("{\"type\":\"record\",\"name\":\"R\",\"fields\":["
+            "{\"name\":\"y\",\"type\":\"long\"},{\"name\":\"x\",\"type\":\"string\"}]}", reader);
+        Transcoder transcoder(writer, reader);
+
+        std::ostringstream ostring;
+        {
+            OStreamer os(ostring);
+            Writer w(os);
+            for(int i = 0; i < 3; ++i) {
+                w.writeValue(std::string(i + 1, 'x'));
+                w.writeArrayBlock(2);
+                w.writeValue(int64_t(100));
+                w.writeValue(int64_t(200));
+                w.writeArrayEnd();
+                w.writeValue(true);
+                w.writeValue(int64_t(i));
+            }
+        }
+
+        std::istringstream istring(transcode(transcoder, ostring.str(), 3));
+        IStreamer is(istring);
+        Reader r(is);
+        for(int i = 0; i < 3; ++i) {
+            int64_t y = -1;
+            std::string x;
+            r.readValue(y);
+            r.readValue(x);
+            BOOST_CHECK_EQUAL(y, i);
+            BOOST_CHECK_EQUAL(x, std::string(i + 1, 'x'));
+        }
+    }
+
+    void testBadVarInt()
+    {
+        ValidSchema schema;
+        compile("\"long\"", schema);
+        Transcoder transcoder(schema, schema);
+        std::string data(11, '\xff');
+        BOOST_CHECK_THROW(transcode(transcoder, data), Exception);
+    }
+
+    void test()
+    {
+        std::cout << "TestTranscoder\n";
+        testEnums();
+        testUnions();
+        testPromotions();
+        testSkippedFields();
+        testBadVarInt();
+    }
+};
+
+
+struct TestGeneric
+{
+    TestGeneric()
+    {
+        RecordSchema rec("Generic");
+        rec.addField("name", StringSchema());
+        rec.addField("id", LongSchema());
+        rec.addField("ratio", DoubleSchema());
+        rec.addField("tags", ArraySchema(StringSchema()));
+        rec.addField("counts", MapSchema(IntSchema()));
+        EnumSchema kind("Kind");
+        kind.addSymbol("small");
+        kind.addSymbol("large");
+        rec.addField("kind", kind);
+        rec.addField("digest", FixedSchema(16, "Digest"));
+        UnionSchema next;
+        next.addType(NullSchema());
+        next.addType(IntSchema());
+        rec.addField("next", next);
+        rec.addField("flag", BoolSchema());
+        schema_.setSchema(rec);
+    }
+
+    void serialize(OutputStreamer &os)
+    {
+        Serializer<ValidatingWriter> s(schema_, os);
+        s.writeRecord();
+        s.writeString("generic");
+        s.writeLong(-1234567890123LL);
+        s.writeDouble(0.25);
+        s.writeArrayBlock(2);
+        s.writeString("one");
+        s.writeString("two");
+        s.writeArrayBlock(20);
+        for(int i = 0; i < 20; ++i) {
+            s.writeString("many");
+        }
+        s.writeArrayEnd();
+        s.writeMapBlock(1);
+        s.writeString("hits");
+        s.writeInt(42);
+        s.writeMapEnd();
+        s.writeEnum(1);
+        s.writeFixed(fixeddata);
+        s.writeUnion(1);
+        s.writeInt(7);
+        s.writeBool(true);
+    }
+
+    void check(const GenericValue &value)
+    {
+        BOOST_CHECK_EQUAL(value.type(), AVRO_RECORD);
+        BOOST_CHECK_EQUAL(value.size(), 9U);
+        BOOST_CHECK_EQUAL(value.field("name").stringValue(), "generic");
+        BOOST_CHECK_EQUAL(value.at(1).longValue(), -1234567890123LL);
+        BOOST_CHECK_EQUAL(value.field("ratio").doubleValue(), 0.25);
+
+        const GenericValue &tags = value.field("tags");
+        BOOST_CHECK_EQUAL(tags.size(), 22U);
+        BOOST_CHECK_EQUAL(tags.at(1).stringValue(), "two");
+        BOOST_CHECK_EQUAL(tags.at(21).stringValue(), "many");
+
+        const GenericValue &counts = value.field("counts");
+        BOOST_CHECK_EQUAL(counts.size(), 1U);
+        BOOST_CHECK_EQUAL(counts.keyAt(0).stringValue(), "hits");
+        BOOST_CHECK_EQUAL(counts.valueAt(0).intValue(), 42);
+        BOOST_CHECK_THROW(counts.keyAt(1), Exception);
+        BOOST_CHECK_THROW(counts.valueAt(1), Exception);
+
+        BOOST_CHECK_EQUAL(value.field("kind").symbolName(), "large");
+
+        const GenericValue &digest = value.field("digest");
+        BOOST_CHECK_EQUAL(digest.size(), sizeof(fixeddata));
+        BOOST_CHECK(std::equal(fixeddata, fixeddata + sizeof(fixeddata), digest.data()));
+
+        BOOST_CHECK_EQUAL(value.field("next").branch(), 1U);
+        BOOST_CHECK_EQUAL(value.field("next").branchValue().intValue(), 7);
+        BOOST_CHECK_EQUAL(value.field("flag").boolValue(), true);
+
+        BOOST_CHECK_THROW(value.field("missing"), Exception);
+        BOOST_CHECK_THROW(value.field("id").intValue(), Exception);
+    }
+
+    void testSkip(const std::string &encoded)
+    {
+        std::istringstream istring(encoded);
+        IStreamer is(istring);
+        Parser<ValidatingReader> p(schema_, is);
+
+        p.readRecord();
+        p.skip();
+        p.skip();
+        BOOST_CHECK_EQUAL(p.readDouble(), 0.25);
+        p.skip();
+        p.skip();
+        p.skip();
+        p.skip();
+        p.skip();
+        BOOST_CHECK_EQUAL(p.readBool(), true);
+    }
+
+    // The tags are written as a block with its size in bytes, which is
+    // skipped without reading the strings.
+    std::string encodeWithSizedBlock()
+    {
+        std::ostringstream ostring;
+        OStreamer os(ostring);
+        Writer w(os);
+        w.writeValue(std::string("sized"));
+        w.writeValue(static_cast<int64_t>(1));
+        w.writeValue(0.25);
+        w.writeValue(static_cast<int64_t>(-2));
+        w.writeValue(static_cast<int64_t>(8));
+        w.writeValue(std::string("one"));
+        w.writeValue(std::string("two"));
+        w.writeArrayBlock(1);
+        w.writeValue(std::string("three"));
+        w.writeArrayEnd();
+        w.writeMapEnd();
+        w.writeEnum(0);
+        w.writeFixed(fixeddata);
+        w.writeUnion(0);
+        w.writeValue(true);
+        return ostring.str();
+    }
+
+    void testJson(const GenericValue &value)
+    {
+        std::ostringstream ostring;
+        OStreamer os(ostring);
+        JsonWriter writer(schema_, os);
+        avro::serialize(writer, value);
+
+        std::string json = ostring.str();
+        const std::string head = "{\"name\":\"generic\",\"id\":-1234567890123,\"ratio\":0.25,\"tags\":[\"one\",";
+        const std::string tail = "\"counts\":{\"hits\":42},\"kind\":\"large\",\"digest\":\"\\u0000\\u0001\\u0002\\u0003\\u0004\\u0005\\u0006\\u0007\\b\\t\\n\\u000b\\f\\r\\u000e\\u000f\",\"next\":{\"int\":7},\"flag\":true}\n";
+        BOOST_CHECK_EQUAL(json.substr(0, head.size()), head);
+        BOOST_CHECK_EQUAL(json.substr(json.size() - tail.size()), tail);
+
+        std::istringstream istring(json);
+        IStreamer is(istring);
+        Parser<JsonReader> p(schema_, is);
+        std::string str;
+        p.readRecord();
+        p.readString(str);
+        BOOST_CHECK_EQUAL(str, "generic");
+        BOOST_CHECK_EQUAL(p.readLong(), -1234567890123LL);
+        BOOST_CHECK_EQUAL(p.readDouble(), 0.25);
+        size_t tags = 0;
+        while(p.readArrayBlockSize()) {
+            p.readString(str);
+            ++tags;
+        }
+        BOOST_CHECK_EQUAL(tags, 22U);
+        BOOST_CHECK_EQUAL(p.readMapBlockSize(), 1);
+        p.readString(str);
+        BOOST_CHECK_EQUAL(str, "hits");
+        BOOST_CHECK_EQUAL(p.readInt(), 42);
+        BOOST_CHECK_EQUAL(p.readMapBlockSize(), 0);
+        BOOST_CHECK_EQUAL(p.readEnum(), 1);
+        uint8_t digest[16];
+        p.readFixed(digest);
+        BOOST_CHECK(std::equal(fixeddata, fixeddata + sizeof(fixeddata), digest));
+        BOOST_CHECK_EQUAL(p.readUnion(), 1);
+        BOOST_CHECK_EQUAL(p.readInt(), 7);
+        BOOST_CHECK_EQUAL(p.readBool(), true);
+
+        // fields out of the schema's order are an error
+        std::istringstream bad("{\"id\":1}");
+        IStreamer bis(bad);
+        Parser<JsonReader> bp(schema_, bis);
+        bp.readRecord();
+        BOOST_CHECK_THROW(bp.readString(str), Exception);
+    }
+
+    void testJsonStrings()
+    {
+        UnionSchema u;
+        u.addType(NullSchema());
+        u.addType(ArraySchema(StringSchema()));
+        ValidSchema schema(u);
+
+        const char *strings[] = { "quote\" back\\ tab\t", "caf\xc3\xa9 \xf0\x9d\x84\x9e", "" };
+
+        std::ostringstream ostring;
+        OStreamer os(ostring);
+        Serializer<JsonWriter> s(schema, os);
+        s.writeUnion(1);
+        s.writeArrayBlock(3);
+        for(int i = 0; i < 3; ++i) {
+            s.writeString(strings[i]);
+        }
+        s.writeArrayEnd();
+        s.writeUnion(0);
+        s.writeNull();
+
+        BOOST_CHECK_EQUAL(ostring.str(),
+            "{\"array\":[\"quote\\\" back\\\\ tab\\t\",\"caf\xc3\xa9 \xf0\x9d\x84\x9e\",\"\"]}\nnull\n");
+
+        // escaped surrogate pairs and whitespace are read as well
+        std::istringstream istring(ostring.str() + " { \"array\" : [ \"\\ud834\\udd1e\" ] } ");
+        IStreamer is(istring);
+        Parser<JsonReader> p(schema, is);
+        std::string str;
+        BOOST_CHECK_EQUAL(p.readUnion(), 1);
+        for(int i = 0; i < 3; ++i) {
+            BOOST_CHECK_EQUAL(p.readArrayBlockSize(), 1);
+            p.readString(str);
+            BOOST_CHECK_EQUAL(str, strings[i]);
+        }
+        BOOST_CHECK_EQUAL(p.readArrayBlockSize(), 0);
+        BOOST_CHECK_EQUAL(p.readUnion(), 0);
+        p.readNull();
+        BOOST_CHECK_EQUAL(p.readUnion(), 1);
+        BOOST_CHECK_EQUAL(p.readArrayBlockSize(), 1);
+        p.readString(str);
+        BOOST_CHECK_EQUAL(str, "\xf0\x9d\x84\x9e");
+        BOOST_CHECK_EQUAL(p.readArrayBlockSize(), 0);
+    }
+
+    // counts and lengths read from the data cannot claim more than it holds
+    void testHostile()
+    {
+        const char *schemas[] = {
+            "{\"type\":\"array\",\"items\":\"long\"}",
+            "{\"type\":\"map\",\"values\":\"null\"}",
+            "\"bytes\""
+        };
+        const uint8_t huge[] = { 0xfe, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f, 0x00, 0x00 };
+        const uint8_t lowest[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01 };
+
+        for(int i = 0; i < 3; ++i) {
+            ValidSchema schema;
+            compileJsonSchema(schemas[i], strlen(schemas[i]), schema);
+            Arena arena(256);
+            {
+                MemoryStreamer in(huge, sizeof(huge));
+                GenericReader reader(schema, in);
+                BOOST_CHECK_THROW(reader.read(arena), Exception);
+            }
+            {
+                MemoryStreamer in(lowest, sizeof(lowest));
+                GenericReader reader(schema, in);
+                BOOST_CHECK_THROW(reader.read(arena), Exception);
+            }
+            BOOST_CHECK(arena.capacity() < 4096);
+        }
+
+        Arena arena;
+        BOOST_CHECK_THROW(arena.allocate<GenericValue>(static_cast<size_t>(-1) / 4), Exception);
+    }
+
+    void testJsonReader()
+    {
+        RecordSchema record("reader");
+        record.addField("count", LongSchema());
+        record.addField("data", BytesSchema());
+        record.addField("text", StringSchema());
+        record.addField("empty", FixedSchema(0, "empty"));
+        ValidSchema schema(record);
+
+        // a string longer than the read-ahead buffer crosses several refills
+        std::string longText(10000, 'x');
+        longText[5000] = '"';
+        std::string json = "{\"count\":17,\"data\":\"ab\\u00ff\",\"text\":\"" +
+            longText.substr(0, 5000) + "\\\"" + longText.substr(5001) + "\",\"empty\":\"\"}";
+
+        MemoryStreamer in(reinterpret_cast<const uint8_t *>(json.data()), json.size());
+        JsonReader reader(schema, in);
+        reader.readRecord();
+        // the same promotions the writer accepts
+        int32_t count = 0;
+        reader.readValue(count);
+        BOOST_CHECK_EQUAL(count, 17);
+        std::string str;
+        reader.readValue(str);
+        BOOST_CHECK_EQUAL(str, "ab\xff");
+        reader.readValue(str);
+        BOOST_CHECK(str == longText);
+        uint8_t empty[1];
+        reader.readFixed(empty, 0);
+    }
+
+    void test()
+    {
+        std::cout << "TestGeneric\n";
+
+        std::ostringstream ostring;
+        OStreamer os(ostring);
+        serialize(os);
+        std::string encoded = ostring.str();
+
+        Arena arena(256);
+        size_t capacity = 0;
+        for(int pass = 0; pass < 2; ++pass) {
+            std::istringstream istring(encoded);
+            IStreamer is(istring);
+            GenericReader reader(schema_, is);
+            const GenericValue &value = reader.read(arena);
+            check(value);
+
+            std::ostringstream rstring;
+            OStreamer ros(rstring);
+            ValidatingWriter writer(schema_, ros);
+            avro::serialize(writer, value);
+
+            // without validation the encoding is the same
+            std::ostringstream pstring;
+            {
+                OStreamer pos(pstring);
+                Writer plain(pos);
+                avro::serialize(plain, value);
+            }
+            BOOST_CHECK(pstring.str() == rstring.str());
+
+            // the array is written back as a single block
+            std::istringstream ristring(rstring.str());
+            IStreamer ris(ristring);
+            GenericReader rereader(schema_, ris);
+            check(rereader.read(arena));
+
+            if(pass == 0) {
+                capacity = arena.capacity();
+            }
+            else {
+                BOOST_CHECK_EQUAL(arena.capacity(), capacity);
+            }
+            arena.reset();
+        }
+
+        testSkip(encoded);
+        testSkip(encodeWithSizedBlock());
+
+        std::istringstream istring(encoded);
+        IStreamer is(istring);
+        GenericReader reader(schema_, is);
+        testJson(reader.read(arena));
+        testJsonStrings();
+        testJsonReader();
+        testHostile();
+    }
+
+    ValidSchema schema_;
+};
+
 template<typename T>
 void addTestCase(boost::unit_test::test_suite &test) 
 {
@@ -792,7 +1917,12 @@ init_unit_test_suite( int argc, char* argv[] )
     addTestCase<TestNested>(*test);
     addTestCase<TestGenerated>(*test);
     addTestCase<TestBadStuff>(*test);
+    addTestCase<TestCompiler>(*test);
+    addTestCase<TestRegistry>(*test);
+    addTestCase<TestInterner>(*test);
     addTestCase<TestResolution>(*test);
+    addTestCase<TestTranscoder>(*test);
+    addTestCase<TestGeneric>(*test);
 
     return test;
 }
@@ -141,6 +141,8 @@ int avro_schema_from_json(const char *jsontext,
 			  const int32_t len,
 			  avro_schema_t * schema, avro_schema_error_t * error);
 int avro_schema_to_json(avro_schema_t schema, avro_writer_t out);
+int avro_schema_to_canonical(avro_schema_t schema, avro_writer_t out);
+int avro_schema_fingerprint64(avro_schema_t schema, uint64_t * fingerprint);
 
 int avro_schema_to_specific(avro_schema_t schema, const char *prefix);
 
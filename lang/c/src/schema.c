@@ -1213,3 +1213,184 @@ int avro_schema_to_json(avro_schema_t schema, avro_writer_t out)
 	}
 	return EINVAL;
 }
+
+/*
+ * Parsing Canonical Form keeps only the attributes that affect parsing, in
+ * the order the specification gives, with full names and no whitespace.
+ * The form is either written to a writer or, when there is no writer,
+ * folded straight into a CRC-64-AVRO fingerprint so that fingerprinting
+ * needs no buffer.
+ */
+#define CRC64_AVRO_EMPTY 0xc15d213aa4d7a795ULL
+
+struct canonical_sink {
+	avro_writer_t out;
+	uint64_t fingerprint;
+};
+
+static int sink_str(struct canonical_sink *sink, const char *str)
+{
+	int i;
+
+	if (sink->out) {
+		return avro_write(sink->out, (char *)str, strlen(str));
+	}
+	for (; *str; str++) {
+		sink->fingerprint ^= (uint8_t) * str;
+		for (i = 0; i < 8; i++) {
+			sink->fingerprint =
+			    (sink->fingerprint >> 1) ^ (CRC64_AVRO_EMPTY &
+							-(sink->fingerprint & 1));
+		}
+	}
+	return 0;
+}
+
+static int sink_fullname(struct canonical_sink *sink, avro_schema_t schema)
+{
+	int rval;
+	check(rval, sink_str(sink, "\""));
+	if (is_avro_record(schema) && avro_schema_to_record(schema)->space) {
+		check(rval,
+		      sink_str(sink, avro_schema_to_record(schema)->space));
+		check(rval, sink_str(sink, "."));
+	}
+	check(rval, sink_str(sink, avro_schema_name(schema)));
+	return sink_str(sink, "\"");
+}
+
+static int canonical(struct canonical_sink *sink, avro_schema_t schema)
+{
+	int rval;
+	long i;
+	char size[32];
+	union {
+		st_data_t data;
+		struct avro_record_field_t *field;
+		char *sym;
+		avro_schema_t schema;
+	} val;
+
+	switch (avro_typeof(schema)) {
+	case AVRO_STRING:
+		return sink_str(sink, "\"string\"");
+	case AVRO_BYTES:
+		return sink_str(sink, "\"bytes\"");
+	case AVRO_INT32:
+		return sink_str(sink, "\"int\"");
+	case AVRO_INT64:
+		return sink_str(sink, "\"long\"");
+	case AVRO_FLOAT:
+		return sink_str(sink, "\"float\"");
+	case AVRO_DOUBLE:
+		return sink_str(sink, "\"double\"");
+	case AVRO_BOOLEAN:
+		return sink_str(sink, "\"boolean\"");
+	case AVRO_NULL:
+		return sink_str(sink, "\"null\"");
+	case AVRO_RECORD:
+		{
+			struct avro_record_schema_t *record =
+			    avro_schema_to_record(schema);
+			check(rval, sink_str(sink, "{\"name\":"));
+			check(rval, sink_fullname(sink, schema));
+			check(rval,
+			      sink_str(sink, ",\"type\":\"record\",\"fields\":["));
+			for (i = 0; i < record->fields->num_entries; i++) {
+				st_lookup(record->fields, i, &val.data);
+				if (i) {
+					check(rval, sink_str(sink, ","));
+				}
+				check(rval, sink_str(sink, "{\"name\":\""));
+				check(rval,
+				      sink_str(sink,
+					       avro_atom_to_string(val.field->
+								   name)));
+				check(rval, sink_str(sink, "\",\"type\":"));
+				check(rval, canonical(sink, val.field->type));
+				check(rval, sink_str(sink, "}"));
+			}
+			return sink_str(sink, "]}");
+		}
+	case AVRO_ENUM:
+		{
+			struct avro_enum_schema_t *enump =
+			    avro_schema_to_enum(schema);
+			check(rval, sink_str(sink, "{\"name\":"));
+			check(rval, sink_fullname(sink, schema));
+			check(rval,
+			      sink_str(sink, ",\"type\":\"enum\",\"symbols\":["));
+			for (i = 0; i < enump->symbols->num_entries; i++) {
+				st_lookup(enump->symbols, i, &val.data);
+				if (i) {
+					check(rval, sink_str(sink, ","));
+				}
+				check(rval, sink_str(sink, "\""));
+				check(rval, sink_str(sink, val.sym));
+				check(rval, sink_str(sink, "\""));
+			}
+			return sink_str(sink, "]}");
+		}
+	case AVRO_FIXED:
+		check(rval, sink_str(sink, "{\"name\":"));
+		check(rval, sink_fullname(sink, schema));
+		check(rval, sink_str(sink, ",\"type\":\"fixed\",\"size\":"));
+		snprintf(size, sizeof(size), "%lld",
+			 (long long)avro_schema_to_fixed(schema)->size);
+		check(rval, sink_str(sink, size));
+		return sink_str(sink, "}");
+	case AVRO_MAP:
+		check(rval, sink_str(sink, "{\"type\":\"map\",\"values\":"));
+		check(rval, canonical(sink, avro_schema_to_map(schema)->values));
+		return sink_str(sink, "}");
+	case AVRO_ARRAY:
+		check(rval, sink_str(sink, "{\"type\":\"array\",\"items\":"));
+		check(rval,
+		      canonical(sink, avro_schema_to_array(schema)->items));
+		return sink_str(sink, "}");
+	case AVRO_UNION:
+		{
+			struct avro_union_schema_t *unionp =
+			    avro_schema_to_union(schema);
+			check(rval, sink_str(sink, "["));
+			for (i = 0; i < unionp->branches->num_entries; i++) {
+				st_lookup(unionp->branches, i, &val.data);
+				if (i) {
+					check(rval, sink_str(sink, ","));
+				}
+				check(rval, canonical(sink, val.schema));
+			}
+			return sink_str(sink, "]");
+		}
+	case AVRO_LINK:
+		return sink_fullname(sink, avro_schema_to_link(schema)->to);
+	}
+	return EINVAL;
+}
+
+int avro_schema_to_canonical(avro_schema_t schema, avro_writer_t out)
+{
+	struct canonical_sink sink;
+
+	if (!is_avro_schema(schema) || !out) {
+		return EINVAL;
+	}
+	sink.out = out;
+	sink.fingerprint = CRC64_AVRO_EMPTY;
+	return canonical(&sink, schema);
+}
+
+int avro_schema_fingerprint64(avro_schema_t schema, uint64_t * fingerprint)
+{
+	int rval;
+	struct canonical_sink sink;
+
+	if (!is_avro_schema(schema) || !fingerprint) {
+		return EINVAL;
+	}
+	sink.out = NULL;
+	sink.fingerprint = CRC64_AVRO_EMPTY;
+	check(rval, canonical(&sink, schema));
+	*fingerprint = sink.fingerprint;
+	return 0;
+}
@@ -16,6 +16,7 @@
  */
 
 #include "avro_private.h"
+#include "../dir_iterator.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 int test_cases = 0;
 avro_writer_t avro_stderr;
@@ -101,6 +102,46 @@ static void run_tests(char *dirpath, int should_pass)
     }
 }
 
+static void test_canonical_form(void)
+{
+	char buf[256];
+	const char *expected =
+	    "{\"name\":\"org.example.list\",\"type\":\"record\",\"fields\":["
+	    "{\"name\":\"value\",\"type\":\"long\"},"
+	    "{\"name\":\"next\",\"type\":[\"null\",\"org.example.list\"]}]}";
+	uint64_t fingerprint;
+	avro_writer_t writer;
+	avro_schema_t schema = avro_schema_int();
+	avro_schema_t next = avro_schema_union();
+
+	/*
+	 * The example in the specification 
+	 */
+	if (avro_schema_fingerprint64(schema, &fingerprint)
+	    || fingerprint != 8247732601305521295ULL) {
+		fprintf(stderr, "fail! wrong fingerprint for \"int\"\n");
+		exit(EXIT_FAILURE);
+	}
+	avro_schema_decref(schema);
+
+	schema = avro_schema_record("list", "org.example");
+	avro_schema_union_append(next, avro_schema_null());
+	avro_schema_union_append(next, avro_schema_link(schema));
+	avro_schema_record_field_append(schema, "value", avro_schema_long());
+	avro_schema_record_field_append(schema, "next", next);
+
+	writer = avro_writer_memory(buf, sizeof(buf));
+	if (avro_schema_to_canonical(schema, writer)
+	    || avro_writer_tell(writer) != (int64_t) strlen(expected)
+	    || memcmp(buf, expected, strlen(expected))) {
+		fprintf(stderr, "fail! wrong canonical form\n");
+		exit(EXIT_FAILURE);
+	}
+	avro_writer_free(writer);
+	avro_schema_decref(schema);
+	test_cases++;
+}
+
 int main(int argc, char *argv[])
 {
 	char *srcdir = getenv("srcdir");
@@ -127,6 +168,8 @@ int main(int argc, char *argv[])
 	fprintf(stderr, "RUNNING %s\n", path);
 	run_tests(path, 0);
 
+	test_canonical_form();
+
 	fprintf(stderr, "==================================================\n");
 	fprintf(stderr,
 		"Finished running %d schema test cases successfully \n",